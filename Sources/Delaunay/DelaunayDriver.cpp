@@ -7,6 +7,7 @@
 #include <netcdfcpp.h>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
 
 using std::setw;
 using std::ofstream;
@@ -20,6 +21,8 @@ DelaunayDriver::DelaunayDriver()
     DT.setName("Delaunay triangles");
     obsoleteDT.setName("Obsolete Delaunay triangles");
     temporalDT.setName("Temporal Delaunay triangles");
+    maxWalkStep = 50;
+    insertMode = ConflictListMode;
     REPORT_ONLINE("DelaunayDriver")
 }
 
@@ -31,6 +34,9 @@ DelaunayDriver::~DelaunayDriver()
 void DelaunayDriver::init(const PointManager &pointManager)
 {
     DVT.create(pointManager.points.size());
+    // Note: The driver may be reused with fewer points (e.g. multilevel SCVT).
+    while (DVT.size() > pointManager.points.size())
+        DVT.remove(DVT.back());
     PointPointer *point = pointManager.points.front();
     DelaunayVertex *DVT = this->DVT.front();
     for (int i = 0; i < pointManager.points.size(); ++i) {
@@ -59,13 +65,56 @@ void DelaunayDriver::run()
 
     getThreeRandomIndices(idx);
     initDelaunayTriangle(idx);
-    initPIT();
-    insertRestPoints();
+    if (insertMode == ConflictListMode) {
+        initPIT();
+        insertRestPoints();
+    } else
+        insertRestPointsByWalk();
     extractTopology();
     deleteFake();
     DT.reindex();
 }
 
+bool DelaunayDriver::moveVertices(const double lon[], const double lat[])
+{
+    // -------------------------------------------------------------------------
+    // 1. Move the vertices in place as many as possible, and restore the
+    //    empty-circumcircle rule, so the rest ones are deleted and inserted in
+    //    a Delaunay triangulation
+    vector<DelaunayVertex *> restDVT;
+    vector<int> restIdx;
+    DelaunayVertex *DVT = this->DVT.front();
+    for (int i = 0; i < this->DVT.size(); ++i) {
+        Coordinate x;
+        x.setSPH(lon[i], lat[i]);
+        if (!moveDVT(DVT, x)) {
+            restDVT.push_back(DVT);
+            restIdx.push_back(i);
+        }
+        DVT = DVT->next;
+    }
+    restoreDelaunay();
+    // -------------------------------------------------------------------------
+    // 2. Relocate the rest vertices, or rebuild the triangulation when any of
+    //    them moves too far
+    for (int i = 0; i < static_cast<int>(restDVT.size()); ++i) {
+        Coordinate x;
+        x.setSPH(lon[restIdx[i]], lat[restIdx[i]]);
+        if (!relocateDVT(restDVT[i], x)) {
+            DVT = this->DVT.front();
+            for (int j = 0; j < this->DVT.size(); ++j) {
+                DVT->point->setCoordinate(lon[j], lat[j]);
+                DVT = DVT->next;
+            }
+            reinit();
+            run();
+            return false;
+        }
+    }
+    DT.reindex();
+    return true;
+}
+
 void DelaunayDriver::calcCircumcenter()
 {
     DelaunayTriangle *DT = this->DT.front();
@@ -214,29 +263,7 @@ void DelaunayDriver::initPIT()
                 ret = -(ret+1);
                 DelaunayVertex *DVT1 = DT->DVT[ret];
                 if (DVT1->getID() < 0) {
-                    // The vertex is fake
-                    DVT1->topology.extract();
-                    // Record the first incident triangle
-                    DVT->topology.incidentDT.append();
-                    DVT->topology.incidentDT.front()->ptr = 
-                        DVT1->topology.incidentDT.front()->ptr;
-                    // Replace the fake vertex with the real one
-                    DelaunayTrianglePointer *DTptr;
-                    DTptr = DVT1->topology.incidentDT.front();
-                    for (int k = 0; k < DVT1->topology.incidentDT.size(); ++k) {
-                        int l;
-                        for (l = 0; l < 3; ++l)
-                            if (DTptr->ptr->DVT[l] == DVT1) break;
-                        DTptr->ptr->DVT[l] = DVT;
-                        DTptr = DTptr->next;
-                    }
-                    DVT->inserted = true;
-                    // Delete the fake vertex
-                    for (int i = 0; i < fake.num; ++i)
-                        if (DVT1 == &(fake.DVT[i])) {
-                            fake.erase(i);
-                            break;
-                        }
+                    replaceFakeDVT(DVT1, DVT);
                     break;
                 } else
                     REPORT_ERROR("Encounter coincided vertices.");
@@ -264,6 +291,164 @@ void DelaunayDriver::insertRestPoints()
     } 
 }
 
+void DelaunayDriver::replaceFakeDVT(DelaunayVertex *fakeDVT,
+                                    DelaunayVertex *DVT)
+{
+    fakeDVT->topology.extract();
+    // Record the first incident triangle
+    DVT->topology.incidentDT.append();
+    DVT->topology.incidentDT.front()->ptr =
+        fakeDVT->topology.incidentDT.front()->ptr;
+    // Replace the fake vertex with the real one
+    DelaunayTrianglePointer *DTptr;
+    DTptr = fakeDVT->topology.incidentDT.front();
+    for (int k = 0; k < fakeDVT->topology.incidentDT.size(); ++k) {
+        int l;
+        for (l = 0; l < 3; ++l)
+            if (DTptr->ptr->DVT[l] == fakeDVT) break;
+        DTptr->ptr->DVT[l] = DVT;
+        DTptr = DTptr->next;
+    }
+    DVT->inserted = true;
+    // Delete the fake vertex
+    for (int i = 0; i < fake.num; ++i)
+        if (fakeDVT == &(fake.DVT[i])) {
+            fake.erase(i);
+            break;
+        }
+}
+
+/*
+ * Function:
+ *   getHilbertIndex
+ * Purpose:
+ *   Return the index of the cell (x,y) along the Hilbert curve that fills a
+ *   2^order x 2^order grid.
+ */
+static unsigned long getHilbertIndex(unsigned int x, unsigned int y, int order)
+{
+    unsigned int n = 1u << order;
+    unsigned long d = 0;
+    for (unsigned int s = n >> 1; s > 0; s >>= 1) {
+        unsigned int rx = (x & s) > 0;
+        unsigned int ry = (y & s) > 0;
+        d += static_cast<unsigned long>(s)*s*((3*rx)^ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n-1-x;
+                y = n-1-y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+struct HilbertOrder {
+    bool operator()(const std::pair<unsigned long, DelaunayVertex *> &a,
+                    const std::pair<unsigned long, DelaunayVertex *> &b) const {
+        return a.first < b.first;
+    }
+};
+
+struct RandomIndex {
+    int operator()(int n) { return RandomNumber::getRandomNumber(0, n); }
+};
+
+void DelaunayDriver::getBRIOOrder(vector<DelaunayVertex *> &order)
+{
+    // -------------------------------------------------------------------------
+    // 1. Shuffle the uninserted vertices with their Hilbert indices, where the
+    //    curve is laid on the equal-area (lon,sin(lat)) plane
+    static const int hilbertOrder = 16;
+    static const double scale = (1u << hilbertOrder)-1;
+    vector<std::pair<unsigned long, DelaunayVertex *> > keys;
+    keys.reserve(this->DVT.size());
+    DelaunayVertex *DVT = this->DVT.front();
+    for (int i = 0; i < this->DVT.size(); ++i) {
+        if (!DVT->inserted) {
+            const Coordinate &x = DVT->point->getCoordinate();
+            unsigned int ix = static_cast<unsigned int>(x.getLon()/PI2*scale);
+            unsigned int iy = static_cast<unsigned int>((x.getZ()+1.0)*0.5*scale);
+            keys.push_back(std::make_pair(getHilbertIndex(ix, iy, hilbertOrder),
+                                          DVT));
+        }
+        DVT = DVT->next;
+    }
+    RandomIndex randomIndex;
+    std::random_shuffle(keys.begin(), keys.end(), randomIndex);
+    // -------------------------------------------------------------------------
+    // 2. Divide the vertices into rounds, each of which is half of the rest,
+    //    and sort each round along the Hilbert curve
+    static const int minRoundSize = 64;
+    int end = static_cast<int>(keys.size());
+    while (end > minRoundSize) {
+        int begin = end/2;
+        std::sort(keys.begin()+begin, keys.begin()+end, HilbertOrder());
+        end = begin;
+    }
+    std::sort(keys.begin(), keys.begin()+end, HilbertOrder());
+    order.resize(keys.size());
+    for (int i = 0; i < static_cast<int>(keys.size()); ++i)
+        order[i] = keys[i].second;
+}
+
+void DelaunayDriver::insertRestPointsByWalk()
+{
+    vector<DelaunayVertex *> order;
+    getBRIOOrder(order);
+    DelaunayTriangle *DT = this->DT.front();
+    for (int i = 0; i < static_cast<int>(order.size()); ++i) {
+        DelaunayVertex *point = order[i];
+        // ---------------------------------------------------------------------
+        // 1. Walk from the triangle of the last inserted point, which is close
+        //    to this one in BRIO order, and record the edges that the point
+        //    is on
+        int numOnEdge, onEdge[3];
+        while (true) {
+            int j;
+            numOnEdge = 0;
+            for (j = 0; j < 3; ++j) {
+                int ret = Sphere::orient(DT->DVT[ip1[j]]->point,
+                                         DT->DVT[im1[j]]->point,
+                                         point->point);
+                if (ret == OrientRight) {
+                    DT = DT->adjDT[j];
+                    break;
+                } else if (ret == OrientOn)
+                    onEdge[numOnEdge++] = j;
+            }
+            if (j == 3) break;
+        }
+        // ---------------------------------------------------------------------
+        // 2. Insert the point in the same way as the conflict-list mode
+        if (numOnEdge == 0) { // inside triangle
+            flip13(DT, point);
+            obsoleteDT.append();
+            obsoleteDT.back()->ptr = DT;
+        } else if (numOnEdge == 1) { // on some edge of a triangle
+            point->pit.edgeIdx = onEdge[0];
+            DelaunayTriangle *adjDT = DT->adjDT[onEdge[0]];
+            flip24(DT, adjDT, point);
+            obsoleteDT.append();
+            obsoleteDT.back()->ptr = DT;
+            obsoleteDT.append();
+            obsoleteDT.back()->ptr = adjDT;
+        } else {
+            // Point coincides with the vertex shared by the two edges
+            DelaunayVertex *DVT1 = DT->DVT[3-onEdge[0]-onEdge[1]];
+            if (DVT1->getID() < 0)
+                replaceFakeDVT(DVT1, point);
+            else
+                REPORT_ERROR("Encounter coincided vertices.");
+        }
+        point->inserted = true;
+        deleteObsoleteDT();
+        deleteTemporalDT();
+        DT = point->topology.incidentDT.front()->ptr;
+    }
+}
+
 void DelaunayDriver::insertPoint(DelaunayVertex *point)
 {
     if (point->pit.DT[1] == NULL) {
@@ -289,7 +474,7 @@ void DelaunayDriver::updatePIT()
 {
     DelaunayTrianglePointer *DT = obsoleteDT.front();
     for (int i = 0; i < obsoleteDT.size(); ++i) {
-        while (DT->ptr->tip.points->size() != 0)
+        while (DT->ptr->tip.hasPoints())
             if (!DT->ptr->tip.handover(DT->ptr->tip.points->front()->ptr))
                 REPORT_ERROR("Point hasn't been handed over!");
         DT = DT->next;
@@ -398,6 +583,159 @@ void DelaunayDriver::deleteDVT(DelaunayVertex *DVT)
     DT.remove(DT3);
 }
 
+bool DelaunayDriver::moveDVT(DelaunayVertex *DVT, const Coordinate &x)
+{
+    // Note: The vertex can be moved in place when all its incident triangles
+    //       keep their orientations, so the triangulation is still valid.
+    DelaunayVertexPointer *DVTptr = DVT->topology.linkDVT.front();
+    for (int i = 0; i < DVT->topology.linkDVT.size(); ++i) {
+        if (Sphere::orient(DVTptr->ptr->point->getCoordinate(),
+                           DVTptr->next->ptr->point->getCoordinate(),
+                           x) != OrientLeft)
+            return false;
+        DVTptr = DVTptr->next;
+    }
+    DVT->point->setCoordinate(x);
+    return true;
+}
+
+bool DelaunayDriver::relocateDVT(DelaunayVertex *DVT, const Coordinate &x)
+{
+    // -------------------------------------------------------------------------
+    // 1. Delete the vertex at its old place
+    DelaunayVertex *linkDVT = DVT->topology.linkDVT.front()->ptr;
+    deleteDVT(DVT);
+    DVT->topology.reinit();
+    DVT->point->setCoordinate(x);
+    // -------------------------------------------------------------------------
+    // 2. Walk from the old place to the triangle that contains the new one
+    DelaunayTriangle *DT = linkDVT->topology.incidentDT.front()->ptr;
+    int numStep = 0;
+    while (true) {
+        bool isCrossed = false, isOnEdge = false;
+        for (int i = 0; i < 3; ++i) {
+            OrientStatus ret = Sphere::orient(DT->DVT[ip1[i]]->point,
+                                              DT->DVT[im1[i]]->point,
+                                              DVT->point);
+            if (ret == OrientRight) {
+                DT = DT->adjDT[i];
+                isCrossed = true;
+                break;
+            } else if (ret == OrientOn)
+                isOnEdge = true;
+        }
+        if (!isCrossed) {
+            // Note: The degenerate case is left to the full triangulation.
+            if (isOnEdge)
+                return false;
+            break;
+        }
+        if (++numStep > maxWalkStep)
+            return false;
+    }
+    // -------------------------------------------------------------------------
+    // 3. Insert the vertex at its new place
+    insertDVT(DT, DVT);
+    return true;
+}
+
+void DelaunayDriver::insertDVT(DelaunayTriangle *oldDT, DelaunayVertex *point)
+{
+    // -------------------------------------------------------------------------
+    // 0. Make short-hand
+    DelaunayVertex *DVT[3];
+    for (int i = 0; i < 3; ++i)
+        DVT[i] = oldDT->DVT[i];
+    DelaunayTriangle *adjDT[3];
+    adjDT[0] = oldDT->adjDT[2];
+    adjDT[1] = oldDT->adjDT[0];
+    adjDT[2] = oldDT->adjDT[1];
+    // -------------------------------------------------------------------------
+    // 1. Subdivide the old triangle into three new ones in the same way as
+    //    flip13
+    DelaunayTriangle *newDT[3];
+    for (int i = 0; i < 3; ++i)
+        this->DT.append(&newDT[i]);
+    for (int i = 0; i < 3; ++i) {
+        newDT[i]->DVT[0] = DVT[i];
+        newDT[i]->DVT[1] = DVT[ip1[i]];
+        newDT[i]->DVT[2] = point;
+        newDT[i]->adjDT[0] = newDT[ip1[i]];
+        newDT[i]->adjDT[1] = newDT[im1[i]];
+        newDT[i]->adjDT[2] = adjDT[i];
+    }
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            if (adjDT[i]->adjDT[j] == oldDT) {
+                adjDT[i]->adjDT[j] = newDT[i];
+                break;
+            }
+    // -------------------------------------------------------------------------
+    // 2. Maintain the complete topology of the vertices
+    for (int i = 0; i < 3; ++i) {
+        DVT[i]->topology.splitIncidentDT(oldDT, newDT[i], newDT[im1[i]]);
+        DVT[i]->topology.addLinkDVT(DVT[ip1[i]], DVT[im1[i]], point);
+    }
+    for (int i = 0; i < 3; ++i) {
+        point->topology.incidentDT.append();
+        point->topology.incidentDT.back()->ptr = newDT[i];
+        point->topology.linkDVT.append();
+        point->topology.linkDVT.back()->ptr = DVT[i];
+    }
+    point->topology.incidentDT.ring();
+    point->topology.linkDVT.ring();
+    point->topology.isComplete = true;
+    DT.remove(oldDT);
+    // -------------------------------------------------------------------------
+    // 3. Validate the new triangles
+    for (int i = 0; i < 3; ++i)
+        validate(newDT[i]);
+    deleteObsoleteDT();
+    deleteTemporalDT();
+}
+
+void DelaunayDriver::restoreDelaunay()
+{
+    vector<DelaunayTriangle *> uncheckedDT;
+    uncheckedDT.reserve(this->DT.size());
+    DelaunayTriangle *DT = this->DT.front();
+    for (int i = 0; i < this->DT.size(); ++i) {
+        uncheckedDT.push_back(DT);
+        DT = DT->next;
+    }
+    while (!uncheckedDT.empty()) {
+        DT = uncheckedDT.back();
+        uncheckedDT.pop_back();
+        // Note: The triangle may have been flipped away.
+        if (DT->endTag == ListElement<DelaunayTriangle>::Null)
+            continue;
+        for (int i = 0; i < 3; ++i) {
+            DelaunayTriangle *oppositeDT = DT->adjDT[i];
+            int j;
+            for (j = 0; j < 3; ++j)
+                if (oppositeDT->adjDT[j] == DT)
+                    break;
+#ifdef DEBUG
+            if (j == 3)
+                REPORT_ERROR("No matched opposite Delaunay vertex.");
+#endif
+            int ret = Sphere::inCircle(DT->DVT[0]->point, DT->DVT[1]->point,
+                                       DT->DVT[2]->point,
+                                       oppositeDT->DVT[j]->point);
+            if (ret == InsideCircle) {
+                DelaunayTriangle *newDT1, *newDT2;
+                int idxMap[4] = {ip1[i],im1[i],i,j};
+                flip22(DT, oppositeDT, &newDT1, &newDT2, idxMap);
+                this->DT.remove(DT);
+                this->DT.remove(oppositeDT);
+                uncheckedDT.push_back(newDT1);
+                uncheckedDT.push_back(newDT2);
+                break;
+            }
+        }
+    }
+}
+
 void DelaunayDriver::deleteFake()
 {
     for (int i = 0; i < fake.num; ++i)
@@ -769,15 +1107,15 @@ void DelaunayDriver::output(const string &fileName)
     NcDim *numDVTDim = file->add_dim("numDVT", this->DVT.size());
     NcVar *lonDVTVar = file->add_var("lonDVT", ncDouble, numDVTDim);
     NcVar *latDVTVar = file->add_var("latDVT", ncDouble, numDVTDim);
-    double lonDVT[this->DVT.size()], latDVT[this->DVT.size()];
+    vector<double> lonDVT(this->DVT.size()), latDVT(this->DVT.size());
     DelaunayVertex *DVT = this->DVT.front();
     for (int i = 0; i < this->DVT.size(); ++i) {
         lonDVT[i] = DVT->point->getCoordinate().getLon()*Rad2Deg;
         latDVT[i] = DVT->point->getCoordinate().getLat()*Rad2Deg;
         DVT = DVT->next;
     }
-    lonDVTVar->put(lonDVT, this->DVT.size());
-    latDVTVar->put(latDVT, this->DVT.size());
+    lonDVTVar->put(&lonDVT[0], this->DVT.size());
+    latDVTVar->put(&latDVT[0], this->DVT.size());
     // -------------------------------------------------------------------------
     // Output the remaining fake vertices
     bool hasFakeDVT = false;
@@ -790,7 +1128,7 @@ void DelaunayDriver::output(const string &fileName)
         NcDim *numFakeDVTDim = file->add_dim("numFakeDVT", fake.num);
         NcVar *lonFakeDVTVar = file->add_var("lonFakeDVT", ncDouble, numFakeDVTDim);
         NcVar *latFakeDVTVar = file->add_var("latFakeDVT", ncDouble, numFakeDVTDim);
-        double lonFakeDVT[fake.num], latFakeDVT[fake.num];
+        vector<double> lonFakeDVT(fake.num), latFakeDVT(fake.num);
         for (int i = 0; i < fake.num; ++i)
             if (fake.deleted[i]) {
                 lonFakeDVT[i] = -999.0;
@@ -799,21 +1137,21 @@ void DelaunayDriver::output(const string &fileName)
                 lonFakeDVT[i] = fake.DVT[i].point->getCoordinate().getLon()*Rad2Deg;
                 latFakeDVT[i] = fake.DVT[i].point->getCoordinate().getLat()*Rad2Deg;
             }
-        lonFakeDVTVar->put(lonFakeDVT, fake.num);
-        latFakeDVTVar->put(latFakeDVT, fake.num);
+        lonFakeDVTVar->put(&lonFakeDVT[0], fake.num);
+        latFakeDVTVar->put(&latFakeDVT[0], fake.num);
     }
     // -------------------------------------------------------------------------
     NcDim *numDTDim = file->add_dim("numDT", this->DT.size());
     NcDim *threeDim = file->add_dim("three", 3);
     NcVar *idxDVTVar = file->add_var("idxDVT", ncInt, numDTDim, threeDim);
-    int idxDVT[this->DT.size()][3];
+    vector<int> idxDVT(3*this->DT.size());
     DelaunayTriangle *DT = this->DT.front();
     for (int i = 0; i < this->DT.size(); ++i) {
         for (int j = 0; j < 3; ++j)
-            idxDVT[i][j] = DT->DVT[j]->getID();
+            idxDVT[3*i+j] = DT->DVT[j]->getID();
         DT = DT->next;
     }
-    idxDVTVar->put(&idxDVT[0][0], this->DT.size(), 3);
+    idxDVTVar->put(&idxDVT[0], this->DT.size(), 3);
     
     file->close();
     delete file;
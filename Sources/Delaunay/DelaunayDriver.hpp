@@ -6,12 +6,28 @@
 #include "FakeVertices.hpp"
 #include "PointManager.hpp"
 #include <string>
+#include <vector>
 
 using std::string;
+using std::vector;
 
 class DelaunayDriver
 {
 public:
+    /*
+     * The insertion modes of the rest points:
+     *   ConflictListMode - Each uninserted point is recorded in the triangle
+     *                      that includes it, and is handed over when the
+     *                      triangle is flipped.
+     *   BRIOMode         - The points are inserted in biased randomized
+     *                      insertion order (rounds of random points sorted
+     *                      along Hilbert curve), and each one is located by
+     *                      walking from the last inserted one.
+     */
+    enum InsertMode {
+        ConflictListMode, BRIOMode
+    };
+
     DelaunayDriver();
     virtual ~DelaunayDriver();
 
@@ -21,6 +37,27 @@ public:
 
     void run();
 
+    /*
+     * Function:
+     *   moveVertices
+     * Purpose:
+     *   Move the Delaunay vertices to the new coordinates (in the order of
+     *   DVT) and repair the existing triangulation locally instead of
+     *   rebuilding it. The vertices that stay inside their link polygons are
+     *   moved in place, and the empty-circumcircle rule is restored by edge
+     *   flips. The rest vertices are deleted and inserted again at the
+     *   triangles found by walking from their old places. When any walk
+     *   crosses more than maxWalkStep triangles, the triangulation is rebuilt
+     *   from scratch.
+     * Return value:
+     *   True if the triangulation is repaired, false if it is rebuilt.
+     */
+    bool moveVertices(const double lon[], const double lat[]);
+
+    void setMaxWalkStep(int maxWalkStep) { this->maxWalkStep = maxWalkStep; }
+
+    void setInsertMode(InsertMode insertMode) { this->insertMode = insertMode; }
+
     void calcCircumcenter();
 
     void output(const string &);
@@ -75,6 +112,36 @@ protected:
      */
     void insertRestPoints();
 
+    /*
+     * Function:
+     *   getBRIOOrder
+     * Purpose:
+     *   Get the biased randomized insertion order of the uninserted points.
+     * Return value:
+     *   No return value
+     */
+    void getBRIOOrder(vector<DelaunayVertex *> &);
+
+    /*
+     * Function:
+     *   insertRestPointsByWalk
+     * Purpose:
+     *   Insert the rest points in BRIO order without conflict lists.
+     * Return value:
+     *   No return value
+     */
+    void insertRestPointsByWalk();
+
+    /*
+     * Function:
+     *   replaceFakeDVT
+     * Purpose:
+     *   Replace a fake vertex with the real one that coincides with it.
+     * Return value:
+     *   No return value
+     */
+    void replaceFakeDVT(DelaunayVertex *, DelaunayVertex *);
+
     /*
      * Function:
      *   insertPoint
@@ -131,6 +198,49 @@ protected:
      */
     void deleteFake();
     
+    /*
+     * Function:
+     *   moveDVT
+     * Purpose:
+     *   Move one Delaunay vertex in place if it stays inside its link polygon.
+     * Return value:
+     *   True if the vertex is moved.
+     */
+    bool moveDVT(DelaunayVertex *, const Coordinate &);
+
+    /*
+     * Function:
+     *   relocateDVT
+     * Purpose:
+     *   Delete one Delaunay vertex and insert it at the new place in the
+     *   complete Delaunay triangulation.
+     * Return value:
+     *   False if the triangulation needs to be rebuilt.
+     */
+    bool relocateDVT(DelaunayVertex *, const Coordinate &);
+
+    /*
+     * Function:
+     *   insertDVT
+     * Purpose:
+     *   Insert a Delaunay vertex into a triangle of the complete
+     *   triangulation, and maintain the topology of the vertices.
+     * Return value:
+     *   No return value
+     */
+    void insertDVT(DelaunayTriangle *, DelaunayVertex *);
+
+    /*
+     * Function:
+     *   restoreDelaunay
+     * Purpose:
+     *   Flip the edges that violate the empty-circumcircle rule until there
+     *   is none.
+     * Return value:
+     *   No return value
+     */
+    void restoreDelaunay();
+
     void deleteObsoleteDT();
     void deleteTemporalDT();
     void extractTopology();
@@ -138,6 +248,8 @@ protected:
     FakeVertices fake;
     List<DelaunayTrianglePointer> obsoleteDT;
     List<DelaunayTrianglePointer> temporalDT;
+    int maxWalkStep;
+    InsertMode insertMode;
 };
 
 #endif
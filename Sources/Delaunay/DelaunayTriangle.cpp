@@ -24,7 +24,7 @@ void DelaunayTriangle::reinit()
         adjDT[i] = NULL;
         subDT[i] = NULL;
     }
-    tip.points->recycle();
+    tip.reinit();
 }
 
 void DelaunayTriangle::calcCircumcenter()
@@ -36,20 +36,30 @@ void PIT::reinit()
 
 TIP::TIP()
 {
-    points = new List<DelaunayVertexPointer>(10, 10);
-    points->setName("Included points for inserting");
-    reinit();
+    points = NULL;
 }
 
 TIP::~TIP()
 {
-    points->destroy();
-    delete points;
+    if (points != NULL) {
+        points->destroy();
+        delete points;
+    }
 }
 
 void TIP::reinit()
 {
-    points->recycle();
+    if (points != NULL)
+        points->recycle();
+}
+
+List<DelaunayVertexPointer> *TIP::getPoints()
+{
+    if (points == NULL) {
+        points = new List<DelaunayVertexPointer>(0, 4);
+        points->setName("Included points for inserting");
+    }
+    return points;
 }
 
 bool TIP::handover(DelaunayVertex *point)
@@ -108,7 +118,7 @@ void PointTriangle::recordPoint(DelaunayVertex *DVT, DelaunayTriangle *DT)
 {
     DVT->pit.DT[0] = DT;
     DVT->pit.DT[1] = NULL;
-    DT->tip.points->append();
+    DT->tip.getPoints()->append();
     DT->tip.points->back()->ptr = DVT;
     DVT->pit.stub[0] = DT->tip.points->back();
     DVT->pit.stub[1] = NULL;
@@ -119,9 +129,9 @@ void PointTriangle::recordPoint(DelaunayVertex *DVT, DelaunayTriangle *DT1,
 {
     DVT->pit.DT[0] = DT1;
     DVT->pit.DT[1] = DT2;
-    DT1->tip.points->append();
+    DT1->tip.getPoints()->append();
     DT1->tip.points->back()->ptr = DVT;
-    DT2->tip.points->append();
+    DT2->tip.getPoints()->append();
     DT2->tip.points->back()->ptr = DVT;
     DVT->pit.stub[0] = DT1->tip.points->back();
     DVT->pit.stub[1] = DT2->tip.points->back();
@@ -131,12 +141,12 @@ void PointTriangle::recordPoint(DelaunayVertex *DVT, DelaunayTriangle *DT1,
 void PointTriangle::removePoint(DelaunayVertex *DVT)
 {
     if (DVT->pit.DT[0] != NULL) {
-        DVT->pit.DT[0]->tip.points->erase(DVT->pit.stub[0]);
+        DVT->pit.DT[0]->tip.points->remove(DVT->pit.stub[0]);
         DVT->pit.stub[0] = NULL;
         DVT->pit.DT[0] = NULL;
     }
     if (DVT->pit.DT[1] != NULL) {
-        DVT->pit.DT[1]->tip.points->erase(DVT->pit.stub[1]);
+        DVT->pit.DT[1]->tip.points->remove(DVT->pit.stub[1]);
         DVT->pit.stub[1] = NULL;
         DVT->pit.DT[1] = NULL;
     }
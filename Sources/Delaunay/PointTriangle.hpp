@@ -66,8 +66,13 @@ public:
     
     void reinit();
     bool handover(DelaunayVertex *);
-    
+
+    bool hasPoints() const { return points != NULL && points->size() != 0; }
+    List<DelaunayVertexPointer> *getPoints();
+
     DelaunayTriangle *DT;
+    // Note: The list is created when the first point is recorded, so the
+    //       triangles do not take any memory for the points in walk mode.
     List<DelaunayVertexPointer> *points;
 };
     
@@ -34,6 +34,7 @@ public:
               Second dt, const Location &loc) const;
 
     void resetPointCounter() { pointCounter.reset(); }
+    const PointCounter &getPointCounter() const { return pointCounter; }
     int getNumSubLon() { return pointCounter.numSubLon; }
     int getNumSubLat() { return pointCounter.numSubLat; }
 
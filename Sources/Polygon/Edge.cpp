@@ -9,6 +9,7 @@
 #include "PotentialCrossDetector.hpp"
 #include "TTS.hpp"
 #include "CommonTasks.hpp"
+#include "SweptEdgeDetector.hpp"
 
 using namespace PotentialCrossDetector;
 #endif
@@ -19,6 +20,8 @@ Edge::Edge()
 #ifdef TTS_ONLINE
     testPoint.setHostEdge(this);
     detectAgent.checkin(this);
+    taskStamp = -1;
+    sweptStamp = -1;
 #endif
     normVector.init();
     reinit();
@@ -82,6 +85,10 @@ void Edge::linkEndPoint(PointOrder order, Vertex *point, bool isSetTestPoint)
         testPoint.setCoordinate(x, NewTimeLevel);
     }
 #endif
+#ifdef TTS_ONLINE
+    if (endPoints[0] != NULL && endPoints[1] != NULL)
+        SweptEdgeDetector::recordEdge(this);
+#endif
 }
 
 void Edge::changeEndPoint(PointOrder order, Vertex *point)
@@ -265,6 +272,9 @@ void Edge::dump(int indentLevel) const
 EdgePointer::EdgePointer()
 {
     angle.init();
+#ifdef TTS_ONLINE
+    taskStamp = -1;
+#endif
     reinit();
 }
 
@@ -66,6 +66,8 @@ public:
 #ifdef TTS_ONLINE
     ApproachDetector::EdgeAgent detectAgent;
     EdgeTags tags;
+    int taskStamp; // slot in CommonTasks (see StampedQueue)
+    int sweptStamp; // slot in SweptEdgeDetector
 #endif
 
 private:
@@ -117,6 +119,9 @@ public:
     OrientStatus orient;
     MultiTimeLevel<double, 2> angle;
     bool isAngleSet;
+#ifdef TTS_ONLINE
+    int taskStamp; // slot in CommonTasks (see StampedQueue)
+#endif
 };
 
 #endif
@@ -6,6 +6,7 @@
 #ifdef TTS_ONLINE
 #include "TTS.hpp"
 #include "CommonTasks.hpp"
+#include "ConservationMonitor.hpp"
 #ifdef DEBUG
 #include "DebugTools.hpp"
 #endif
@@ -14,6 +15,9 @@
 
 Polygon::Polygon()
 {
+#ifdef TTS_ONLINE
+    tracerSlot = TracerBuffer::acquireSlot();
+#endif
     area.init();
     reinit();
 }
@@ -21,14 +25,16 @@ Polygon::Polygon()
 Polygon::~Polygon()
 {
     edgePointers.destroy();
+#ifdef TTS_ONLINE
+    TracerBuffer::releaseSlot(tracerSlot);
+#endif
 }
 
 void Polygon::reinit()
 {
     edgePointers.recycle();
 #ifdef TTS_ONLINE
-    for (int i = 0; i < tracers.size(); ++i)
-        tracers[i].reinit();
+    TracerBuffer::clearSlot(tracerSlot);
 #endif
     areaSet = false;
 }
@@ -105,19 +111,19 @@ void Polygon::calcArea()
 #ifdef TTS_ONLINE
 void Polygon::updateTracer(int tracerId)
 {
-    tracers[tracerId].setDensity(tracers[tracerId].getMass()/area.getNew());
+    TracerBuffer::setDensity(tracerId, tracerSlot,
+                             getTracerMass(tracerId)/area.getNew());
 }
 
 void Polygon::updateTracers()
 {
-    for (int i = 0; i < tracers.size(); ++i) {
-        tracers[i].setDensity(tracers[i].getMass()/area.getNew());
-    }
+    for (int i = 0; i < TracerBuffer::getNumTracer(); ++i)
+        updateTracer(i);
 }
 
 void Polygon::handoverTracers()
 {
-    for (int i = 0; i < tracers.size(); ++i) {
+    for (int i = 0; i < TracerBuffer::getNumTracer(); ++i) {
         int count = 0;
         Polygon *polygons[edgePointers.size()];
         EdgePointer *edgePointer = edgePointers.front();
@@ -132,24 +138,31 @@ void Polygon::handoverTracers()
 #ifdef DEBUG
         assert(count != 0);
 #endif
-        double mass = tracers[i].getMass()/count;
+        double mass = getTracerMass(i)/count;
+        // the rounding errors of the handover
+        double change = -getTracerMass(i);
         for (int j = 0; j < count; ++j) {
-            polygons[j]->tracers[i].addMass(mass);
+            double mass0 = polygons[j]->getTracerMass(i);
+            polygons[j]->addTracerMass(i, mass);
+            change += polygons[j]->getTracerMass(i)-mass0;
         }
-        tracers[i].setMass(0.0);
+        setTracerMass(i, 0.0);
+        ConservationMonitor::addMass(i, change);
     }
 }
 
 void Polygon::handoverTracers(Polygon *polygon, double percent)
 {
-    if (polygon->tracers.size() == 0)
-        // polygon is newly created, no tracer has been added
-        polygon->tracers.resize(tracers.size());
-    for (int i = 0; i < tracers.size(); ++i) {
-        double mass1 = tracers[i].getMass()*percent;
-        double mass2 = tracers[i].getMass()-mass1;
-        polygon->tracers[i].addMass(mass1);
-        tracers[i].setMass(mass2);
+    for (int i = 0; i < TracerBuffer::getNumTracer(); ++i) {
+        double mass0 = polygon->getTracerMass(i);
+        double mass1 = getTracerMass(i)*percent;
+        double mass2 = getTracerMass(i)-mass1;
+        // the rounding errors of the handover
+        double change = mass2-getTracerMass(i);
+        polygon->addTracerMass(i, mass1);
+        setTracerMass(i, mass2);
+        change += polygon->getTracerMass(i)-mass0;
+        ConservationMonitor::addMass(i, change);
     }
 }
 #endif
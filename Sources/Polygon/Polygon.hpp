@@ -8,7 +8,7 @@ using std::vector;
 #include "List.hpp"
 #include "Edge.hpp"
 #ifdef TTS_ONLINE
-#include "Tracer.hpp"
+#include "TracerBuffer.hpp"
 #endif
 
 class PolygonManager;
@@ -39,12 +39,28 @@ public:
     void updateTracers();
     void handoverTracers();
     void handoverTracers(Polygon *polygon, double percent);
-    vector<Tracer> tracers;
-    double tracerDiff;
+
+    // tracer quantities in the slot of TracerBuffer
+    int getTracerSlot() const { return tracerSlot; }
+    double getTracerMass(int tracerId) const {
+        return TracerBuffer::getMass(tracerId, tracerSlot);
+    }
+    void setTracerMass(int tracerId, double mass) {
+        TracerBuffer::setMass(tracerId, tracerSlot, mass);
+    }
+    void addTracerMass(int tracerId, double mass) {
+        TracerBuffer::addMass(tracerId, tracerSlot, mass);
+    }
+    double getTracerDensity(int tracerId) const {
+        return TracerBuffer::getDensity(tracerId, tracerSlot);
+    }
 #endif
     List<EdgePointer> edgePointers;
 
 private:
+#ifdef TTS_ONLINE
+    int tracerSlot;
+#endif
     bool areaSet;
     MultiTimeLevel<double, 2> area;
 };
@@ -5,6 +5,60 @@
 #include "ReportMacros.hpp"
 #include "ConfigTools.hpp"
 #include <netcdfcpp.h>
+#include <vector>
+
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// EdgeTable maps the Delaunay edges (the IDs of the two vertices) to the dual
+// Voronoi edges by open addressing, so that the second polygon of each edge
+// finds it in O(1) when converting the Voronoi diagram.
+
+class EdgeTable
+{
+public:
+    EdgeTable(int numEdge) {
+        int size = 1;
+        while (size < 2*numEdge) size <<= 1;
+        mask = size-1;
+        keys.resize(size, std::pair<int, int>(0, 0));
+        edges.resize(size, NULL);
+    }
+
+    void insert(int ID1, int ID2, Edge *edge) {
+        std::pair<int, int> key = makeKey(ID1, ID2);
+        int i = hash(key);
+        while (edges[i] != NULL) i = (i+1)&mask;
+        keys[i] = key;
+        edges[i] = edge;
+    }
+
+    Edge *find(int ID1, int ID2) const {
+        std::pair<int, int> key = makeKey(ID1, ID2);
+        int i = hash(key);
+        while (edges[i] != NULL) {
+            if (keys[i] == key)
+                return edges[i];
+            i = (i+1)&mask;
+        }
+        return NULL;
+    }
+
+private:
+    static std::pair<int, int> makeKey(int ID1, int ID2) {
+        return ID1 < ID2 ? std::make_pair(ID1, ID2) : std::make_pair(ID2, ID1);
+    }
+
+    int hash(const std::pair<int, int> &key) const {
+        unsigned int h = static_cast<unsigned int>(key.first)*2654435761u^
+                         static_cast<unsigned int>(key.second)*40503u;
+        return static_cast<int>(h^(h>>16))&mask;
+    }
+
+    vector<std::pair<int, int> > keys;
+    vector<Edge *> edges;
+    int mask;
+};
 
 PolygonManager::PolygonManager()
 {
@@ -43,20 +97,17 @@ void PolygonManager::init(const DelaunayDriver &driver)
     // convert the Voronoi diagram into polygon representation
     polygons.create(driver.DVT.size());
     vertices.create(driver.DT.size());
-    Polygon *polygonMap[polygons.size()];
-    polygon = polygons.front();
-    for (int i = 0; i < polygons.size(); ++i) {
-        polygonMap[i] = polygon;
-        polygon = polygon->next;
-    }
-    Vertex *vertexMap[vertices.size()];
+    // Note: The maps are on the heap, since there may be millions of
+    //       generators.
+    vector<Vertex *> vertexMap(vertices.size());
     Vertex *vertex = vertices.front();
     for (int i = 0; i < vertices.size(); ++i) {
         vertexMap[i] = vertex;
         vertex = vertex->next;
     }
-    bool checked[driver.DVT.size()];
-    memset(checked, 0, polygons.size()*sizeof(bool));
+    vector<bool> checked(driver.DVT.size(), false);
+    // Note: There are 3n-6 edges in the triangulation of n vertices.
+    EdgeTable edgeTable(3*driver.DVT.size());
     DelaunayVertex *DVT = driver.DVT.front();
     polygon = polygons.front();
     for (int i = 0; i < driver.DVT.size(); ++i) {
@@ -64,21 +115,16 @@ void PolygonManager::init(const DelaunayDriver &driver)
         DelaunayTrianglePointer *incidentDT = DVT->topology.incidentDT.front();
         for (int j = 0; j < DVT->topology.linkDVT.size(); ++j) {
             if (checked[linkDVT->ptr->getID()-1]) {
-                Polygon *p = polygonMap[linkDVT->ptr->getID()-1];
-                edgePointer = p->edgePointers.front();
-                int k;
-                for (k = 0; k < p->edgePointers.size(); ++k) {
-                    if (edgePointer->edge->getEndPoint(FirstPoint)->getID() ==
-                        incidentDT->ptr->getID() &&
-                        edgePointer->edge->getEndPoint(SecondPoint)->getID() ==
-                        incidentDT->prev->ptr->getID()) break;
-                    edgePointer = edgePointer->next;
-                }
+                // use old edge
+                edge = edgeTable.find(DVT->getID(), linkDVT->ptr->getID());
 #ifdef DEBUG
-                assert(k < p->edgePointers.size());
+                assert(edge != NULL);
+                assert(edge->getEndPoint(FirstPoint)->getID() ==
+                       incidentDT->ptr->getID() &&
+                       edge->getEndPoint(SecondPoint)->getID() ==
+                       incidentDT->prev->ptr->getID());
 #endif
-                // use old edge
-                edgePointer->edge->linkPolygon(OrientRight, polygon);
+                edge->linkPolygon(OrientRight, polygon);
             } else {
                 // set vertices
                 Point *center;
@@ -97,6 +143,7 @@ void PolygonManager::init(const DelaunayDriver &driver)
                 edge->linkPolygon(OrientLeft, polygon);
                 edge->calcNormVector();
                 edge->calcLength();
+                edgeTable.insert(DVT->getID(), linkDVT->ptr->getID(), edge);
             }
             linkDVT = linkDVT->next;
             incidentDT = incidentDT->next;
@@ -160,6 +207,11 @@ void PolygonManager::init()
 {
     string fileName;
     ConfigTools::read("parcel_polygon_file", fileName);
+    init(fileName);
+}
+
+void PolygonManager::init(const string &fileName)
+{
     NOTICE("PolygonManager::init", "Reading polygons from \""+fileName+"\" ...");
     NcFile file(fileName.c_str(), NcFile::ReadOnly);
     if (!file.is_valid()) {
@@ -233,7 +285,7 @@ void PolygonManager::init()
         newVtxLon[i] /= Rad2Deg;
         newVtxLat[i] /= Rad2Deg;
     }
-    Vertex *vertexMap[vertices.size()];
+    vector<Vertex *> vertexMap(vertices.size());
     Vertex *vertex = vertices.front();
     for (int i = 0; i < vertices.size(); ++i) {
         vertexMap[i] = vertex;
@@ -254,7 +306,7 @@ void PolygonManager::init()
     int *secondPoint = new int[numEdge];
     file.get_var("first_point_idx")->get(firstPoint, numEdge);
     file.get_var("second_point_idx")->get(secondPoint, numEdge);
-    Edge *edgeMap[edges.size()];
+    vector<Edge *> edgeMap(edges.size());
     Edge *edge = edges.front();
     for (int i = 0; i < edges.size(); ++i) {
         edgeMap[i] = edge;
@@ -294,8 +346,8 @@ void PolygonManager::init()
     // -------------------------------------------------------------------------
     // polygons part
     polygons.create(numPolygon);
-    int edgeNum[numPolygon];
-    file.get_var("edge_num")->get(edgeNum, numPolygon);
+    vector<int> edgeNum(numPolygon);
+    file.get_var("edge_num")->get(&edgeNum[0], numPolygon);
     int numEdgeIdx = static_cast<int>(file.get_dim("num_edge_idx")->size());
     int *edgeIdx = new int[numEdgeIdx];
     int *edgeOnt = new int[numEdgeIdx];
@@ -448,8 +500,8 @@ void PolygonManager::output(const string &fileName)
     NcVar *areaVar = file.add_var("area", ncDouble, numPolygonDim);
     edgeNumVar->add_att("long_name", "edge number of polygon");
     areaVar->add_att("long_name", "polygon area");
-    int edgeNum[polygons.size()];
-    double area[polygons.size()];
+    vector<int> edgeNum(polygons.size());
+    vector<double> area(polygons.size());
     int counter = 0;
     Polygon *polygon = polygons.front();
     for (int i = 0; i < polygons.size(); ++i) {
@@ -478,8 +530,8 @@ void PolygonManager::output(const string &fileName)
         }
         polygon = polygon->next;
     }
-    edgeNumVar->put(edgeNum, polygons.size());
-    areaVar->put(area, polygons.size());
+    edgeNumVar->put(&edgeNum[0], polygons.size());
+    areaVar->put(&area[0], polygons.size());
     edgeIdxVar->put(edgeIdx, numEdgeIdx);
     edgeOntVar->put(edgeOnt, numEdgeIdx);
     delete [] edgeIdx;
@@ -20,6 +20,7 @@ public:
     void init(const DelaunayDriver &);
 #ifdef TTS_ONLINE
     void init();
+    void init(const string &fileName);
 #endif
 
     void output(const string &fileName);
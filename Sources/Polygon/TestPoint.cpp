@@ -35,14 +35,16 @@ void TestPoint::reset(MeshManager &meshManager)
     // reset projections
     if (detectAgent.getActiveProjection() == NULL)
         ApproachingVertices::removeVertex(this);
-    std::list<Projection>::iterator itPrj;
-    for (itPrj = detectAgent.getProjections().begin();
-         itPrj != detectAgent.getProjections().end(); ++itPrj) {
+    VertexAgent::ProjectionMap::iterator itPrj;
+    itPrj = detectAgent.getProjections().begin();
+    while (itPrj != detectAgent.getProjections().end()) {
         (*itPrj).expire();
         if ((*itPrj).project(NewTimeLevel) != HasNoProjection) {
             (*itPrj).project(OldTimeLevel);
             (*itPrj).tags.unset(Approaching);
+            ++itPrj;
         } else
+            // Note: unpair leaves the iterator on the next projection.
             AgentPair::unpair(itPrj);
     }
 }
@@ -7,11 +7,15 @@
 #include "PolygonManager.hpp"
 #include "TimeManager.hpp"
 #endif
+#include <list>
 
 Vertex::Vertex()
 {
 #ifdef TTS_ONLINE
     detectAgent.checkin(this);
+    taskStamp = -1;
+    approachStamp = -1;
+    crossStamp = -1;
 #endif
     reinit();
 }
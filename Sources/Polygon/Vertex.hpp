@@ -43,6 +43,10 @@ public:
     ApproachDetector::VertexAgent detectAgent;
     VertexTags tags;
     Edge *hostEdge; // for test point
+    // slots in the task queues (see StampedQueue)
+    int taskStamp;      // CommonTasks
+    int approachStamp;  // ApproachingVertices
+    int crossStamp;     // crossing vertices in ApproachDetector::detectPolygon
 #endif
 	List<EdgePointer> linkedEdges;
 };
@@ -4,12 +4,24 @@
 #include "ConfigTools.hpp"
 #include "MeshManager.hpp"
 #include "SCVT.hpp"
+#include "SystemCalls.hpp"
 #include <netcdfcpp.h>
+#include <vector>
+
+using std::vector;
 
 int main(int argc, char **argv)
 {
     ConfigTools::parse(argv[1]);
     DelaunayDriver driver;
+    if (ConfigTools::hasKey("delaunay_insert_mode")) {
+        string insertMode;
+        ConfigTools::read("delaunay_insert_mode", insertMode);
+        if (insertMode == "brio")
+            driver.setInsertMode(DelaunayDriver::BRIOMode);
+        else if (insertMode != "conflict_list")
+            REPORT_ERROR("Unknown delaunay_insert_mode \""+insertMode+"\".");
+    }
     // -------------------------------------------------------------------------
     if (ConfigTools::hasKey("use_points")) {
         // use specified points to generate polygons
@@ -21,13 +33,13 @@ int main(int argc, char **argv)
             return 1;
         }
         int numPoint = file.get_dim("grid_size")->size();
-        double lon[numPoint], lat[numPoint];
-        file.get_var("grid_center_lon")->get(lon, numPoint);
-        file.get_var("grid_center_lat")->get(lat, numPoint);
+        vector<double> lon(numPoint), lat(numPoint);
+        file.get_var("grid_center_lon")->get(&lon[0], numPoint);
+        file.get_var("grid_center_lat")->get(&lat[0], numPoint);
         file.close();
         NOTICE("preprocess", "Triangulating point data.")
         PointManager pointManager;
-        pointManager.init(numPoint, lon, lat);
+        pointManager.init(numPoint, &lon[0], &lat[0]);
         driver.init(pointManager);
         driver.run();
         driver.calcCircumcenter();
@@ -49,6 +61,26 @@ int main(int argc, char **argv)
         SCVT::init(mesh.getNumLon(), mesh.getNumLat(),
                    mesh.lon.data(),  mesh.lat.data(), maxIteration);
         SCVT::getDensityFunction() = 1.0;
+        if (ConfigTools::hasKey("quadrature_order")) {
+            int quadratureOrder;
+            ConfigTools::read("quadrature_order", quadratureOrder);
+            SCVT::setQuadratureOrder(quadratureOrder);
+        }
+        if (ConfigTools::hasKey("scvt_solver")) {
+            string solver;
+            ConfigTools::read("scvt_solver", solver);
+            SCVT::setSolver(solver);
+        }
+        if (ConfigTools::hasKey("anderson_depth")) {
+            int depth;
+            ConfigTools::read("anderson_depth", depth);
+            SCVT::setAndersonDepth(depth);
+        }
+        if (ConfigTools::hasKey("scvt_num_level")) {
+            int numLevel;
+            ConfigTools::read("scvt_num_level", numLevel);
+            SCVT::setNumLevel(numLevel);
+        }
         SCVT::run(numGenerator, driver, "pp");
     }
     // -------------------------------------------------------------------------
@@ -58,6 +90,10 @@ int main(int argc, char **argv)
     string fileName;
     ConfigTools::read("output_file", fileName);
     polygonManager.output(fileName);
+    Message message;
+    message << "Peak resident memory is " << SystemCalls::getPeakMemory();
+    message << " MB.";
+    NOTICE("preprocess", message.str())
 
     return 0;
 }
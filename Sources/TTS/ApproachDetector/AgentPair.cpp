@@ -79,7 +79,7 @@ void AgentPair::unpair(Vertex *vertex, Edge *edge)
 }
 
 
-void AgentPair::unpair(std::list<Vertex *>::iterator &it, Edge *edge)
+void AgentPair::unpair(EdgeAgent::VertexList::iterator &it, Edge *edge)
 {
 #ifdef TRACK_PAIRS
 #ifdef PAIR_EDGE_ID
@@ -104,7 +104,7 @@ void AgentPair::unpair(std::list<Vertex *>::iterator &it, Edge *edge)
         ApproachingVertices::removeVertex(vertex);
 }
 
-void AgentPair::unpair(std::list<Vertex *>::iterator &it,
+void AgentPair::unpair(EdgeAgent::VertexList::iterator &it,
                        Projection *projection)
 {
 #ifdef TRACK_PAIRS
@@ -130,7 +130,7 @@ void AgentPair::unpair(std::list<Vertex *>::iterator &it,
         ApproachingVertices::removeVertex(vertex);
 }
 
-void AgentPair::unpair(std::list<Projection>::iterator &it)
+void AgentPair::unpair(VertexAgent::ProjectionMap::iterator &it)
 {
     Vertex *vertex = (*it).getVertex();
     Edge *edge = (*it).getEdge();
@@ -2,7 +2,8 @@
 #define AgentPair_h
 
 #include "Projection.hpp"
-#include <list>
+#include "VertexAgent.hpp"
+#include "EdgeAgent.hpp"
 
 class Vertex;
 class Edge;
@@ -15,11 +16,11 @@ namespace ApproachDetector
 
         void unpair(Vertex *vertex, Edge *edge);
 
-        void unpair(std::list<Vertex *>::iterator &it, Edge *edge);
+        void unpair(EdgeAgent::VertexList::iterator &it, Edge *edge);
 
-        void unpair(std::list<Vertex *>::iterator &it, Projection *projection);
+        void unpair(EdgeAgent::VertexList::iterator &it, Projection *projection);
 
-        void unpair(std::list<Projection>::iterator &it);
+        void unpair(VertexAgent::ProjectionMap::iterator &it);
     }
 }
 
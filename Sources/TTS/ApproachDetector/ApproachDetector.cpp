@@ -7,9 +7,14 @@
 #include "PotentialCrossDetector.hpp"
 #include "TTS.hpp"
 #include "CommonTasks.hpp"
+#include "StampedQueue.hpp"
+#include "SweptEdgeDetector.hpp"
 #ifdef DEBUG
 #include "DebugTools.hpp"
 #endif
+#include <algorithm>
+#include <map>
+#include <vector>
 
 using namespace ApproachDetector;
 using namespace SpecialPolygons;
@@ -21,11 +26,16 @@ void ApproachDetector::init()
     TrendThreshold::init();
 }
 
-bool ApproachDetector::isNeedCheck(double distance)
+double ApproachDetector::getCheckDistance()
 {
     // TODO: Put this parameter into config file.
     static const double distanceThreshold = 1.0/Rad2Deg*Sphere::radius;
-    if (distance < distanceThreshold)
+    return distanceThreshold;
+}
+
+bool ApproachDetector::isNeedCheck(double distance)
+{
+    if (distance < getCheckDistance())
         return true;
     else
         return false;
@@ -65,6 +75,10 @@ inline void detectPoint(MeshManager &meshManager, const FlowManager &flowManager
         // Scenario 1:
         //   Vertex3 moves into the detecting range of edge1, but is
         //   not paired with it.
+        // Note: Skip the projection when vertex3 is surely far away from
+        //       edge1, which is the most case.
+        if (!SweptEdgeDetector::mayApproach(point, edge, getCheckDistance()))
+            return;
         projection = &p;
         projection->reinit();
         if (projection->project(point, edge, NewTimeLevel)) {
@@ -211,6 +225,87 @@ return_invalid_approach:
     return false;
 }
 
+// The polygons with more edges than this query the candidates of each edge
+// from SweptEdgeDetector instead of walking all the other edges.
+static const int minNumEdgeToQuery = 64;
+
+inline void addCandidate(Polygon *polygon, Edge *edge,
+                         std::vector<EdgePointer *> &candidates)
+{
+    if (edge->getPolygon(OrientLeft) == polygon)
+        candidates.push_back(edge->getEdgePointer(OrientLeft));
+    if (edge->getPolygon(OrientRight) == polygon)
+        candidates.push_back(edge->getEdgePointer(OrientRight));
+}
+
+/*
+ * Function:
+ *   collectCandidates
+ * Purpose:
+ *   Collect the edge pointers of the polygon whose end points or test points
+ *   may approach edge1, which are the edges whose swept caps are in the
+ *   checking distance of edge1 and the edges of the points that have been
+ *   paired with edge1 (they may need to be unpaired). The candidates are
+ *   sorted in the order of walking from the next edge pointer of edge1, so
+ *   they are handled in the same order as in the full walk.
+ */
+static void collectCandidates(Polygon *polygon, EdgePointer *edgePointer1,
+                              std::map<EdgePointer *, int> &positions,
+                              std::vector<EdgePointer *> &candidates)
+{
+    static std::vector<Edge *> edges;
+    static std::vector<std::pair<int, EdgePointer *> > orders;
+    Edge *edge1 = edgePointer1->edge;
+    candidates.clear();
+    SweptEdgeDetector::queryEdges(edge1->getEndPoint(FirstPoint)->getCoordinate(),
+                                  edge1->getEndPoint(SecondPoint)->getCoordinate(),
+                                  edges, getCheckDistance());
+    for (int i = 0; i < static_cast<int>(edges.size()); ++i)
+        addCandidate(polygon, edges[i], candidates);
+    EdgeAgent::VertexList::iterator itVtx = edge1->detectAgent.vertices.begin();
+    for (; itVtx != edge1->detectAgent.vertices.end(); ++itVtx) {
+        if ((*itVtx)->getID() == -1) {
+            addCandidate(polygon, (*itVtx)->getHostEdge(), candidates);
+        } else {
+            EdgePointer *linkedEdge = (*itVtx)->linkedEdges.front();
+            for (int i = 0; i < (*itVtx)->linkedEdges.size(); ++i) {
+                addCandidate(polygon, linkedEdge->edge, candidates);
+                linkedEdge = linkedEdge->next;
+            }
+        }
+    }
+    // -------------------------------------------------------------------------
+    // sort the candidates along the polygon
+    // Note: The new edge pointers (e.g. by splitEdge) are not indexed yet.
+    for (int i = 0; i < static_cast<int>(candidates.size()); ++i)
+        if (positions.find(candidates[i]) == positions.end()) {
+            positions.clear();
+            break;
+        }
+    if (positions.empty() ||
+        positions.find(edgePointer1) == positions.end()) {
+        positions.clear();
+        EdgePointer *edgePointer = polygon->edgePointers.front();
+        for (int i = 0; i < polygon->edgePointers.size(); ++i) {
+            positions[edgePointer] = i;
+            edgePointer = edgePointer->next;
+        }
+    }
+    int numEdge = static_cast<int>(positions.size());
+    int position1 = positions[edgePointer1];
+    orders.clear();
+    for (int i = 0; i < static_cast<int>(candidates.size()); ++i)
+        if (candidates[i] != edgePointer1)
+            orders.push_back(std::make_pair
+                             ((positions[candidates[i]]-position1+numEdge)%numEdge,
+                              candidates[i]));
+    std::sort(orders.begin(), orders.end());
+    candidates.clear();
+    for (int i = 0; i < static_cast<int>(orders.size()); ++i)
+        if (i == 0 || orders[i].second != orders[i-1].second)
+            candidates.push_back(orders[i].second);
+}
+
 void ApproachDetector::detectPolygon(MeshManager &meshManager,
                                      const FlowManager &flowManager,
                                      PolygonManager &polygonManager,
@@ -223,7 +318,7 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
 //        REPORT_DEBUG;
 //    }
     // -------------------------------------------------------------------------
-    static std::list<Vertex *> crossVertices;
+    static StampedQueue<Vertex, &Vertex::crossStamp> crossVertices;
     Edge *edge1;
     Vertex *vertex1, *vertex3;
     EdgePointer *edgePointer1, *edgePointer2;
@@ -232,6 +327,10 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
     Projection *projection;
     Polygon *badPolygon;
     static bool handleCrossVertices = false;
+    static std::map<EdgePointer *, int> positions;
+    static std::vector<EdgePointer *> candidates;
+    bool isQueryCandidates;
+    int k;
     // -------------------------------------------------------------------------
     if (polygon->edgePointers.size() == 2) {
         handleLinePolygon(polygonManager, polygon);
@@ -239,14 +338,28 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
         return;
     }
     // -------------------------------------------------------------------------
+    positions.clear();
     polygon->edgePointers.startLoop(edgePointer1);
     assert(edgePointer1 == polygon->edgePointers.front());
     do {
         edge1 = edgePointer1->edge;
         vertex1 = edgePointer1->getEndPoint(FirstPoint);
-        edgePointer2 = edgePointer1->next;
+        // Note: The edges that are far from edge1 are skipped as a whole for
+        //       the large polygons, while the small ones are just walked.
+        isQueryCandidates = SweptEdgeDetector::isBuilt() &&
+            polygon->edgePointers.size() > minNumEdgeToQuery;
+        if (isQueryCandidates) {
+            collectCandidates(polygon, edgePointer1, positions, candidates);
+            k = 0;
+            edgePointer2 = candidates.empty() ? edgePointer1 : candidates[0];
+        } else
+            edgePointer2 = edgePointer1->next;
         while (edgePointer2 != edgePointer1) {
-            nextEdgePointer2 = edgePointer2->next;
+            if (isQueryCandidates)
+                nextEdgePointer2 = ++k < static_cast<int>(candidates.size()) ?
+                    candidates[k] : edgePointer1;
+            else
+                nextEdgePointer2 = edgePointer2->next;
             TestPoint *testPoint;
             // -----------------------------------------------------------------
             if (edgePointer2 != edgePointer1->prev) {
@@ -298,13 +411,12 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
                     DebugTools::assert_polygon_mass_constant(polygonManager);
 #endif
                     CommonTasks::doTask(CommonTasks::UpdateAngle);
+                    positions.clear();
                     break;
                 }
                 // -------------------------------------------------------------
                 // detect vertex and record crossing vertex or split polygon
-                if (handleCrossVertices &&
-                    find(crossVertices.begin(), crossVertices.end(), vertex3) !=
-                    crossVertices.end()) {
+                if (handleCrossVertices && crossVertices.contains(vertex3)) {
                     projection = vertex3->detectAgent.getProjection(edge1);
                     if (projection != NULL && projection->tags.isSet(Crossing)) {
                         crossVertices.remove(vertex3);
@@ -342,9 +454,7 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
                         edgePointer3 = edgePointer1;
                         edgePointer4 = edgePointer2;
                     }
-                    if (find(crossVertices.begin(), crossVertices.end(), vertex3)
-                        == crossVertices.end())
-                        crossVertices.push_back(vertex3);
+                    crossVertices.push(vertex3);
                 }
                 checkApproachValid(meshManager, flowManager, polygonManager,
                                    edgePointer1, edgePointer2, vertex3);
@@ -368,10 +478,9 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
         polygon->dump("new_polygon", NewTimeLevel);
         cout << "Bad polygon " << polygon->getID() << endl;
         cout << "Crossing vertex number: " << crossVertices.size() << endl;
-        std::list<Vertex *>::const_iterator it;
-        for (it = crossVertices.begin(); it != crossVertices.end(); ++it) {
-            cout << "  * " << (*it)->getID() << endl;
-        }
+        for (int i = 0; i < crossVertices.getNumSlot(); ++i)
+            if (crossVertices.getSlot(i) != NULL)
+                cout << "  * " << crossVertices.getSlot(i)->getID() << endl;
 #endif
         vertex3 = crossVertices.front();
         // TODO: Handle the case where the orientation of the crossing vertex
@@ -406,10 +515,9 @@ void ApproachDetector::detectPolygon(MeshManager &meshManager,
         DebugTools::assert_polygon_mass_constant(polygonManager);
         if (crossVertices.size() != 0) {
             cout << "Skipped vertices:" << endl;
-            std::list<Vertex *>::const_iterator it;
-            for (it = crossVertices.begin(); it != crossVertices.end(); ++it) {
-                cout << "  * " << (*it)->getID() << endl;
-            }
+            for (int i = 0; i < crossVertices.getNumSlot(); ++i)
+                if (crossVertices.getSlot(i) != NULL)
+                    cout << "  * " << crossVertices.getSlot(i)->getID() << endl;
         }
 #endif
         crossVertices.clear();
@@ -20,6 +20,8 @@ namespace ApproachDetector
 {
     void init();
 
+    double getCheckDistance();
+
     bool isNeedCheck(double distance);
 
     bool isApproaching(Projection *projection);
@@ -1,10 +1,13 @@
 #include "ApproachingVertices.hpp"
 #include "Vertex.hpp"
 #include "Edge.hpp"
+#include "StampedQueue.hpp"
 
 using namespace ApproachDetector;
 
-std::list<Vertex *> ApproachingVertices::vertices;
+// Note: The queue is kept here instead of in the class, since the header is
+//       included by Vertex.hpp before Vertex is complete.
+static StampedQueue<Vertex, &Vertex::approachStamp> vertices;
 
 //#define TRACK_APPROACH_VERTEX
 #define APPROACH_VERTEX_ID 45804
@@ -28,14 +31,12 @@ void ApproachingVertices::recordVertex(Vertex *vertex)
         REPORT_DEBUG;
     }
 #endif
-    if (std::find(vertices.begin(), vertices.end(), vertex) != vertices.end())
-        return;
-    vertices.push_back(vertex);
+    vertices.push(vertex);
 }
 
 void ApproachingVertices::removeVertex(Vertex *vertex)
 {
-    if (std::find(vertices.begin(), vertices.end(), vertex) == vertices.end())
+    if (!vertices.contains(vertex))
         return;
 #ifdef TRACK_APPROACH_VERTEX
     if ((vertex->getID() == APPROACH_VERTEX_ID ||
@@ -51,8 +52,8 @@ void ApproachingVertices::removeVertex(Vertex *vertex)
 void ApproachingVertices::jumpVertex(Vertex *vertex1, Vertex *vertex2)
 {
 #ifdef DEBUG
-    assert(std::find(vertices.begin(), vertices.end(), vertex1) != vertices.end());
-    assert(std::find(vertices.begin(), vertices.end(), vertex2) != vertices.end());
+    assert(vertices.contains(vertex1));
+    assert(vertices.contains(vertex2));
 #endif
 #ifdef TRACK_APPROACH_VERTEX
     if ((vertex2->getID() == APPROACH_VERTEX_ID ||
@@ -62,12 +63,22 @@ void ApproachingVertices::jumpVertex(Vertex *vertex1, Vertex *vertex2)
         REPORT_DEBUG;
     }
 #endif
-    std::list<Vertex *>::iterator it = vertices.begin();
-    for (; it != vertices.end(); ++it)
-        if (*it == vertex1)
-            break;
-    vertices.remove(vertex2);
-    vertices.insert(it, vertex2);
+    vertices.moveBefore(vertex1, vertex2);
+}
+
+bool ApproachingVertices::isEmpty()
+{
+    return vertices.empty();
+}
+
+Vertex *ApproachingVertices::front()
+{
+    return vertices.front();
+}
+
+void ApproachingVertices::clear()
+{
+    vertices.clear();
 }
 
 void ApproachingVertices::dump()
@@ -75,12 +86,14 @@ void ApproachingVertices::dump()
     cout << "***** Approaching vertices list:" << endl;
     cout << "      Number: " << vertices.size() << endl;
     cout << "      Vertex IDs: ";
-    std::list<Vertex *>::iterator it = vertices.begin();
-    for (; it != vertices.end(); ++it) {
-        if ((*it)->getID() != -1)
-            cout << setw(15) << (*it)->getID();
+    for (int i = 0; i < vertices.getNumSlot(); ++i) {
+        Vertex *vertex = vertices.getSlot(i);
+        if (vertex == NULL)
+            continue;
+        if (vertex->getID() != -1)
+            cout << setw(15) << vertex->getID();
         else
-            cout << setw(15) << "[" << (*it)->getHostEdge()->getID() << "]";
+            cout << setw(15) << "[" << vertex->getHostEdge()->getID() << "]";
     }
     cout << endl;
 }
@@ -1,8 +1,6 @@
 #ifndef ApproachingVertices_h
 #define ApproachingVertices_h
 
-#include <list>
-
 class Vertex;
 
 namespace ApproachDetector
@@ -19,11 +17,13 @@ namespace ApproachDetector
 
         static void jumpVertex(Vertex *vertex1, Vertex *vertex2);
 
-        static bool isEmpty() { return vertices.size() == 0 ? true : false; }
+        static bool isEmpty();
 
-        static void dump();
+        static Vertex *front();
 
-        static std::list<Vertex *> vertices;
+        static void clear();
+
+        static void dump();
     };
 }
 
@@ -33,7 +33,7 @@ void EdgeAgent::reinit()
 
 void EdgeAgent::clean()
 {
-    std::list<Vertex *>::iterator it;
+    VertexList::iterator it;
     for (it = vertices.begin(); it != vertices.end();)
         AgentPair::unpair(it, host);
 }
@@ -48,7 +48,7 @@ void EdgeAgent::removeVertex(Vertex *vertex)
     vertices.remove(vertex);
 }
 
-void EdgeAgent::removeVertex(std::list<Vertex *>::iterator &it)
+void EdgeAgent::removeVertex(VertexList::iterator &it)
 {
     it = vertices.erase(it);
 }
@@ -57,8 +57,8 @@ void EdgeAgent::updateVertexProjections(MeshManager &meshManager)
 {
     Vertex *vertex1 = host->getEndPoint(FirstPoint);
     Vertex *vertex2 = host->getEndPoint(SecondPoint);
-    std::list<Vertex *>::iterator it = vertices.begin();
-    for (int i = 0; i < vertices.size();) {
+    VertexList::iterator it = vertices.begin();
+    while (it != vertices.end()) {
         Vertex *vertex3 = *it;
         Projection *projection = vertex3->detectAgent.getProjection(host);
         if (vertex3 == vertex1 || vertex3 == vertex2 ||
@@ -69,8 +69,10 @@ void EdgeAgent::updateVertexProjections(MeshManager &meshManager)
                vertex3->getHostEdge()->getEndPoint(SecondPoint) == vertex2) ||
               (vertex3->getHostEdge()->getEndPoint(FirstPoint) == vertex2 &&
                vertex3->getHostEdge()->getEndPoint(SecondPoint) == vertex1)))) {
+            // Note: The projection is released by unpair.
+            bool isApproaching = projection->tags.isSet(Approaching);
             AgentPair::unpair(it, host);
-            if (projection->tags.isSet(Approaching) &&
+            if (isApproaching &&
                 vertex3->detectAgent.getActiveProjection() == NULL)
                 ApproachingVertices::removeVertex(vertex3);
         } else {
@@ -105,7 +107,6 @@ void EdgeAgent::updateVertexProjections(MeshManager &meshManager)
                     }
                     ++it;
                 }
-                ++i;
             }
         }
     }
@@ -119,7 +120,7 @@ void EdgeAgent::handoverVertices(Edge *edge)
     Vertex *vertex1, *vertex2, *vertex3;
     vertex1 = edge->getEndPoint(FirstPoint);
     vertex2 = edge->getEndPoint(SecondPoint);
-    std::list<Vertex *>::iterator it = vertices.begin();
+    VertexList::iterator it = vertices.begin();
     for (; it != vertices.end(); ++it) {
         vertex3 = *it;
         if (vertex3 == vertex1 || vertex3 == vertex2 ||
@@ -163,7 +164,7 @@ void EdgeAgent::handoverVertices(Edge *edge)
 void EdgeAgent::dump()
 {
     cout << "Paired vertices:" << endl;
-    std::list<Vertex *>::iterator it = vertices.begin();
+    VertexList::iterator it = vertices.begin();
     for (; it != vertices.end(); ++it) {
         cout << setw(12) << *it << ":";
         if ((*it)->getID() != -1)
@@ -1,7 +1,7 @@
 #ifndef EdgeAgent_h
 #define EdgeAgent_h
 
-#include <list>
+#include "SmallVector.hpp"
 
 class MeshManager;
 class FlowManager;
@@ -14,6 +14,8 @@ namespace ApproachDetector
     class EdgeAgent
     {
     public:
+        typedef SmallVector<Vertex *, 4> VertexList;
+
         EdgeAgent();
         virtual ~EdgeAgent();
 
@@ -25,7 +27,7 @@ namespace ApproachDetector
         void recordVertex(Vertex *vertex);
 
         void removeVertex(Vertex *vertex);
-        void removeVertex(std::list<Vertex *>::iterator &it);
+        void removeVertex(VertexList::iterator &it);
 
         void updateVertexProjections(MeshManager &meshManager);
 
@@ -33,7 +35,7 @@ namespace ApproachDetector
 
         void dump();
 
-        std::list<Vertex *> vertices;
+        VertexList vertices;
 
     private:
         friend class VertexAgent;
@@ -13,8 +13,6 @@ using namespace ApproachDetector;
 
 Projection::Projection()
 {
-    x.init();
-    distance.init();
     reinit();
 }
 
@@ -27,8 +25,6 @@ Projection::Projection(Vertex *vertex, Edge *edge)
 
 Projection::Projection(const Projection &that)
 {
-    x.init();
-    distance.init();
     *this = that;
 }
     
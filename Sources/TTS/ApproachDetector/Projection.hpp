@@ -54,8 +54,8 @@ namespace ApproachDetector
     private:
         Vertex *vertex;
         Edge *edge;
-        MultiTimeLevel<Coordinate, 2> x;
-        MultiTimeLevel<double, 2> distance;
+        InlineMultiTimeLevel<Coordinate, 2> x;
+        InlineMultiTimeLevel<double, 2> distance;
         OrientStatus orient;
         double changeRate;
     };
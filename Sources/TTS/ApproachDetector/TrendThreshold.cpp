@@ -7,6 +7,7 @@ using namespace ApproachDetector;
 
 Array<double, 1> TrendThreshold::P;
 Array<double, 1> TrendThreshold::D;
+ThresholdFunction::PiecewiseCubic TrendThreshold::trendFunction;
 
 void TrendThreshold::init()
 {
@@ -17,9 +18,15 @@ void TrendThreshold::init()
     ConfigTools::read("distance", D.size(), D.data());
     ConfigTools::read("trend_threshold", P.size(), P.data());
     D *= Sphere::radius/Rad2Deg;
+    trendFunction.init(P.size(), D.data(), P.data());
 }
 
 void TrendThreshold::calc(double distance, double &percent)
 {
-    percent = ThresholdFunction::piecewiseCubic(P.size(), D.data(), P.data(), distance);
+    percent = trendFunction(distance);
+}
+
+void TrendThreshold::calc(int n, const double *distance, double *percent)
+{
+    trendFunction.evaluate(n, distance, percent);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef TrendThreshold_h
 #define TrendThreshold_h
 
+#include "ThresholdFunction.hpp"
 #include <blitz/array.h>
 
 using blitz::Array;
@@ -16,9 +17,13 @@ namespace ApproachDetector
         static void init();
         
         static void calc(double distance, double &percent);
+
+        // calculate the thresholds of n distances in one pass
+        static void calc(int n, const double *distance, double *percent);
         
     private:
         static Array<double, 1> P, D;
+        static ThresholdFunction::PiecewiseCubic trendFunction;
     };
 }
 
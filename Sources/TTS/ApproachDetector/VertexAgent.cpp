@@ -26,7 +26,7 @@ void VertexAgent::reinit()
 
 void VertexAgent::clean()
 {
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end(); ++it) {
         if ((*it).getEdge() != NULL)
             (*it).getEdge()->detectAgent.removeVertex(host);
@@ -44,7 +44,7 @@ void VertexAgent::recordProjection(Edge *edge, Projection *projection)
     projection->setEdge(edge);
     projection->setVertex(host);
     projection->tags.set(Calculated);
-    projections.push_back(*projection);
+    projections.insert(edge, *projection);
 }
 
 void VertexAgent::removeProjection(Projection *projection)
@@ -52,16 +52,10 @@ void VertexAgent::removeProjection(Projection *projection)
 #ifdef DEBUG
     assert(projection != NULL);
 #endif
-    std::list<Projection>::iterator it = projections.begin();
-    for (; it != projections.end(); ++it) {
-        if (&(*it) == projection) {
-            projections.erase(it);
-            return;
-        }
-    }
+    projections.erase(projection);
 }
 
-void VertexAgent::removeProjection(std::list<Projection>::iterator &it)
+void VertexAgent::removeProjection(ProjectionMap::iterator &it)
 {
     it = projections.erase(it);
 }
@@ -69,7 +63,7 @@ void VertexAgent::removeProjection(std::list<Projection>::iterator &it)
 void VertexAgent::expireProjection()
 {
     Polygon *polygon1, *polygon2, *polygon3, *polygon4;
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end();) {
         // Note: There is a possibility that the paired vertex and edge belong
         //       to different polygons after one is split, so they should be
@@ -109,19 +103,14 @@ void VertexAgent::expireProjection()
 
 Projection *VertexAgent::getProjection(Edge *edge)
 {
-    std::list<Projection>::iterator it = projections.begin();
-    for (; it != projections.end(); ++it) {
-        if ((*it).getEdge() == edge)
-            return &(*it);
-    }
-    return NULL;
+    return projections.find(edge);
 }
 
 Projection *VertexAgent::getActiveProjection()
 {
     Projection *activeProjection = NULL;
     double distance = UndefinedDistance;
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end(); ++it) {
         if ((*it).tags.isSet(Approaching)) {
             if ((*it).getDistance(NewTimeLevel) < distance ||
@@ -136,7 +125,7 @@ Projection *VertexAgent::getActiveProjection()
 
 bool VertexAgent::isCrossing()
 {
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end(); ++it)
         if ((*it).tags.isSet(Crossing))
             return true;
@@ -146,7 +135,7 @@ bool VertexAgent::isCrossing()
 double VertexAgent::getShortestDistance()
 {
     double distance = UndefinedDistance;
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end(); ++it) {
         if ((*it).getDistance(NewTimeLevel) < distance ||
             distance == UndefinedDistance) {
@@ -160,7 +149,7 @@ VertexAgent &VertexAgent::operator=(const VertexAgent &that)
 {
     if (this != &that) {
         projections = that.projections;
-        std::list<Projection>::iterator it = projections.begin();
+        ProjectionMap::iterator it = projections.begin();
         for (; it != projections.end(); ++it) {
             if ((*it).tags.isSet(Approaching)) {
                 // Note: If the host of "that" is approaching to some edge,
@@ -180,7 +169,7 @@ void VertexAgent::dump()
 {
     cout << "Paired edge projections of vertex ";
     cout << host->getID() << " " << host << ":" << endl;
-    std::list<Projection>::iterator it = projections.begin();
+    ProjectionMap::iterator it = projections.begin();
     for (; it != projections.end(); ++it) {
         Edge *edge = (*it).getEdge();
         Vertex *vertex1 = edge->getEndPoint(FirstPoint);
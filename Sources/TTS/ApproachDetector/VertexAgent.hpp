@@ -2,7 +2,7 @@
 #define VertexAgent_h
 
 #include "Projection.hpp"
-#include <list>
+#include "SmallVector.hpp"
 
 class Vertex;
 class Edge;
@@ -12,6 +12,10 @@ namespace ApproachDetector
     class VertexAgent
     {
     public:
+        // Note: A vertex is paired with only a few edges in most cases, so the
+        //       first two projections are stored inside the agent.
+        typedef FlatMap<Edge *, Projection, 2> ProjectionMap;
+
         VertexAgent();
         ~VertexAgent();
 
@@ -23,7 +27,7 @@ namespace ApproachDetector
         void recordProjection(Edge *edge, Projection *projection);
 
         void removeProjection(Projection *projection);
-        void removeProjection(std::list<Projection>::iterator &it);
+        void removeProjection(ProjectionMap::iterator &it);
 
         void expireProjection();
 
@@ -38,13 +42,13 @@ namespace ApproachDetector
 
         void dump();
 
-        std::list<Projection> &getProjections() { return projections; }
+        ProjectionMap &getProjections() { return projections; }
 
     private:
         friend class EdgeAgent;
 
         Vertex *host;
-        std::list<Projection> projections;
+        ProjectionMap projections;
     };
 }
 
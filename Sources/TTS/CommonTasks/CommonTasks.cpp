@@ -6,9 +6,9 @@
 
 using namespace ApproachDetector;
 
-std::set<EdgePointer *> CommonTasks::needUpdateAngles;
-std::set<Edge *> CommonTasks::needRemoveEdges;
-std::set<Vertex *> CommonTasks::needRemoveVertices;
+StampedQueue<EdgePointer, &EdgePointer::taskStamp> CommonTasks::needUpdateAngles;
+StampedQueue<Edge, &Edge::taskStamp> CommonTasks::needRemoveEdges;
+StampedQueue<Vertex, &Vertex::taskStamp> CommonTasks::needRemoveVertices;
 
 void CommonTasks::resetTasks()
 {
@@ -18,10 +18,9 @@ void CommonTasks::resetTasks()
 int CommonTasks::getTaskNumber(TaskType type)
 {
     if (type == UpdateAngle)
-        return static_cast<int>(needUpdateAngles.size());
+        return needUpdateAngles.size();
     else if (type == RemoveObject)
-        return static_cast<int>(needRemoveEdges.size()+
-                                needRemoveVertices.size());
+        return needRemoveEdges.size()+needRemoveVertices.size();
     else
         REPORT_ERROR("Unknown task type!");
 }
@@ -30,55 +29,56 @@ void CommonTasks::recordTask(TaskType type, EdgePointer *edgePointer)
 {
     if (type == UpdateAngle) {
         edgePointer->resetAngle();
-        needUpdateAngles.insert(edgePointer);
+        needUpdateAngles.push(edgePointer);
     }
 }
 
 void CommonTasks::recordTask(TaskType type, Edge *edge)
 {
     if (type == RemoveObject) {
-        needRemoveEdges.insert(edge);
+        needRemoveEdges.push(edge);
     }
 }
 
 void CommonTasks::recordTask(TaskType type, Vertex *vertex)
 {
     if (type == RemoveObject) {
-        needRemoveVertices.insert(vertex);
+        needRemoveVertices.push(vertex);
     }
 }
 
 void CommonTasks::deleteTask(TaskType type, EdgePointer *edgePointer)
 {
     if (type == UpdateAngle) {
-        needUpdateAngles.erase(edgePointer);
+        needUpdateAngles.remove(edgePointer);
     }
 }
 
 void CommonTasks::deleteTask(TaskType type, Edge *edge)
 {
     if (type == RemoveObject) {
-        needRemoveEdges.erase(edge);
+        needRemoveEdges.remove(edge);
     }
 }
 
 void CommonTasks::deleteTask(TaskType type, Vertex *vertex)
 {
     if (type == RemoveObject) {
-        needRemoveVertices.erase(vertex);
+        needRemoveVertices.remove(vertex);
     }
 }
 
 void CommonTasks::doTask(TaskType type)
 {
     if (type == UpdateAngle) {
-        std::set<EdgePointer *>::iterator it;
-        for (it = needUpdateAngles.begin();
-             it != needUpdateAngles.end(); ++it) {
+        for (int i = 0; i < needUpdateAngles.getNumSlot(); ++i) {
+            EdgePointer *edgePointer = needUpdateAngles.getSlot(i);
+            if (edgePointer == NULL)
+                continue;
 #ifdef DEBUG
-            assert((*it)->isAngleSet == false);
+            assert(edgePointer->isAngleSet == false);
 #endif
-            (*it)->calcAngle();
+            edgePointer->calcAngle();
         }
         needUpdateAngles.clear();
     } else {
@@ -89,16 +89,16 @@ void CommonTasks::doTask(TaskType type)
 void CommonTasks::doTask(TaskType type, PolygonManager &polygonManager)
 {
     if (type == RemoveObject) {
-        std::set<Edge *>::iterator it1;
-        for (it1 = needRemoveEdges.begin();
-             it1 != needRemoveEdges.end(); ++it1) {
-            polygonManager.edges.remove(*it1);
+        for (int i = 0; i < needRemoveEdges.getNumSlot(); ++i) {
+            Edge *edge = needRemoveEdges.getSlot(i);
+            if (edge != NULL)
+                polygonManager.edges.remove(edge);
         }
         needRemoveEdges.clear();
-        std::set<Vertex *>::iterator it2;
-        for (it2 = needRemoveVertices.begin();
-             it2 != needRemoveVertices.end(); ++it2) {
-            polygonManager.vertices.remove(*it2);
+        for (int i = 0; i < needRemoveVertices.getNumSlot(); ++i) {
+            Vertex *vertex = needRemoveVertices.getSlot(i);
+            if (vertex != NULL)
+                polygonManager.vertices.remove(vertex);
         }
         needRemoveVertices.clear();
     } else {
@@ -114,32 +114,29 @@ void CommonTasks::dumpTask(TaskType type)
         cout << setw(8) << "ID";
         cout << setw(20) << "First point ID";
         cout << setw(20) << "Second point ID" << endl;
-        std::set<EdgePointer *>::const_iterator it;
-        for (it = needUpdateAngles.begin();
-             it != needUpdateAngles.end(); ++it) {
-            cout << setw(8) << (*it)->edge->getID();
-            if ((*it)->orient == OrientLeft)
+        for (int i = 0; i < needUpdateAngles.getNumSlot(); ++i) {
+            EdgePointer *edgePointer = needUpdateAngles.getSlot(i);
+            if (edgePointer == NULL)
+                continue;
+            cout << setw(8) << edgePointer->edge->getID();
+            if (edgePointer->orient == OrientLeft)
                 cout << setw(8) << "left";
             else
                 cout << setw(8) << "right";
-            cout << setw(8) << (*it)->getID();
-            cout << setw(20) << (*it)->getEndPoint(FirstPoint)->getID();
-            cout << setw(20) << (*it)->getEndPoint(SecondPoint)->getID();
+            cout << setw(8) << edgePointer->getID();
+            cout << setw(20) << edgePointer->getEndPoint(FirstPoint)->getID();
+            cout << setw(20) << edgePointer->getEndPoint(SecondPoint)->getID();
             cout << endl;
         }
     } else if (type == RemoveObject) {
         cout << "To be removed edges:" << endl;
-        std::set<Edge *>::const_iterator it1;
-        for (it1 = needRemoveEdges.begin();
-             it1 != needRemoveEdges.end(); ++it1) {
-            cout << setw(8) << (*it1)->getID() << endl;
-        }
+        for (int i = 0; i < needRemoveEdges.getNumSlot(); ++i)
+            if (needRemoveEdges.getSlot(i) != NULL)
+                cout << setw(8) << needRemoveEdges.getSlot(i)->getID() << endl;
         cout << "To be removed vertices:" << endl;
-        std::set<Vertex *>::const_iterator it2;
-        for (it2 = needRemoveVertices.begin();
-             it2 != needRemoveVertices.end(); ++it2) {
-            cout << setw(8) << (*it2)->getID() << endl;
-        }
+        for (int i = 0; i < needRemoveVertices.getNumSlot(); ++i)
+            if (needRemoveVertices.getSlot(i) != NULL)
+                cout << setw(8) << needRemoveVertices.getSlot(i)->getID() << endl;
     } else {
         REPORT_ERROR("Unknown task type!");
     }
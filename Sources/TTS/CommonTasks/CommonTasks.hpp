@@ -1,11 +1,9 @@
 #ifndef CommonTasks_h
 #define CommonTasks_h
 
-#include <set>
+#include "Edge.hpp"
+#include "StampedQueue.hpp"
 
-class EdgePointer;
-class Edge;
-class Vertex;
 class PolygonManager;
 
 class CommonTasks
@@ -31,9 +29,9 @@ public:
     static void dumpTask(TaskType);
 
 private:
-    static std::set<EdgePointer *> needUpdateAngles;
-    static std::set<Edge *> needRemoveEdges;
-    static std::set<Vertex *> needRemoveVertices;
+    static StampedQueue<EdgePointer, &EdgePointer::taskStamp> needUpdateAngles;
+    static StampedQueue<Edge, &Edge::taskStamp> needRemoveEdges;
+    static StampedQueue<Vertex, &Vertex::taskStamp> needRemoveVertices;
 };
 
 #endif
@@ -0,0 +1,148 @@
+#include "ConservationMonitor.hpp"
+#include "TracerManager.hpp"
+#include "TimeManager.hpp"
+#include "ConfigTools.hpp"
+#include "CompensatedSum.hpp"
+#include "MetricsWriter.hpp"
+#include <vector>
+
+using std::vector;
+
+namespace ConservationMonitor
+{
+    static double tolerance = 1.0e-10;
+    static vector<double> initialMasses;
+    static vector<CompensatedSum> totalMasses;
+    // maximum relative remapping error since the last check
+    static vector<double> remapErrors;
+    static double initialArea = 0.0;
+
+    inline void resize(int tracerId)
+    {
+        if (tracerId >= static_cast<int>(totalMasses.size())) {
+            initialMasses.resize(tracerId+1, 0.0);
+            totalMasses.resize(tracerId+1);
+            remapErrors.resize(tracerId+1, 0.0);
+        }
+    }
+
+    inline double calcRelativeError(double mass, double reference)
+    {
+        return reference != 0.0 ? (mass-reference)/reference : mass;
+    }
+}
+
+using namespace ConservationMonitor;
+
+void ConservationMonitor::init()
+{
+    MetricsWriter::describe("mass", "tracer  total  drift  remap_error");
+    MetricsWriter::describe("recount", "tracer  total  drift");
+    MetricsWriter::describe("area", "-  total  drift");
+    if (ConfigTools::hasKey("conservation_tolerance"))
+        ConfigTools::read("conservation_tolerance", tolerance);
+    if (ConfigTools::hasKey("conservation_recount_frequency")) {
+        int frequency;
+        ConfigTools::read("conservation_recount_frequency", frequency);
+        TimeManager::setAlarm("conservation recount", frequency);
+    }
+#ifdef DEBUG
+    else
+        TimeManager::setAlarm("conservation recount", 1);
+#endif
+}
+
+void ConservationMonitor::setMass(int tracerId, double mass)
+{
+    resize(tracerId);
+    initialMasses[tracerId] = mass;
+    totalMasses[tracerId].reset(mass);
+}
+
+void ConservationMonitor::addMass(int tracerId, double mass)
+{
+    // Note: The changes before the tracer mass is set are not tracked.
+    if (tracerId < static_cast<int>(totalMasses.size()))
+        totalMasses[tracerId].add(mass);
+}
+
+void ConservationMonitor::recordRemap(int tracerId, double sourceMass,
+                                      double targetMass)
+{
+    resize(tracerId);
+    double error = calcRelativeError(targetMass, sourceMass);
+    if (fabs(error) > fabs(remapErrors[tracerId]))
+        remapErrors[tracerId] = error;
+    if (fabs(error) > tolerance) {
+        Message message;
+        message << "Mass error (" << error << ") of remapping tracer ";
+        message << tracerId << " is too large!";
+        REPORT_ERROR(message.str());
+    }
+}
+
+double ConservationMonitor::getMass(int tracerId)
+{
+    return tracerId < static_cast<int>(totalMasses.size()) ?
+        totalMasses[tracerId].getSum() : 0.0;
+}
+
+void ConservationMonitor::check(TracerManager &tracerManager)
+{
+    int numTracer = tracerManager.getTracerNum();
+    resize(numTracer-1);
+    for (int l = 0; l < numTracer; ++l) {
+        double mass = totalMasses[l].getSum();
+        double drift = calcRelativeError(mass, initialMasses[l]);
+        std::ostream &metrics = MetricsWriter::record("mass");
+        metrics << tracerManager.getTracerName(l) << "  ";
+        metrics << std::scientific << setprecision(16) << mass << "  ";
+        metrics << drift << "  " << remapErrors[l] << endl;
+        remapErrors[l] = 0.0;
+        if (fabs(drift) > tolerance) {
+            Message message;
+            message << "Mass drift (" << drift << ") of tracer \"";
+            message << tracerManager.getTracerName(l) << "\" is too large!";
+            REPORT_ERROR(message.str());
+        }
+    }
+    // -------------------------------------------------------------------------
+    if (!TimeManager::isAlarmed("conservation recount")) {
+        MetricsWriter::flush();
+        return;
+    }
+    PolygonManager &polygonManager = tracerManager.polygonManager;
+    vector<CompensatedSum> masses(numTracer);
+    CompensatedSum area;
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int i = 0; i < polygonManager.polygons.size(); ++i) {
+        for (int l = 0; l < numTracer; ++l)
+            masses[l].add(polygon->getTracerMass(l));
+        area.add(polygon->getArea());
+        polygon = polygon->next;
+    }
+    // Note: The drifts of the recounted masses are against the tracked ones,
+    //       so they show the leaks that are not reported to the monitor.
+    for (int l = 0; l < numTracer; ++l) {
+        double drift = calcRelativeError(masses[l].getSum(),
+                                         totalMasses[l].getSum());
+        std::ostream &metrics = MetricsWriter::record("recount");
+        metrics << tracerManager.getTracerName(l) << "  ";
+        metrics << std::scientific << setprecision(16);
+        metrics << masses[l].getSum() << "  " << drift << endl;
+        if (fabs(drift) > tolerance) {
+            Message message;
+            message << "Recounted mass of tracer \"";
+            message << tracerManager.getTracerName(l) << "\" differs from ";
+            message << "the tracked one by " << drift << "!";
+            REPORT_ERROR(message.str());
+        }
+    }
+    if (initialArea == 0.0)
+        initialArea = area.getSum();
+    std::ostream &metrics = MetricsWriter::record("area");
+    metrics << "-  " << std::scientific << setprecision(16);
+    metrics << area.getSum() << "  ";
+    metrics << calcRelativeError(area.getSum(), initialArea) << endl;
+    MetricsWriter::flush();
+}
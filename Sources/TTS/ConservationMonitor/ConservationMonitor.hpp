@@ -0,0 +1,41 @@
+#ifndef ConservationMonitor_h
+#define ConservationMonitor_h
+
+class TracerManager;
+
+// -----------------------------------------------------------------------------
+// ConservationMonitor keeps the total mass of each tracer without summing over
+// the polygons. The total is set when the tracer masses are given (initial
+// condition), and every later operation that moves mass between polygons
+// (handoverTracers, remapping between polygons) reports the change of the
+// total, which is accumulated with compensated summation. The drifts against
+// the initial masses and the remapping errors are written into the metrics
+// file (see MetricsWriter) on each step as the "mass" records, so the checks
+// are cheap enough to be always on. The full recount of masses and area is
+// done when "conservation recount" is alarmed.
+//
+// Configuration keys:
+//   conservation_tolerance          relative error to stop the run (1.0e-10)
+//   conservation_recount_frequency  steps between full recounts
+
+namespace ConservationMonitor
+{
+    void init();
+
+    // set the total mass of a tracer, which is the reference of its drift
+    void setMass(int tracerId, double mass);
+
+    // record the change of the total mass of a tracer
+    void addMass(int tracerId, double mass);
+
+    // record the mass error of remapping a tracer
+    void recordRemap(int tracerId, double sourceMass, double targetMass);
+
+    // return the tracked total mass of a tracer
+    double getMass(int tracerId);
+
+    // write the metrics of this step, and recount if it is the time
+    void check(TracerManager &tracerManager);
+}
+
+#endif
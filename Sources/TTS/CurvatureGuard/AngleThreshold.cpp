@@ -9,6 +9,8 @@ using namespace CurvatureGuard;
 Array<double, 1> AngleThreshold::A;
 Array<double, 1> AngleThreshold::L;
 Array<double, 1> AngleThreshold::R;
+ThresholdFunction::PiecewiseCubic AngleThreshold::angleFunction;
+ThresholdFunction::PiecewiseCubic AngleThreshold::relaxFunction;
 
 void AngleThreshold::init()
 {
@@ -22,12 +24,14 @@ void AngleThreshold::init()
     ConfigTools::read("relax_factor", R.size(), R.data());
     L *= Sphere::radius/Rad2Deg;
     A /= Rad2Deg;
+    angleFunction.init(L.size(), L.data(), A.data());
+    relaxFunction.init(L.size(), L.data(), R.data());
 }
 
 void AngleThreshold::calc(Edge *edge, double &a)
 {
     double l = edge->getLength();
-    a = ThresholdFunction::piecewiseCubic(A.size(), L.data(), A.data(), l);
+    a = angleFunction(l);
 }
 
 void AngleThreshold::calc(Edge *edge1, Edge *edge2, double &a)
@@ -41,5 +45,10 @@ void AngleThreshold::calc(Edge *edge1, Edge *edge2, double &a)
 void AngleThreshold::relax(Edge *edge1, Edge *edge2, double &a)
 {
     double l = fmax(edge1->getLength(), edge2->getLength());
-    a *= ThresholdFunction::piecewiseCubic(R.size(), L.data(), R.data(), l);
+    a *= relaxFunction(l);
+}
+
+void AngleThreshold::calc(int n, const double *l, double *a)
+{
+    angleFunction.evaluate(n, l, a);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 class Edge;
 
+#include "ThresholdFunction.hpp"
 #include <blitz/array.h>
 
 using blitz::Array;
@@ -21,8 +22,13 @@ namespace CurvatureGuard
         static void calc(Edge *edge1, Edge *edge2, double &a);
         static void relax(Edge *edge1, Edge *edge2, double &a);
 
+        // calculate the thresholds of n edge lengths in one pass
+        static void calc(int n, const double *l, double *a);
+
     private:
         static Array<double, 1> A, L, R;
+        static ThresholdFunction::PiecewiseCubic angleFunction;
+        static ThresholdFunction::PiecewiseCubic relaxFunction;
     };
 }
 
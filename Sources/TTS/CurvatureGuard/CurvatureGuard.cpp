@@ -6,6 +6,7 @@
 #include "ApproachDetector.hpp"
 #include "TTS.hpp"
 #include "CommonTasks.hpp"
+#include "SweptEdgeDetector.hpp"
 #ifdef DEBUG
 #include "DebugTools.hpp"
 #endif
@@ -37,6 +38,12 @@ void CurvatureGuard::guard(MeshManager &meshManager,
     }
     // -------------------------------------------------------------------------
     start = clock();
+    SweptEdgeDetector::build(polygonManager);
+    end = clock();
+    cout << "[Timing]: CurvatureGuard::SweptEdgeDetector::build: ";
+    cout << setprecision(5) << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
+    // -------------------------------------------------------------------------
+    start = clock();
     if (splitEdges(meshManager, flowManager, polygonManager)) flag = true;
     // -------------------------------------------------------------------------
     end = clock();
@@ -64,6 +71,7 @@ void CurvatureGuard::guard(MeshManager &meshManager,
     // -------------------------------------------------------------------------
     ApproachDetector::reset(polygonManager);
     CommonTasks::resetTasks();
+    SweptEdgeDetector::clear();
 #ifdef TTS_OUTPUT
     // -------------------------------------------------------------------------
     // reindex the vertices and edges for outputting
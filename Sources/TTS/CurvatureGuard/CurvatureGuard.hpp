@@ -15,8 +15,10 @@ namespace CurvatureGuard
 
     void guard(MeshManager &, const FlowManager &, PolygonManager &);
     
+    // Note: A negative a0 means the angle threshold should be calculated.
     bool splitEdge(MeshManager &, const FlowManager &, PolygonManager &,
-                   Edge *edge, bool isChecked = false, bool isMustSplit = false);
+                   Edge *edge, bool isChecked = false, bool isMustSplit = false,
+                   double a0 = -1.0);
     bool splitEdges(MeshManager &, const FlowManager &, PolygonManager &);
 
     bool mergeEdges(MeshManager &, const FlowManager &, PolygonManager &);
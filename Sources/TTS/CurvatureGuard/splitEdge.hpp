@@ -8,6 +8,7 @@
 #include "CurvatureGuard.hpp"
 #include "TTS.hpp"
 #include "CommonTasks.hpp"
+#include <vector>
 #ifdef DEBUG
 #include "DebugTools.hpp"
 #endif
@@ -17,7 +18,8 @@ using namespace PotentialCrossDetector;
 bool CurvatureGuard::splitEdge(MeshManager &meshManager,
                                const FlowManager &flowManager,
                                PolygonManager &polygonManager,
-                               Edge *edge, bool isChecked, bool isMustSplit)
+                               Edge *edge, bool isChecked, bool isMustSplit,
+                               double a0)
 {
     Vertex *vertex1, *vertex2;    // two end points of the old edge
     Vertex *newVertex;
@@ -29,7 +31,6 @@ bool CurvatureGuard::splitEdge(MeshManager &meshManager,
     EdgePointer *newEdgePointer1, *newEdgePointer2;
     bool isUpdateAngles;
     Location loc;
-    double a0;
 
 #ifdef DEBUG
     assert(edge->getLength() != 0.0);
@@ -45,7 +46,8 @@ bool CurvatureGuard::splitEdge(MeshManager &meshManager,
     if (!isMustSplit) {
         testPoint->calcAngle();
         testPoint->calcOrient();
-        CurvatureGuard::AngleThreshold::calc(edge, a0);
+        if (a0 < 0.0)
+            CurvatureGuard::AngleThreshold::calc(edge, a0);
     }
 
     if (PI-testPoint->getAngle() > a0 || isMustSplit) {
@@ -134,11 +136,32 @@ bool CurvatureGuard::splitEdges(MeshManager &meshManager,
                                 const FlowManager &flowManager,
                                 PolygonManager &polygonManager)
 {
+    static std::vector<double> lengths, thresholds;
     bool isSplit = false;
+    // -------------------------------------------------------------------------
+    // calculate the angle thresholds of the existing edges in one pass
+    int numEdge = polygonManager.edges.size();
+    lengths.resize(numEdge);
+    thresholds.resize(numEdge);
     Edge *edge = polygonManager.edges.front(), *nextEdge;
-    while (edge != NULL) {
+    for (int i = 0; i < numEdge; ++i) {
+        lengths[i] = edge->getLength();
+        edge = edge->next;
+    }
+    if (numEdge > 0)
+        CurvatureGuard::AngleThreshold::calc(numEdge, &lengths[0], &thresholds[0]);
+    // -------------------------------------------------------------------------
+    // Note: The threshold only depends on the edge length, so it is reused
+    //       when the length is not changed, and the new edges are calculated
+    //       on the fly.
+    edge = polygonManager.edges.front();
+    for (int i = 0; edge != NULL; ++i) {
         nextEdge = edge->next;
-        if (splitEdge(meshManager, flowManager, polygonManager, edge))
+        double a0 = -1.0;
+        if (i < numEdge && edge->getLength() == lengths[i])
+            a0 = thresholds[i];
+        if (splitEdge(meshManager, flowManager, polygonManager, edge,
+                      false, false, a0))
             isSplit = true;
         edge = nextEdge;
     }
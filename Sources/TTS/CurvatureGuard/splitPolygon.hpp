@@ -282,7 +282,7 @@ bool handleApproachEvents(MeshManager &meshManager,
 #endif
 
     while (!ApproachingVertices::isEmpty()) {
-        vertex3 = ApproachingVertices::vertices.front();
+        vertex3 = ApproachingVertices::front();
 //        if (TimeManager::getSteps() >= 686 && (vertex3->getID() == 1743113))
 //            REPORT_DEBUG;
         // ---------------------------------------------------------------------
@@ -349,7 +349,7 @@ bool handleApproachEvents(MeshManager &meshManager,
         // check if there is another edge that blocks the approaching path of
         // vertex3 and will be crossed if we handle this approaching event
         bool hasAnotherEdge = false;
-        list<Projection>::iterator itPrj;
+        VertexAgent::ProjectionMap::iterator itPrj;
         for (itPrj = vertex3->detectAgent.getProjections().begin();
              itPrj != vertex3->detectAgent.getProjections().end(); ++itPrj) {
             Edge *edge2 = (*itPrj).getEdge();
@@ -3,500 +3,179 @@
 #include "RLLMesh.hpp"
 #include "Sphere.hpp"
 #include "ReportMacros.hpp"
+#include <algorithm>
 
 CoverMask::CoverMask(const RLLMesh &mesh)
 {
     this->mesh = &mesh;
+    numLon = mesh.getNumLon()-2;
+    numLat = mesh.getNumLat();
+    I0 = 0; J0 = 0; numCellLon = 0; numCellLat = 0;
+    isCycle = false;
 }
 
 CoverMask::~CoverMask()
 {
 }
 
-void CoverMask::init(Polygon *polygon, map<int, list<int> > &bndCellIdx,
-                     Location::Pole pole, const RLLMesh &meshBnd, bool debug)
+void CoverMask::init(Polygon *polygon, bool debug)
 {
-    isCycle = pole != Location::Null;
+    // -------------------------------------------------------------------------
+    // sort the crossed cells into latitude rows
+    std::sort(bndCells.begin(), bndCells.end());
+    bndCells.erase(std::unique(bndCells.begin(), bndCells.end()),
+                   bndCells.end());
+    columns.resize(bndCells.size());
+    for (int k = 0; k < static_cast<int>(bndCells.size()); ++k)
+        columns[k] = bndCells[k]%numLon;
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
     // -------------------------------------------------------------------------
     // get the bounding box
-    int numCellLon = static_cast<int>(bndCellIdx.size()), numCellLat = 0;
-    int J0 = -1, J1 = -1; // reference index
-    int offset = 0; // offset due to the inclusion of north pole
-    map<int, list<int> >::iterator itIdxIJ1 = bndCellIdx.begin();
-    map<int, list<int> >::iterator itIdxIJ2 = bndCellIdx.end();
-    map<int, list<int> >::iterator itIdxIJ3 = bndCellIdx.end();
-    map<int, list<int> >::iterator itIdxIJ4 = bndCellIdx.end();
-    map<int, list<int> >::iterator itIdxIJ  = bndCellIdx.begin();
-    map<int, list<int> >::iterator itIdxIJ0 = bndCellIdx.begin();
-    for (++itIdxIJ0; itIdxIJ != bndCellIdx.end(); ++itIdxIJ, ++itIdxIJ0) {
-        if (itIdxIJ0 != bndCellIdx.end() &&
-            (*itIdxIJ).first+1 != (*itIdxIJ0).first) {
-            itIdxIJ2 = itIdxIJ0;
-            itIdxIJ3 = itIdxIJ0;
-        }
-        (*itIdxIJ).second.sort();
-        (*itIdxIJ).second.unique();
-        if (J0 == -1)
-            J0 = (*itIdxIJ).second.front();
-        else if (J0 > (*itIdxIJ).second.front())
-            J0 = (*itIdxIJ).second.front();
-        if (J1 == -1)
-            J1 = (*itIdxIJ).second.back();
-        else if (J1 < (*itIdxIJ).second.back())
-            J1 = (*itIdxIJ).second.back();
+    // Note: Here we assume that if the crossed cells cover the whole zonal
+    //       range, then the pole has been included.
+    int numColumn = static_cast<int>(columns.size());
+    Location::Pole pole = Location::Null;
+    if (numColumn == numLon) {
+        pole = polygon->edgePointers.front()->getEndPoint(FirstPoint)->
+            getCoordinate().getLat() > 0.0 ?
+            Location::NorthPole : Location::SouthPole;
+        I0 = 0;
+        numCellLon = numLon;
+    } else {
+        // the box starts after the largest zonal gap between the columns
+        int k0 = 0, maxGap = columns[0]+numLon-columns[numColumn-1];
+        for (int k = 1; k < numColumn; ++k)
+            if (columns[k]-columns[k-1] > maxGap) {
+                maxGap = columns[k]-columns[k-1];
+                k0 = k;
+            }
+        I0 = columns[k0];
+        numCellLon = numLon-maxGap+1;
     }
+    isCycle = pole != Location::Null;
+    J0 = bndCells.front()/numLon;
+    int J1 = bndCells.back()/numLon;
+    if (pole == Location::NorthPole)
+        J0 = 0;
+    else if (pole == Location::SouthPole)
+        J1 = numLat-1;
     numCellLat = J1-J0+1;
-    if (pole == Location::NorthPole) {
-        offset = J0;
-        numCellLat += J0;
-    } else if (pole == Location::SouthPole) {
-        offset = numCellLat;
-        numCellLat += meshBnd.getNumLat()-2-J1;
-    }
     // -------------------------------------------------------------------------
-    // initialize the index map
-    idxI.resize(numCellLon);
-    idxJ.resize(numCellLat);
-    if (pole == Location::NorthPole)
-        for (int j = 0; j < J0; ++j)
-            idxJ(j) = j;
-    else if (pole == Location::SouthPole) {
-        int i = 1;
-        for (int j = offset; j < numCellLat; ++j)
-            idxJ(j) = J1+(i++);
-        offset = 0;
+    // set the crossed cells
+    int numWord = (numCellLon*numCellLat+31)/32;
+    crossed.assign(numWord, 0u);
+    covered.assign(numWord, 0u);
+    coveredCells.clear();
+    for (int k = 0; k < static_cast<int>(bndCells.size()); ++k) {
+        int i = (bndCells[k]%numLon-I0+numLon)%numLon;
+        int j = bndCells[k]/numLon-J0;
+        setBit(crossed, i, j);
     }
-    // -------------------------------------------------------------------------
-    // set the first guess cover mask
-    mask.resize(numCellLon, numCellLat);
-    mask = NoOverlap;
-    int i = 0, j, J;
-    // =========================================================================
-    // Note: The following complicated codes are due to the zonal periodic
-    //       boundary condition, please forgive me!
-    // second part if the polygon crosses lon = 0 meridinal line
-    for (itIdxIJ = itIdxIJ3; itIdxIJ != itIdxIJ4; ++itIdxIJ, ++i) {
-        idxI(i) = (*itIdxIJ).first;
-        j = (*itIdxIJ).second.front()-J0+offset;
-        list<int>::const_iterator itIdxJ1 = (*itIdxIJ).second.begin();
-        idxJ(j) = *itIdxJ1;
-        mask(i, j++) = CrossedByEdges;
-        list<int>::const_iterator itIdxJ2 = itIdxJ1;
-        for (++itIdxJ1; itIdxJ1 != (*itIdxIJ).second.end(); ++itIdxJ1) {
-            if (*itIdxJ1-*itIdxJ2 != 1) {
-                for (J = *itIdxJ2+1; J < *itIdxJ1; ++J) {
-                    idxJ(j) = J;
-                    mask(i, j++) = PotentialCovered;
-                }
-                idxJ(j) = J;
-                mask(i, j++) = CrossedByEdges;
-            } else {
-                idxJ(j) = *itIdxJ1;
-                mask(i, j++) = CrossedByEdges;
-            }
-            itIdxJ2++;
-        }
-    }
-    // first part
-    for (itIdxIJ = itIdxIJ1; itIdxIJ != itIdxIJ2; ++itIdxIJ, ++i) {
-        idxI(i) = (*itIdxIJ).first;
-        j = (*itIdxIJ).second.front()-J0+offset;
-        list<int>::const_iterator itIdxJ1 = (*itIdxIJ).second.begin();
-        idxJ(j) = *itIdxJ1;
-        mask(i, j++) = CrossedByEdges;
-        list<int>::const_iterator itIdxJ2 = itIdxJ1;
-        for (++itIdxJ1; itIdxJ1 != (*itIdxIJ).second.end(); ++itIdxJ1) {
-            if (*itIdxJ1-*itIdxJ2 != 1) {
-                for (J = *itIdxJ2+1; J < *itIdxJ1; ++J) {
-                    idxJ(j) = J;
-                    mask(i, j++) = PotentialCovered;
-                }
-                idxJ(j) = J;
-                mask(i, j++) = CrossedByEdges;
-            } else {
-                idxJ(j) = *itIdxJ1;
-                mask(i, j++) = CrossedByEdges;
-            }
-            itIdxJ2++;
-        }
-    }
-    // =========================================================================
-    // set the cells that will be determined to be covered due the coverage of
-    // pole by the polygon
-    // Note: use "ray casting algorithm" to test if pole is covered
-    if (pole != Location::Null) {
-        bool isPoleCovered = false;
-        EdgePointer *edgePointer = polygon->edgePointers.front();
-        for (int i = 0; i < polygon->edgePointers.size(); ++i) {
-            Vertex *vertex1 = edgePointer->getEndPoint(FirstPoint);
-            Vertex *vertex2 = edgePointer->getEndPoint(SecondPoint);
-            double x1 = vertex1->getCoordinate().getX();
-            double y1 = vertex1->getCoordinate().getY();
-            double x2 = vertex2->getCoordinate().getX();
-            double y2 = vertex2->getCoordinate().getY();
-            if (((y1 > 0.0) != (y2 > 0.0)) &&
-                ((x2-x1)*(-y1)/(y2-y1)+x1 > 0.0))
-                isPoleCovered = !isPoleCovered;
-            edgePointer = edgePointer->next;
-        }
-        if (isPoleCovered) {
-            if (pole == Location::NorthPole) {
-                for (int i = 0; i < mask.extent(0); ++i)
-                    for (int j = 0; j < mask.extent(1); ++j)
-                        if (mask(i, j) == NoOverlap)
-                            mask(i, j) = FullyCoveredNearPole;
-                        else
-                            break;
-            } else {
-                for (int i = 0; i < mask.extent(0); ++i)
-                    for (int j = mask.extent(1)-1; j >= 0; --j)
-                        if (mask(i, j) == NoOverlap)
-                            mask(i, j) = FullyCoveredNearPole;
-                        else
-                            break;
-            }
-        }
-    }
-return_label:
 #ifdef DEBUG
     if (debug) dump();
 #endif
-    return;
 }
 
 void CoverMask::searchCover(Polygon *polygon, bool debug)
 {
-    // set the cell that has been fully covered
-    bool isFirstCoveredCell;
-    for (int i = 0; i < mask.extent(0); ++i)
-        for (int j = 0; j < mask.extent(1); ++j) {
-            isFirstCoveredCell = true;
-            isCovered(polygon, -1, -1, i, j, isFirstCoveredCell);
+    for (int j = 0; j < numCellLat; ++j) {
+        int first = -1, last = -1;
+        for (int i = 0; i < numCellLon; ++i)
+            if (isCrossed(i, j)) {
+                if (first == -1) first = i;
+                last = i;
+            }
+        // Note: Only the rows between the pole and the polygon may have no
+        //       crossed cell.
+        if (first == -1) {
+            fillSpan(polygon, 0, numCellLon, j);
+            continue;
+        }
+        // Note: The cells out of the first and last crossed cells are outside
+        //       of the polygon unless the box is zonally periodic.
+        int i1 = first+1, i2 = isCycle ? first+numCellLon : last;
+        while (i1 < i2) {
+            if (isCrossed(i1%numCellLon, j)) {
+                ++i1;
+                continue;
+            }
+            int n = 1;
+            while (i1+n < i2 && !isCrossed((i1+n)%numCellLon, j))
+                ++n;
+            fillSpan(polygon, i1%numCellLon, n, j);
+            i1 += n;
+        }
 #ifdef DEBUG
-            if (debug) dump(i, j);
+        if (debug) dump(-1, j);
 #endif
-        }
+    }
 }
 
-bool CoverMask::isCovered(Polygon *polygon, int i0, int j0, int i, int j,
-                          bool &isFirstCoveredCell)
+void CoverMask::fillSpan(Polygon *polygon, int i0, int n, int j)
 {
-    // -------------------------------------------------------------------------
-    if (mask(i, j) > 0)
-        return true;
-    else if (mask(i, j) == 0)
-        return false;
-    // -------------------------------------------------------------------------
-    int ii, jj;
-    // =========================================================================
-    // check left-top cells
-    ii = i-1, jj = j-1;
-    while (true) {
-        if (jj == -1)
-            goto return_not_covered;
-        if (ii < 0)
-            if (isCycle)
-                ii += mask.extent(0);
-            else
-                goto return_not_covered;
-        if (mask(ii, jj) > 0)
-            break;
-        else if (mask(ii, jj) == NoOverlap)
-            goto return_not_covered;
-        else if (mask(ii, jj) == PotentialCovered) {
-            if (ii == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        --ii, --jj;
-    }
-    // =========================================================================
-    // left cells
-    ii = i-1;
-    while (true) {
-        if (ii < 0)
-            if (isCycle)
-                ii += mask.extent(0);
-            else
-                goto return_not_covered;
-        if (mask(ii, j) > 0)
-            break;
-        else if (mask(ii, j) == NoOverlap)
-            goto return_not_covered;
-        else if (mask(ii, j) == PotentialCovered) {
-            if (ii == i0 && j == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, j, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        --ii;
-    }
-    // =========================================================================
-    // left-right cells
-    ii = i-1, jj = j+1;
-    while (true) {
-        if (jj == mask.extent(1))
-            goto return_not_covered;
-        if (ii < 0)
-            if (isCycle)
-                ii += mask.extent(0);
-            else
-                goto return_not_covered;
-        if (mask(ii, jj) > 0)
-            break;
-        else if (mask(ii, jj) == NoOverlap)
-            goto return_not_covered;
-        else if (mask(ii, jj) == PotentialCovered) {
-            if (ii == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        --ii, ++jj;
-    }
-    // =========================================================================
-    // top cells
-    jj = j-1;
-    while (true) {
-        if (jj == -1)
-            goto return_not_covered;
-        if (mask(i, jj) > 0)
-            break;
-        else if (mask(i, jj) == PotentialCovered) {
-            if (i == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, i, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        --jj;
-    }
-    // =========================================================================
-    // bottom cells
-    jj = j+1;
-    while (true) {
-        if (jj == mask.extent(1))
-            goto return_not_covered;
-        if (mask(i, jj) > 0)
-            break;
-        else if (mask(i, jj) == PotentialCovered) {
-            if (i == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, i, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        ++jj;
-    }
-    // =========================================================================
-    // right-top cells
-    ii = i+1, jj = j-1;
-    while (true) {
-        if (jj == -1)
-            goto return_not_covered;
-        if (ii == mask.extent(0))
-            if (isCycle)
-                ii = 0;
-            else
-                goto return_not_covered;
-        if (mask(ii, jj) > 0)
-            break;
-        else if (mask(ii, jj) == PotentialCovered) {
-            if (ii == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        ++ii, --jj;
-    }
-    // =========================================================================
-    // right cells
-    ii = i+1;
-    while (true) {
-        if (ii == mask.extent(0))
-            if (isCycle)
-                ii = 0;
-            else
-                goto return_not_covered;
-        if (mask(ii, j) > 0)
-            break;
-        else if (mask(ii, j) == PotentialCovered) {
-            if (ii == i0 && j == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, j, isFirstCoveredCell))
-                goto return_not_covered;
-            else
-                break;
-        }
-        ++ii;
-    }
-    // =========================================================================
-    // right-bottom cells
-    ii = i+1, jj = j+1;
-    while (true) {
-        if (jj == mask.extent(1))
-            goto return_not_covered;
-        if (ii == mask.extent(0))
-            if (isCycle)
-                ii = 0;
-            else
-                goto return_not_covered;
-        if (mask(ii, jj) > 0)
-            break;
-        else if (mask(ii, jj) == PotentialCovered) {
-            if (ii == i0 && jj == j0)
-                break;
-            mask(i, j) = PotentialCoveredPassed;
-            if (!isCovered(polygon, i, j, ii, jj, isFirstCoveredCell))
-                goto return_not_covered;
-            else
+    // Note: No edge passes through the cells of a span, so they are all inside
+    //       or all outside of the polygon. If a cell above is not crossed, it
+    //       is connected to the span and has been decided, otherwise one
+    //       point-in-polygon test is needed.
+    int i, status = -1;
+    if (j > 0)
+        for (int m = 0; m < n; ++m) {
+            i = (i0+m)%numCellLon;
+            if (!isCrossed(i, j-1)) {
+                status = isCovered(i, j-1);
                 break;
+            }
         }
-        ++ii, ++jj;
-    }
-    // -------------------------------------------------------------------------
-    if (isFirstCoveredCell) {
-        // use "ray casting algorithm" to ensure the cell is truely covered
-        Coordinate X0(mesh->lon(idxI(i)+1), mesh->lat(idxJ(j)));
-        bool isCovered = false;
-        EdgePointer *edgePointer = polygon->edgePointers.front();
-        for (int k = 0; k < polygon->edgePointers.size(); ++k) {
-            Vertex *vertex1 = edgePointer->getEndPoint(FirstPoint);
-            Vertex *vertex2 = edgePointer->getEndPoint(SecondPoint);
-            const Coordinate X1 = vertex1->getCoordinate();
-            const Coordinate X2 = vertex2->getCoordinate();
-            Coordinate X1r, X2r;
-            Sphere::rotate(X0, X1, X1r);
-            Sphere::rotate(X0, X2, X2r);
-            double x1 = X1r.getX();
-            double y1 = X1r.getY();
-            double x2 = X2r.getX();
-            double y2 = X2r.getY();
-            if (((y1 > 0.0) != (y2 > 0.0)) &&
-                ((x2-x1)*(-y1)/(y2-y1)+x1 > 0.0))
-                isCovered = !isCovered;
-            edgePointer = edgePointer->next;
-        }
-        isFirstCoveredCell = false;
-        if (isCovered) {
-            mask(i, j) = FullyCovered;
-            return true;
-        } else {
-            mask(i, j) = NoOverlap;
-            return false;
-        }
-    } else {
-        mask(i, j) = FullyCovered;
-        return true;
+    if (status == -1)
+        status = isInside(polygon, i0, j);
+    if (status == 0)
+        return;
+    for (int m = 0; m < n; ++m) {
+        i = (i0+m)%numCellLon;
+        setBit(covered, i, j);
+        coveredCells.push_back((J0+j)*numLon+(I0+i)%numLon);
     }
-return_not_covered:
-    // Note: The search route may forks, and some of the forked may return true,
-    //       some may return false, and the order of the forked routes may cause
-    //       different results, so we should check the result here to ensure
-    //       there will be no false covered masks.
-    mask(i, j) = NoOverlap;
-    checkFalseCover(i, j);
-    return false;
 }
 
-void CoverMask::checkFalseCover(int i, int j)
+bool CoverMask::isInside(Polygon *polygon, int i, int j) const
 {
-    assert(mask(i, j) == NoOverlap);
-    // check the surrounding mask
-    int ii, jj;
-    // left-top cell
-    if (i != 0 && j != 0) {
-        ii = i-1; jj = j-1;
-        if (mask(ii, jj) == FullyCovered) {
-            mask(ii, jj) = NoOverlap;
-            checkFalseCover(ii, jj);
-        }
-    }
-    // left cell
-    if (i != 0) {
-        ii = i-1;
-        if (mask(ii, j) == FullyCovered) {
-            mask(ii, j) = NoOverlap;
-            checkFalseCover(ii, j);
-        }
-    }
-    // left-bottom cell
-    if (i != 0 && j != mask.extent(1)-1) {
-        ii = i-1; jj = j+1;
-        if (mask(ii, jj) == FullyCovered) {
-            mask(ii, jj) = NoOverlap;
-            checkFalseCover(i, jj);
-        }
-    }
-    // top cell
-    if (j != 0) {
-        jj = j-1;
-        if (mask(i, jj) == FullyCovered) {
-            mask(i, jj) = NoOverlap;
-            checkFalseCover(i, jj);
-        }
-    }
-    // bottom cell
-    if (j != mask.extent(1)-1) {
-        jj = j+1;
-        if (mask(i, jj) == FullyCovered) {
-            mask(i, jj) = NoOverlap;
-            checkFalseCover(i, jj);
-        }
-    }
-    // right-top cell
-    if (i != mask.extent(0)-1 && j != 0) {
-        ii = i+1; jj = j-1;
-        if (mask(ii, jj) == FullyCovered) {
-            mask(ii, jj) = NoOverlap;
-            checkFalseCover(ii, jj);
-        }
-    }
-    // right cell
-    if (i != mask.extent(0)-1) {
-        ii = i+1;
-        if (mask(ii, j) == FullyCovered) {
-            mask(ii, j) = NoOverlap;
-            checkFalseCover(ii, j);
-        }
-    }
-    // right-bottom cell
-    if (i != mask.extent(0)-1 && j != mask.extent(1)-1) {
-        ii = i+1; jj = j+1;
-        if (mask(ii, jj) == FullyCovered) {
-            mask(ii, jj) = NoOverlap;
-            checkFalseCover(ii, jj);
-        }
-    }
+    // use "ray casting algorithm" on the cell center
+    Coordinate X0(mesh->lon((I0+i)%numLon+1), mesh->lat(J0+j));
+    bool isInside = false;
+    EdgePointer *edgePointer = polygon->edgePointers.front();
+    for (int k = 0; k < polygon->edgePointers.size(); ++k) {
+        Vertex *vertex1 = edgePointer->getEndPoint(FirstPoint);
+        Vertex *vertex2 = edgePointer->getEndPoint(SecondPoint);
+        const Coordinate X1 = vertex1->getCoordinate();
+        const Coordinate X2 = vertex2->getCoordinate();
+        Coordinate X1r, X2r;
+        Sphere::rotate(X0, X1, X1r);
+        Sphere::rotate(X0, X2, X2r);
+        double x1 = X1r.getX();
+        double y1 = X1r.getY();
+        double x2 = X2r.getX();
+        double y2 = X2r.getY();
+        if (((y1 > 0.0) != (y2 > 0.0)) &&
+            ((x2-x1)*(-y1)/(y2-y1)+x1 > 0.0))
+            isInside = !isInside;
+        edgePointer = edgePointer->next;
+    }
+    return isInside;
 }
 
-void CoverMask::dump(int i, int j)
+void CoverMask::dump(int i, int j) const
 {
     cout << "---------------------------------------------------------" << endl;
-    for (int jj = 0; jj < mask.extent(1); ++jj) {
-        for (int ii = 0; ii < mask.extent(0); ++ii) {
-            if (ii == i && jj == j)
-                cout << " *" << setw(1) << mask(ii, jj);
+    cout << "Box: I = " << I0 << " (" << numCellLon << "), ";
+    cout << "J = " << J0 << " (" << numCellLat << ")" << endl;
+    for (int jj = 0; jj < numCellLat; ++jj) {
+        for (int ii = 0; ii < numCellLon; ++ii) {
+            int mask = isCrossed(ii, jj) ? 1 : isCovered(ii, jj) ? 2 : 0;
+            if (jj == j && (ii == i || i == -1))
+                cout << " *" << setw(1) << mask;
             else
-                cout << setw(3) << mask(ii, jj);
+                cout << setw(3) << mask;
         }
         cout << endl;
     }
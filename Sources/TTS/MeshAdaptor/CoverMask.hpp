@@ -1,17 +1,22 @@
 #ifndef CoverMask_h
 #define CoverMask_h
 
-#include <map>
-#include <list>
-#include <blitz/array.h>
+#include <vector>
 #include "Location.hpp"
 
 class Polygon;
 class RLLMesh;
 
-using std::map;
-using std::list;
-using blitz::Array;
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// CoverMask finds the cells that are fully covered by one polygon. The cells
+// crossed by the polygon edges are added during the edge walk of MeshAdaptor,
+// and they are sorted into the latitude rows of the bounding index box of the
+// polygon. Then the interior spans between the crossed cells of each row are
+// filled as a scanline. The masks are bitsets over the box, and one CoverMask
+// is used by one thread for all its polygons, so the cost is proportional to
+// the cell footprint of the polygon instead of the mesh size.
 
 class CoverMask
 {
@@ -19,27 +24,44 @@ public:
     CoverMask(const RLLMesh &);
     ~CoverMask();
 
-    enum MaskType {
-        NoOverlap = 0, CrossedByEdges = 1,
-        PotentialCovered = -1, PotentialCoveredPassed = 4,
-        FullyCovered = 2, FullyCoveredNearPole = 3 
-    };    
+    void reset() { bndCells.clear(); }
+    void addBndCell(int I, int J) { bndCells.push_back(J*numLon+I); }
 
-    void init(Polygon *polygon, map<int, list<int> > &bndCellIdx,
-              Location::Pole pole, const RLLMesh &meshBnd, bool debug = false);
+    void init(Polygon *polygon, bool debug = false);
     void searchCover(Polygon *polygon, bool debug = false);
-    void dump(int i = -1, int j = -1);
+    void dump(int i = -1, int j = -1) const;
 
-    Array<int, 2> mask;
-    Array<int, 1> idxI, idxJ;
+    int getNumCoveredCell() const {
+        return static_cast<int>(coveredCells.size());
+    }
+    int getCoveredI(int k) const { return coveredCells[k]%numLon; }
+    int getCoveredJ(int k) const { return coveredCells[k]/numLon; }
 
 private:
-    bool isCovered(Polygon *polygon, int i0, int j0, int i, int j,
-                   bool &isFirstCoveredCell);
-    void checkFalseCover(int i, int j);
+    bool isCrossed(int i, int j) const { return testBit(crossed, i, j); }
+    bool isCovered(int i, int j) const { return testBit(covered, i, j); }
+    bool testBit(const vector<unsigned int> &bits, int i, int j) const {
+        int k = j*numCellLon+i;
+        return (bits[k>>5]>>(k&31))&1u;
+    }
+    void setBit(vector<unsigned int> &bits, int i, int j) {
+        int k = j*numCellLon+i;
+        bits[k>>5] |= 1u<<(k&31);
+    }
+    void fillSpan(Polygon *polygon, int i0, int n, int j);
+    bool isInside(Polygon *polygon, int i, int j) const;
 
-    bool isCycle;
     RLLMesh const *mesh;
+    int numLon, numLat;
+    // cells crossed by edges (J*numLon+I), which may be duplicated
+    vector<int> bndCells;
+    // bounding index box, which is periodic in zonal direction
+    int I0, J0, numCellLon, numCellLat;
+    bool isCycle;
+    vector<unsigned int> crossed, covered;
+    vector<int> coveredCells;
+    // working array
+    vector<int> columns;
 };
 
 #endif
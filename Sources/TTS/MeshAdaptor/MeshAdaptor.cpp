@@ -2,15 +2,18 @@
 #include "ReportMacros.hpp"
 #include "Sphere.hpp"
 #include "CoverMask.hpp"
+#include "SupermeshRemapper.hpp"
+#include "ConservationMonitor.hpp"
+#include "CompensatedSum.hpp"
 
-#include <map>
-#include <list>
-
-using std::map;
-using std::list;
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 MeshAdaptor::MeshAdaptor()
 {
+    for (int k = 0; k < NumAdaptPath; ++k)
+        pathCounts[k] = 0;
     REPORT_ONLINE("MeshAdaptor")
 }
 
@@ -22,7 +25,8 @@ MeshAdaptor::~MeshAdaptor()
 void MeshAdaptor::init(const MeshManager &meshManager)
 {
     const PointCounter &pointCounter = meshManager.pointCounter;
-    overlapAreaList.resize(pointCounter.points.shape());
+    overlapTable.init(pointCounter.points.extent(0),
+                      pointCounter.points.extent(1));
 }
 
 inline double MeshAdaptor::calcCorrectArea(const Coordinate &x1,
@@ -117,7 +121,8 @@ double MeshAdaptor::calcOverlapArea(int I, int J, Bnd from, Bnd to,
                                     double lonBnd1, double lonBnd2,
                                     double latBnd1, double latBnd2,
                                     Coordinate x0, EdgePointer *edgePointer0,
-                                    Coordinate x1, EdgePointer *edgePointer1)
+                                    Coordinate x1, EdgePointer *edgePointer1,
+                                    OverlapScratch &scratch)
 {
 #ifdef DEBUG
     assert(from != NullBnd && to != NullBnd);
@@ -128,9 +133,10 @@ double MeshAdaptor::calcOverlapArea(int I, int J, Bnd from, Bnd to,
     Vector normVector0 = edgePointer0->getNormVector();
     Vector normVector1 = edgePointer1->getNormVector();
     int numCellEdge, numPolygonEdge = 1, numEdge;
-    static Array<Vector, 1> normVectors;
-    static Array<Coordinate, 1> x;
-    static Array<double, 1> polygonAngles, angles;
+    Array<Vector, 1> &normVectors = scratch.normVectors;
+    Array<Coordinate, 1> &x = scratch.x;
+    Array<double, 1> &polygonAngles = scratch.polygonAngles;
+    Array<double, 1> &angles = scratch.angles;
     double excess, area;
     // -------------------------------------------------------------------------
     // 
@@ -634,404 +640,532 @@ numerical_tolerance_label:
 }
 
 void MeshAdaptor::recordOverlapArea(double cellArea, int I, int J,
-                                    Bnd from, Bnd to, int bndDiff,
-                                    Polygon *polygon,
                                     double area, double &totalArea,
-                                    list<OverlapArea *> &overlapAreas)
+                                    vector<OverlapRecord> &records, int first)
 {
     // check multiply entried cell
-    list<OverlapArea>::iterator it = overlapAreaList(I, J, 0).begin();
-    for (; it != overlapAreaList(I, J, 0).end(); ++it) {
-        if ((*it).polygon == polygon) {
-            totalArea -= (*it).area;
-            double testArea = (*it).area+area-cellArea;
+    for (int k = first; k < static_cast<int>(records.size()); ++k) {
+        if (records[k].I == I && records[k].J == J) {
+            totalArea -= records[k].area;
+            double testArea = records[k].area+area-cellArea;
             if (testArea > 0.0)
-                (*it).area = testArea;
+                records[k].area = testArea;
             else
-                (*it).area += area;
-            totalArea += (*it).area;
+                records[k].area += area;
+            totalArea += records[k].area;
             return;
         }
     }
-    OverlapArea overlapArea;
-    overlapArea.polygon = polygon;
-    overlapArea.area = area;
-    overlapAreaList(I, J, 0).push_back(overlapArea);
+    OverlapRecord record;
+    record.I = I;
+    record.J = J;
+    record.area = area;
+    records.push_back(record);
     totalArea += area;
-    overlapAreas.push_back(&overlapAreaList(I, J, 0).back());
 }
 
-void MeshAdaptor::recordOverlapArea(double cellArea, int I, int J,
-                                    Polygon *polygon,
-                                    double area, double &totalArea,
-                                    list<OverlapArea *> &overlapAreas)
+// Note: MPFR is not thread-safe here (mpreal uses a global default precision
+//       and its own allocator), so the high precision calculation is done by
+//       one thread at a time.
+inline bool calcIntersectLon(const Coordinate &x1, const Coordinate &x2,
+                             double lon1, double lon2, double lat,
+                             Coordinate &x, bool useMPFR)
 {
-    // check multiply entried cell
-    list<OverlapArea>::iterator it = overlapAreaList(I, J, 0).begin();
-    for (; it != overlapAreaList(I, J, 0).end(); ++it) {
-        if ((*it).polygon == polygon) {
-            totalArea -= (*it).area;
-            double testArea = (*it).area+area-cellArea;
-            if (testArea > 0.0)
-                (*it).area = testArea;
-            else
-                (*it).area += area;
-            totalArea += (*it).area;
-            return;
-        }
-    }
-    OverlapArea overlapArea;
-    overlapArea.polygon = polygon;
-    overlapArea.area = area;
-    overlapAreaList(I, J, 0).push_back(overlapArea);
-    totalArea += area;
-    overlapAreas.push_back(&overlapAreaList(I, J, 0).back());
+    if (!useMPFR)
+        return Sphere::calcIntersectLon(x1, x2, lon1, lon2, lat, x, false);
+    bool res;
+#pragma omp critical (MeshAdaptor_MPFR)
+    res = Sphere::calcIntersectLon(x1, x2, lon1, lon2, lat, x, true);
+    return res;
 }
 
-void MeshAdaptor::adapt(const TracerManager &tracerManager,
-                        const MeshManager &meshManager)
+double MeshAdaptor::adaptPolygon(Polygon *polygon, const RLLMesh &mesh,
+                                 CoverMask &coverMask, AdaptBuffer &buffer,
+                                 AdaptPath &path)
 {
-    NOTICE("MeshAdaptor::adapt", "running ...");
-    const RLLMesh &mesh = meshManager.getMesh(PointCounter::Bound);
     int numLon = mesh.getNumLon()-2;
     int numLat = mesh.getNumLat()-1;
+    int first = static_cast<int>(buffer.records.size());
     // TODO: With the increase of point counter mesh resolution, the threshold
     //       should be changed to capture the fully covered cells.
     const double areaDiffThreshold = 1.0e-3;
-    double totalArea, realArea, diffArea, maxDiffArea = 0.0;
-    map<int, list<int> > bndCellIdx;
-    list<OverlapArea *> overlapAreas;
-    static CoverMask coverMask(meshManager.getMesh(PointCounter::Center));
-    // -------------------------------------------------------------------------
-    // reset
-    for (int i = 0; i < overlapAreaList.extent(0); ++i)
-        for (int j = 0; j < overlapAreaList.extent(1); ++j)
-            overlapAreaList(i, j, 0).clear();
-    // -------------------------------------------------------------------------
-    // calculate the overlap area between polygon and mesh
-    Polygon *polygon = tracerManager.polygonManager.polygons.front();
-    for (int m = 0; m < tracerManager.polygonManager.polygons.size(); ++m) {
-        bool isTolerated = false;
+    double totalArea, realArea, diffArea;
+    bool isTolerated = false;
 #ifdef DEBUG
-        bool debug = false;
-        int counter = 0;
+    bool debug = false;
+    int counter = 0;
 //        if (TimeManager::getSteps() == 2 && polygon->getID() == 17285) {
 //            polygon->dump("polygon");
 //            REPORT_DEBUG;
 //            debug = true;
 //        }
 #endif
-        // record the previous edge and intersection
-        EdgePointer *edgePointer0 = NULL; Coordinate x0;
-        // record the starting edge and intersection
-        EdgePointer *edgePointer00 = NULL; Coordinate x00;
-        // record the coming and going boundary
-        Bnd from0, to0, to00, from = NullBnd;
-        // record the previous cell index
-        int I0, J0;
-        // reset
-        totalArea = 0.0; realArea = polygon->getArea(NewTimeLevel);
-        bndCellIdx.clear();
-        overlapAreas.clear();
-        // internal variables
-        int I, J, I1, I2, J1, J2, bndDiff;
-        double lonBnd1, lonBnd2, latBnd1, latBnd2;
-        Coordinate x;
-        // Note: The calculation of intersection between great-circle arc and
-        //       latitudinal line may fail under normal double precision
-        //       floating-point calculation, so swith to MPFR if necessary.
-        bool useMPFR;
-        // ---------------------------------------------------------------------
-        // search overlapped mesh cell along polygon edges
-        EdgePointer *edgePointer = polygon->edgePointers.front();
-        for (int n = 0; n < polygon->edgePointers.size(); ++n) {
-            Vertex *vertex1 = edgePointer->getEndPoint(FirstPoint);
-            Vertex *vertex2 = edgePointer->getEndPoint(SecondPoint);
-            const Coordinate &x1 = vertex1->getCoordinate();
-            const Coordinate &x2 = vertex2->getCoordinate();
-            I1 = vertex1->getLocation().i[4];
-            J1 = vertex1->getLocation().j[4];
-            I2 = vertex2->getLocation().i[4];
-            J2 = vertex2->getLocation().j[4];
-            // start from the cell where the first point is at
-            I = I1, J = J1, I0 = I1, J0 = J1;
-            while (true) {
-                useMPFR = false;
-                lonBnd1 = mesh.lon(I);
-                lonBnd2 = mesh.lon(I+1);
-                latBnd1 = mesh.lat(J);
-                latBnd2 = mesh.lat(J+1);
-                // check if get into the cell where the second point is
-                if (I == I2 && J == J2) break;
-                // record boundary cell indices
-                bndCellIdx[I].push_back(J);
-                // Note: There are four directions to search.
-                // western boundary
-                if (from != WestBnd || edgePointer != edgePointer0) {
-                    if (Sphere::calcIntersectLat(x1, x2, lonBnd1,
-                                                 latBnd1, latBnd2, x)) {
-                        I0 = I; J0 = J;
-                        from0 = from; to0 = WestBnd;;
-                        I = I-1; if (I == -1) I = numLon-1;
-                        from = EastBnd;
-                        goto calc_overlap_area;
-                    }
-                }
-                // eastern boundary
-                if (from != EastBnd || edgePointer != edgePointer0) {
-                    if (Sphere::calcIntersectLat(x1, x2, lonBnd2,
-                                                 latBnd1, latBnd2, x)) {
-                        I0 = I; J0 = J;
-                        from0 = from; to0 = EastBnd;
-                        I = I+1; if (I == numLon) I = 0;
-                        from = WestBnd;
-                        goto calc_overlap_area;
-                    }
-                }
-            calculate_use_mpfr:
-                // northern boundary
-                if ((from != NorthBnd && J > 0) ||
-                    edgePointer != edgePointer0) {
-                    if (Sphere::calcIntersectLon(x1, x2, lonBnd1, lonBnd2,
-                                                 latBnd1, x, useMPFR)) {
-                        I0 = I; J0 = J;
-                        from0 = from; to0 = NorthBnd;
-                        J = J-1;
-                        from = SouthBnd;
-                        goto calc_overlap_area;
-                    }
-                }
-                // southern boundary
-                if ((from != SouthBnd && J < numLat) ||
-                    edgePointer != edgePointer0) {
-                    if (Sphere::calcIntersectLon(x1, x2, lonBnd1, lonBnd2,
-                                                 latBnd2, x, useMPFR)) {
-                        I0 = I; J0 = J;
-                        from0 = from; to0 = SouthBnd;
-                        J = J+1;
-                        from = NorthBnd;
-                        goto calc_overlap_area;
-                    }
+    // record the previous edge and intersection
+    EdgePointer *edgePointer0 = NULL; Coordinate x0;
+    // record the starting edge and intersection
+    EdgePointer *edgePointer00 = NULL; Coordinate x00;
+    // record the coming and going boundary
+    Bnd from0, to0, to00, from = NullBnd;
+    // record the previous cell index
+    int I0, J0;
+    // reset
+    totalArea = 0.0; realArea = polygon->getArea(NewTimeLevel);
+    // internal variables
+    int I, J, I1, I2, J1, J2, bndDiff;
+    double lonBnd1, lonBnd2, latBnd1, latBnd2;
+    Coordinate x;
+    // Note: The calculation of intersection between great-circle arc and
+    //       latitudinal line may fail under normal double precision
+    //       floating-point calculation, so swith to MPFR if necessary.
+    bool useMPFR;
+    // -------------------------------------------------------------------------
+    // fast path: all the vertices are in one cell, so the polygon contributes
+    // its whole area to that cell
+    EdgePointer *edgePointer = polygon->edgePointers.front();
+    I = edgePointer->getEndPoint(FirstPoint)->getLocation().i[4];
+    J = edgePointer->getEndPoint(FirstPoint)->getLocation().j[4];
+    path = SingleCellPath;
+    for (int n = 0; n < polygon->edgePointers.size(); ++n) {
+        const Location &loc = edgePointer->getEndPoint(SecondPoint)->getLocation();
+        if (loc.i[4] != I || loc.j[4] != J) {
+            path = BoundaryPath;
+            break;
+        }
+        edgePointer = edgePointer->next;
+    }
+    if (path == SingleCellPath) {
+        recordOverlapArea(mesh.area(I, J), I, J, realArea,
+                          totalArea, buffer.records, first);
+        buffer.records[first].totalArea = totalArea;
+        return 0.0;
+    }
+    // -------------------------------------------------------------------------
+    // search overlapped mesh cell along polygon edges
+    coverMask.reset();
+    edgePointer = polygon->edgePointers.front();
+    for (int n = 0; n < polygon->edgePointers.size(); ++n) {
+        Vertex *vertex1 = edgePointer->getEndPoint(FirstPoint);
+        Vertex *vertex2 = edgePointer->getEndPoint(SecondPoint);
+        const Coordinate &x1 = vertex1->getCoordinate();
+        const Coordinate &x2 = vertex2->getCoordinate();
+        I1 = vertex1->getLocation().i[4];
+        J1 = vertex1->getLocation().j[4];
+        I2 = vertex2->getLocation().i[4];
+        J2 = vertex2->getLocation().j[4];
+        // start from the cell where the first point is at
+        I = I1, J = J1, I0 = I1, J0 = J1;
+        while (true) {
+            useMPFR = false;
+            lonBnd1 = mesh.lon(I);
+            lonBnd2 = mesh.lon(I+1);
+            latBnd1 = mesh.lat(J);
+            latBnd2 = mesh.lat(J+1);
+            // check if get into the cell where the second point is
+            if (I == I2 && J == J2) break;
+            // record boundary cell indices
+            coverMask.addBndCell(I, J);
+            // Note: There are four directions to search.
+            // western boundary
+            if (from != WestBnd || edgePointer != edgePointer0) {
+                if (Sphere::calcIntersectLat(x1, x2, lonBnd1,
+                                             latBnd1, latBnd2, x)) {
+                    I0 = I; J0 = J;
+                    from0 = from; to0 = WestBnd;;
+                    I = I-1; if (I == -1) I = numLon-1;
+                    from = EastBnd;
+                    goto calc_overlap_area;
                 }
-                // -------------------------------------------------------------
-                // Note: Here no intersection has been found under the normal
-                //       double precision floating point calculation, so switch
-                //       to high precision MPFR version.
-                if (useMPFR) {
-                    Message message;
-                    message << "Intersection can not be found for polygon ";
-                    message << polygon->getID() << "!";
-                    REPORT_ERROR(message.str());
+            }
+            // eastern boundary
+            if (from != EastBnd || edgePointer != edgePointer0) {
+                if (Sphere::calcIntersectLat(x1, x2, lonBnd2,
+                                             latBnd1, latBnd2, x)) {
+                    I0 = I; J0 = J;
+                    from0 = from; to0 = EastBnd;
+                    I = I+1; if (I == numLon) I = 0;
+                    from = WestBnd;
+                    goto calc_overlap_area;
                 }
-                useMPFR = true;
-                goto calculate_use_mpfr;
-            calc_overlap_area:
-                if (edgePointer0 != NULL) {
-                    double area = calcOverlapArea(I0, J0, from0, to0,
-                                                  bndDiff, isTolerated,
-                                                  lonBnd1, lonBnd2,
-                                                  latBnd1, latBnd2,
-                                                  x0, edgePointer0,
-                                                  x, edgePointer);
-                    recordOverlapArea(mesh.area(I0, J0), I0, J0,
-                                      from0, to0, bndDiff,
-                                      polygon, area, totalArea, overlapAreas);
+            }
+        calculate_use_mpfr:
+            // northern boundary
+            if ((from != NorthBnd && J > 0) ||
+                edgePointer != edgePointer0) {
+                if (calcIntersectLon(x1, x2, lonBnd1, lonBnd2,
+                                     latBnd1, x, useMPFR)) {
+                    I0 = I; J0 = J;
+                    from0 = from; to0 = NorthBnd;
+                    J = J-1;
+                    from = SouthBnd;
+                    goto calc_overlap_area;
                 }
-                // record the starting edge and intersection
-                if (edgePointer00 == NULL) {
-                    x00 = x; edgePointer00 = edgePointer; to00 = to0;
+            }
+            // southern boundary
+            if ((from != SouthBnd && J < numLat) ||
+                edgePointer != edgePointer0) {
+                if (calcIntersectLon(x1, x2, lonBnd1, lonBnd2,
+                                     latBnd2, x, useMPFR)) {
+                    I0 = I; J0 = J;
+                    from0 = from; to0 = SouthBnd;
+                    J = J+1;
+                    from = NorthBnd;
+                    goto calc_overlap_area;
                 }
-                // record the previous edge and intersection
-                x0 = x; edgePointer0 = edgePointer;
-#ifdef DEBUG
-                counter++;
-#endif
             }
-            edgePointer = edgePointer->next;
-        }
-        if (edgePointer00 != NULL) {
-            double area = calcOverlapArea(I,J, from, to00, bndDiff, isTolerated,
-                                          lonBnd1, lonBnd2, latBnd1, latBnd2,
-                                          x0, edgePointer0, x00, edgePointer00);
-            recordOverlapArea(mesh.area(I, J), I, J, from, to00, bndDiff,
-                              polygon, area, totalArea, overlapAreas);
-        } else
-            recordOverlapArea(mesh.area(I, J), I, J, polygon,
-                              polygon->getArea(NewTimeLevel),
-                              totalArea, overlapAreas);
-        // ---------------------------------------------------------------------
-        // check if pole has been included
-        diffArea = fabs(totalArea-realArea)/realArea;
-        if (diffArea > areaDiffThreshold) {
-            Location::Pole checkPole = Location::Null;
-            // Note: Here we assume that if the boundary cells cover the whole
-            //       zonal range, then the pole has been included
-            if (bndCellIdx.size() == numLon) {
-                checkPole = 
-                polygon->edgePointers.front()->getEndPoint(FirstPoint)->
-                getCoordinate().getLat() > 0.0 ?
-                Location::NorthPole : Location::SouthPole;
+            // -----------------------------------------------------------------
+            // Note: Here no intersection has been found under the normal
+            //       double precision floating point calculation, so switch
+            //       to high precision MPFR version.
+            if (useMPFR) {
+                Message message;
+                message << "Intersection can not be found for polygon ";
+                message << polygon->getID() << "!";
+                REPORT_ERROR(message.str());
+            }
+            useMPFR = true;
+            goto calculate_use_mpfr;
+        calc_overlap_area:
+            if (edgePointer0 != NULL) {
+                double area = calcOverlapArea(I0, J0, from0, to0,
+                                              bndDiff, isTolerated,
+                                              lonBnd1, lonBnd2,
+                                              latBnd1, latBnd2,
+                                              x0, edgePointer0,
+                                              x, edgePointer,
+                                              buffer.scratch);
+                recordOverlapArea(mesh.area(I0, J0), I0, J0,
+                                  area, totalArea, buffer.records, first);
             }
+            // record the starting edge and intersection
+            if (edgePointer00 == NULL) {
+                x00 = x; edgePointer00 = edgePointer; to00 = to0;
+            }
+            // record the previous edge and intersection
+            x0 = x; edgePointer0 = edgePointer;
 #ifdef DEBUG
-            coverMask.init(polygon, bndCellIdx, checkPole, mesh, debug);
-#else
-            coverMask.init(polygon, bndCellIdx, checkPole, mesh);
+            counter++;
 #endif
-            // record the fully covered cells from pole to the first or last
-            // crossed cell along longitude
-            if (checkPole != Location::Null)
-                for (int i = 0; i < coverMask.mask.extent(0); ++i)
-                    for (int j = 0; j < coverMask.mask.extent(1); ++j)
-                        if (coverMask.mask(i, j) ==
-                            CoverMask::FullyCoveredNearPole)
-                            recordOverlapArea(mesh.area(coverMask.idxI(i),
-                                                        coverMask.idxJ(j)),
-                                              coverMask.idxI(i),
-                                              coverMask.idxJ(j), polygon,
-                                              mesh.area(coverMask.idxI(i),
-                                                        coverMask.idxJ(j)),
-                                              totalArea, overlapAreas);
-            diffArea = fabs(totalArea-realArea)/realArea;
         }
-        // ---------------------------------------------------------------------
-        // handle the cells that are fully covered by the polygon
-        if (coverMask.mask.size() != 0 && any(coverMask.mask == -1)) {
+        edgePointer = edgePointer->next;
+    }
+    if (edgePointer00 != NULL) {
+        double area = calcOverlapArea(I,J, from, to00, bndDiff, isTolerated,
+                                      lonBnd1, lonBnd2, latBnd1, latBnd2,
+                                      x0, edgePointer0, x00, edgePointer00,
+                                      buffer.scratch);
+        recordOverlapArea(mesh.area(I, J), I, J,
+                          area, totalArea, buffer.records, first);
+    } else
+        recordOverlapArea(mesh.area(I, J), I, J,
+                          polygon->getArea(NewTimeLevel),
+                          totalArea, buffer.records, first);
+    // -------------------------------------------------------------------------
+    // handle the cells that are fully covered by the polygon (including the
+    // cells between the pole and the polygon if the pole is included)
+    diffArea = fabs(totalArea-realArea)/realArea;
+    if (diffArea > areaDiffThreshold) {
+        path = CoverPath;
 #ifdef DEBUG
-            coverMask.searchCover(polygon, debug);
+        coverMask.init(polygon, debug);
+        coverMask.searchCover(polygon, debug);
 #else
-            coverMask.searchCover(polygon);
+        coverMask.init(polygon);
+        coverMask.searchCover(polygon);
 #endif
-            // add the fully covered cells
-            for (int i = 0; i < coverMask.mask.extent(0); ++i)
-                for (int j = 0; j < coverMask.mask.extent(1); ++j)
-                    if (coverMask.mask(i, j) == CoverMask::FullyCovered)
-                        recordOverlapArea(mesh.area(coverMask.idxI(i),
-                                                    coverMask.idxJ(j)),
-                                          coverMask.idxI(i),
-                                          coverMask.idxJ(j), polygon,
-                                          mesh.area(coverMask.idxI(i),
-                                                    coverMask.idxJ(j)),
-                                          totalArea, overlapAreas);
-            diffArea = fabs(totalArea-realArea)/realArea;
-        }
-        // ---------------------------------------------------------------------
-        // record totalArea in each overlapArea to overcome numerical inaccuracy
-        list<OverlapArea *>::const_iterator itOaPtr = overlapAreas.begin();
-        for (; itOaPtr != overlapAreas.end(); ++itOaPtr)
-            (*itOaPtr)->totalArea = totalArea;
-        // ---------------------------------------------------------------------
-        // Note: If numerical tolerance has been applied when calculating
-        //       overlap area, then we should relax the threshold.
-        if ((isTolerated && diffArea > areaDiffThreshold*5.0) ||
-            (!isTolerated && diffArea > areaDiffThreshold)) {
-            Message message;
-            message << "Failed to calculate overlap area for polygon ";
-            message << polygon->getID() << "!" << endl;
-            polygon->dump("polygon");
-            cout << "[Debug]: Area relative difference is " << diffArea << endl;
-            REPORT_ERROR(message.str());
+        for (int k = 0; k < coverMask.getNumCoveredCell(); ++k) {
+            I = coverMask.getCoveredI(k);
+            J = coverMask.getCoveredJ(k);
+            recordOverlapArea(mesh.area(I, J), I, J, mesh.area(I, J),
+                              totalArea, buffer.records, first);
         }
-        maxDiffArea = fmax(maxDiffArea, diffArea);
+        diffArea = fabs(totalArea-realArea)/realArea;
+    }
+    // -------------------------------------------------------------------------
+    // record totalArea in each overlapArea to overcome numerical inaccuracy
+    for (int k = first; k < static_cast<int>(buffer.records.size()); ++k)
+        buffer.records[k].totalArea = totalArea;
+    // -------------------------------------------------------------------------
+    // Note: If numerical tolerance has been applied when calculating
+    //       overlap area, then we should relax the threshold.
+    if ((isTolerated && diffArea > areaDiffThreshold*5.0) ||
+        (!isTolerated && diffArea > areaDiffThreshold)) {
+        Message message;
+        message << "Failed to calculate overlap area for polygon ";
+        message << polygon->getID() << "!" << endl;
+        polygon->dump("polygon");
+        cout << "[Debug]: Area relative difference is " << diffArea << endl;
+        REPORT_ERROR(message.str());
+    }
+    return diffArea;
+}
+
+void MeshAdaptor::adapt(const TracerManager &tracerManager,
+                        const MeshManager &meshManager)
+{
+    NOTICE("MeshAdaptor::adapt", "running ...");
+    const RLLMesh &mesh = meshManager.getMesh(PointCounter::Bound);
+    const PolygonManager &polygonManager = tracerManager.polygonManager;
+    int numPolygon = polygonManager.polygons.size();
+    double maxDiffArea = 0.0;
+    // -------------------------------------------------------------------------
+    // reset
+    polygons.resize(numPolygon);
+    polygonRanges.resize(numPolygon);
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int m = 0; m < numPolygon; ++m) {
+        polygons[m] = polygon;
         polygon = polygon->next;
     }
+    int numThread = 1;
+#ifdef _OPENMP
+    numThread = omp_get_max_threads();
+#endif
+    if (static_cast<int>(adaptBuffers.size()) < numThread)
+        adaptBuffers.resize(numThread);
+    for (int t = 0; t < static_cast<int>(adaptBuffers.size()); ++t) {
+        adaptBuffers[t].records.clear();
+        for (int k = 0; k < NumAdaptPath; ++k)
+            adaptBuffers[t].pathCounts[k] = 0;
+    }
+    // -------------------------------------------------------------------------
+    // calculate the overlap area between polygon and mesh
+    // Note: The polygons are independent of each other, so each thread records
+    //       the overlap areas into its own buffer.
+#pragma omp parallel
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        AdaptBuffer &buffer = adaptBuffers[thread];
+        CoverMask coverMask(meshManager.getMesh(PointCounter::Center));
+        double threadMaxDiffArea = 0.0;
+#pragma omp for schedule(dynamic, 64)
+        for (int m = 0; m < numPolygon; ++m) {
+            polygonRanges[m].thread = thread;
+            polygonRanges[m].first = static_cast<int>(buffer.records.size());
+            AdaptPath path;
+            double diffArea = adaptPolygon(polygons[m], mesh, coverMask,
+                                           buffer, path);
+            polygonRanges[m].last = static_cast<int>(buffer.records.size());
+            buffer.pathCounts[path]++;
+            threadMaxDiffArea = fmax(threadMaxDiffArea, diffArea);
+        }
+#pragma omp critical (MeshAdaptor_adapt)
+        maxDiffArea = fmax(maxDiffArea, threadMaxDiffArea);
+    }
+    // -------------------------------------------------------------------------
+    // merge the buffers in the polygon order, so the overlap table is the
+    // same as the serial run whatever the number of threads is
+    overlapTable.beginBuild();
+    for (int m = 0; m < numPolygon; ++m) {
+        const vector<OverlapRecord> &records =
+            adaptBuffers[polygonRanges[m].thread].records;
+        overlapTable.addPolygon(polygons[m]);
+        for (int k = polygonRanges[m].first; k < polygonRanges[m].last; ++k)
+            overlapTable.add(records[k].I, records[k].J,
+                             records[k].area, records[k].totalArea);
+    }
+    overlapTable.endBuild();
+    for (int k = 0; k < NumAdaptPath; ++k) {
+        pathCounts[k] = 0;
+        for (int t = 0; t < static_cast<int>(adaptBuffers.size()); ++t)
+            pathCounts[k] += adaptBuffers[t].pathCounts[k];
+    }
 #ifdef DEBUG
     cout << "Maximum area difference: " << maxDiffArea*100 << "%" << endl;
+    cout << "Polygons in single cell: ";
+    cout << pathCounts[SingleCellPath]*100.0/numPolygon << "%, ";
+    cout << "crossing cells: ";
+    cout << pathCounts[BoundaryPath]*100.0/numPolygon << "%, ";
+    cout << "covering cells: ";
+    cout << pathCounts[CoverPath]*100.0/numPolygon << "%" << endl;
 #endif
 }
 
 void MeshAdaptor::remap(const string &tracerName, const Field &q,
                         TracerManager &tracerManager)
 {
-    NOTICE("MeshAdaptor::remap", "Remapping "+tracerName+" onto polygons ...");
-    int tracerId = tracerManager.getTracerId(tracerName);
-    const RLLMesh &mesh = q.getMesh(Field::Bound);
+    vector<string> tracerNames(1, tracerName);
+    vector<const Field *> qs(1, &q);
+    remap(tracerNames, qs, tracerManager);
+}
+
+void MeshAdaptor::remap(const vector<string> &tracerNames,
+                        const vector<const Field *> &qs,
+                        TracerManager &tracerManager)
+{
+    int numTracer = static_cast<int>(tracerNames.size());
+    if (numTracer == 0)
+        return;
+    for (int l = 0; l < numTracer; ++l)
+        NOTICE("MeshAdaptor::remap",
+               "Remapping "+tracerNames[l]+" onto polygons ...");
+    vector<int> tracerIds(numTracer);
+    for (int l = 0; l < numTracer; ++l)
+        tracerIds[l] = tracerManager.getTracerId(tracerNames[l]);
+    const RLLMesh &mesh = qs[0]->getMesh(Field::Bound);
+    int numPolygon = overlapTable.getNumPolygon();
     // -------------------------------------------------------------------------
     // reset tracer mass
-    Polygon *polygon = tracerManager.polygonManager.polygons.front();
-    for (int i = 0; i < tracerManager.polygonManager.polygons.size(); ++i) {
-        if (polygon->tracers.size() == 0)
-            // new polygon
-            polygon->tracers.resize(tracerManager.getTracerNum());
-        polygon->tracers[tracerId].setMass(0.0);
-        polygon = polygon->next;
-    }
+    polygonMasses.assign(numPolygon*numTracer, 0.0);
     // -------------------------------------------------------------------------
     // accumulate tracer mass
-    double totalCellMass = 0.0, totalPolygonMass = 0.0;
-    for (int i = 0; i < overlapAreaList.extent(0); ++i)
-        for (int j = 0; j < overlapAreaList.extent(1); ++j) {
+    vector<double> cellMasses(numTracer);
+    vector<CompensatedSum> totalCellMasses(numTracer);
+    vector<CompensatedSum> totalPolygonMasses(numTracer);
+    for (int i = 0; i < overlapTable.getNumLon(); ++i)
+        for (int j = 0; j < overlapTable.getNumLat(); ++j) {
             double totalArea = 0.0;
-            double cellMass = q(i, j).getNew()*mesh.area(i, j);
-            totalCellMass += cellMass;
-            list<OverlapArea>::const_iterator itOa;
+            for (int l = 0; l < numTracer; ++l) {
+                cellMasses[l] = (*qs[l])(i, j).getNew()*mesh.area(i, j);
+                totalCellMasses[l].add(cellMasses[l]);
+            }
+            int begin = overlapTable.cellBegin(i, j);
+            int end = overlapTable.cellEnd(i, j);
             // accumulate overlap area
-            for (itOa = overlapAreaList(i, j, 0).begin();
-                 itOa != overlapAreaList(i, j, 0).end(); ++itOa)
-                totalArea += (*itOa).area;
+            for (int k = begin; k < end; ++k)
+                totalArea += overlapTable.getOverlap(k).area;
             // use partition of unity to ensure exact mass conservation since
             // there are numerical errors when calculate overlap area
-            for (itOa = overlapAreaList(i, j, 0).begin();
-                 itOa != overlapAreaList(i, j, 0).end(); ++itOa) {
-                double weight = (*itOa).area/totalArea;
-                (*itOa).polygon->tracers[tracerId].addMass(cellMass*weight);
+            for (int k = begin; k < end; ++k) {
+                const OverlapArea &overlapArea = overlapTable.getOverlap(k);
+                double weight = overlapArea.area/totalArea;
+                double *masses = &polygonMasses[overlapArea.polygonIdx*numTracer];
+                for (int l = 0; l < numTracer; ++l)
+                    masses[l] += cellMasses[l]*weight;
             }
         }
     // -------------------------------------------------------------------------
-    // calculate tracer density
-    polygon = tracerManager.polygonManager.polygons.front();
-    for (int i = 0; i < tracerManager.polygonManager.polygons.size(); ++i) {
-        polygon->updateTracer(tracerId);
-        totalPolygonMass += polygon->tracers[tracerId].getMass();
-        polygon = polygon->next;
+    // set tracer mass and calculate tracer density
+    for (int p = 0; p < numPolygon; ++p) {
+        Polygon *polygon = overlapTable.getPolygon(p);
+        const double *masses = &polygonMasses[p*numTracer];
+        for (int l = 0; l < numTracer; ++l) {
+            polygon->setTracerMass(tracerIds[l], masses[l]);
+            polygon->updateTracer(tracerIds[l]);
+            totalPolygonMasses[l].add(masses[l]);
+        }
     }
     // -------------------------------------------------------------------------
-    cout << "Total cell mass is    " << setprecision(30) << totalCellMass << endl;
-    cout << "Total polygon mass is " << setprecision(30) << totalPolygonMass << endl;
-    double massError = (totalCellMass-totalPolygonMass)/totalPolygonMass;
-    cout << "Mass error is " << massError << "%" << endl;
-    if (fabs(massError) > 1.0e-10)
-        REPORT_ERROR("Mass error is too large!");
+    // Note: The masses on the polygons are the references of the later drifts.
+    for (int l = 0; l < numTracer; ++l) {
+        ConservationMonitor::setMass(tracerIds[l],
+                                     totalPolygonMasses[l].getSum());
+        ConservationMonitor::recordRemap(tracerIds[l],
+                                         totalCellMasses[l].getSum(),
+                                         totalPolygonMasses[l].getSum());
+    }
 }
 
 void MeshAdaptor::remap(const string &tracerName, TracerManager &tracerManager)
 {
     NOTICE("MeshAdaptor::remap", "Remapping "+tracerName+" onto mesh ...");
-    int tracerId = tracerManager.getTracerId(tracerName);
-    Field &q = tracerManager.getTracerDensityField(tracerId);
-    const RLLMesh &mesh = q.getMesh(Field::Bound);
+    vector<int> tracerIds(1, tracerManager.getTracerId(tracerName));
+    remap(tracerIds, tracerManager);
+}
+
+void MeshAdaptor::remap(TracerManager &tracerManager)
+{
+    NOTICE("MeshAdaptor::remap", "Remapping all tracers onto mesh ...");
+    vector<int> tracerIds(tracerManager.getTracerNum());
+    for (int l = 0; l < tracerManager.getTracerNum(); ++l)
+        tracerIds[l] = l;
+    remap(tracerIds, tracerManager);
+}
+
+void MeshAdaptor::remap(const vector<int> &tracerIds,
+                        TracerManager &tracerManager)
+{
+    int numTracer = static_cast<int>(tracerIds.size());
+    if (numTracer == 0)
+        return;
+    vector<Field *> qs(numTracer);
+    for (int l = 0; l < numTracer; ++l)
+        qs[l] = &tracerManager.getTracerDensityField(tracerIds[l]);
+    const RLLMesh &mesh = qs[0]->getMesh(Field::Bound);
+    int numPolygon = overlapTable.getNumPolygon();
     // -------------------------------------------------------------------------
-    double totalCellMass = 0.0, totalPolygonMass = 0.0;
-    for (int i = 0; i < overlapAreaList.extent(0); ++i)
-        for (int j = 0; j < overlapAreaList.extent(1); ++j) {
-            q(i, j) = 0.0;
-            list<OverlapArea>::const_iterator itOa;
-            for (itOa = overlapAreaList(i, j, 0).begin();
-                 itOa != overlapAreaList(i, j, 0).end(); ++itOa) {
-                double weight = (*itOa).area/(*itOa).totalArea;
-                q(i, j) += (*itOa).polygon->tracers[tracerId].getMass()*weight;
+    // gather the tracer masses into a contiguous block
+    vector<CompensatedSum> totalCellMasses(numTracer);
+    vector<CompensatedSum> totalPolygonMasses(numTracer);
+    polygonMasses.resize(numPolygon*numTracer);
+    for (int p = 0; p < numPolygon; ++p) {
+        Polygon *polygon = overlapTable.getPolygon(p);
+        double *masses = &polygonMasses[p*numTracer];
+        for (int l = 0; l < numTracer; ++l) {
+            masses[l] = polygon->getTracerMass(tracerIds[l]);
+            totalPolygonMasses[l].add(masses[l]);
+        }
+    }
+    // -------------------------------------------------------------------------
+    vector<double> cellMasses(numTracer);
+    for (int i = 0; i < overlapTable.getNumLon(); ++i)
+        for (int j = 0; j < overlapTable.getNumLat(); ++j) {
+            for (int l = 0; l < numTracer; ++l)
+                cellMasses[l] = 0.0;
+            for (int k = overlapTable.cellBegin(i, j);
+                 k < overlapTable.cellEnd(i, j); ++k) {
+                const OverlapArea &overlapArea = overlapTable.getOverlap(k);
+                double weight = overlapArea.area/overlapArea.totalArea;
+                const double *masses =
+                    &polygonMasses[overlapArea.polygonIdx*numTracer];
+                for (int l = 0; l < numTracer; ++l)
+                    cellMasses[l] += masses[l]*weight;
             }
-            totalCellMass += q(i, j).getNew();
-            q(i, j) /= mesh.area(i, j);
+            for (int l = 0; l < numTracer; ++l) {
+                Field &q = *qs[l];
+                q(i, j) = cellMasses[l];
+                totalCellMasses[l].add(q(i, j).getNew());
+                q(i, j) /= mesh.area(i, j);
 #ifdef DEBUG
-            if (q(i, j).getNew() == 0.0) {
-                Message message;
-                message << "Point counter cell (" << i << ", " << j << ") ";
-                message << "got no tracer mass!";
-                REPORT_ERROR(message.str());
-            }
+                if (q(i, j).getNew() == 0.0) {
+                    Message message;
+                    message << "Point counter cell (" << i << ", " << j << ") ";
+                    message << "got no tracer mass!";
+                    REPORT_ERROR(message.str());
+                }
 #endif
+            }
         }
     // -------------------------------------------------------------------------
-    Polygon *polygon = tracerManager.polygonManager.polygons.front();
-    for (int i = 0; i < tracerManager.polygonManager.polygons.size(); ++i) {
-        totalPolygonMass += polygon->tracers[tracerId].getMass();
-        polygon = polygon->next;
+    for (int l = 0; l < numTracer; ++l)
+        ConservationMonitor::recordRemap(tracerIds[l],
+                                         totalPolygonMasses[l].getSum(),
+                                         totalCellMasses[l].getSum());
+}
+
+void MeshAdaptor::calcWeightMatrix(TracerManager &tracerManager,
+                                   const RemapGrid &grid,
+                                   WeightMatrix &matrix)
+{
+    SupermeshRemapper::calcWeightMatrix(tracerManager.polygonManager,
+                                        grid, matrix);
+}
+
+void MeshAdaptor::remap(const WeightMatrix &matrix,
+                        TracerManager &tracerManager,
+                        vector<double> &densities)
+{
+    PolygonManager &polygonManager = tracerManager.polygonManager;
+    int numTracer = tracerManager.getTracerNum();
+    int numPolygon = polygonManager.polygons.size();
+    if (matrix.getNumCol() != numPolygon) {
+        Message message;
+        message << "Weight matrix is calculated for " << matrix.getNumCol();
+        message << " polygons, but there are " << numPolygon << " now!";
+        REPORT_ERROR(message.str());
     }
     // -------------------------------------------------------------------------
-    cout << "Total cell mass is    " << setprecision(30) << totalCellMass << endl;
-    cout << "Total polygon mass is " << setprecision(30) << totalPolygonMass << endl;
-    double massError = (totalPolygonMass-totalCellMass)/totalCellMass;
-    cout << "Mass error is " << massError << "%" << endl;
-    if (fabs(massError) > 1.0e-10)
-        REPORT_ERROR("Mass error is too large!");
+    // gather the tracer masses in the polygon list order
+    polygonMasses.resize(numPolygon*numTracer);
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int p = 0; p < numPolygon; ++p) {
+        for (int l = 0; l < numTracer; ++l)
+            polygonMasses[p*numTracer+l] = polygon->getTracerMass(l);
+        polygon = polygon->next;
+    }
+    densities.resize(matrix.getNumRow()*numTracer);
+    if (numTracer > 0 && matrix.getNumRow() > 0)
+        matrix.apply(&polygonMasses[0], numTracer, &densities[0]);
 }
@@ -4,24 +4,34 @@
 #include <blitz/array.h>
 #include <string>
 #include <list>
+#include <vector>
 
 using blitz::Array;
 using std::string;
 using std::list;
+using std::vector;
 
 #include "Vector.hpp"
 #include "Coordinate.hpp"
 #include "Field.hpp"
 #include "TracerManager.hpp"
+#include "OverlapTable.hpp"
 
-typedef struct {
-    Polygon *polygon;
-    double area, totalArea;
-} OverlapArea;
+class CoverMask;
+class RemapGrid;
+class WeightMatrix;
 
 class MeshAdaptor
 {
 public:
+    // the ways that adapt takes to calculate the overlaps of one polygon
+    enum AdaptPath {
+        SingleCellPath,     // all vertices are in one cell
+        BoundaryPath,       // edges cross cells, and no cell is fully covered
+        CoverPath,          // some cells are fully covered (or pole is included)
+        NumAdaptPath
+    };
+
     MeshAdaptor();
     virtual ~MeshAdaptor();
 
@@ -47,7 +57,8 @@ public:
      * Function:
      *   remap
      * Purpose:
-     *   Remap the quantities associated with fixed mesh to tracer.
+     *   Remap the quantities associated with fixed mesh to tracer, or the
+     *   tracer onto the fixed mesh (without q).
      */
     void remap(const string &tracerName, const Field &q,
                TracerManager &tracerManager);
@@ -55,12 +66,57 @@ public:
 
     /*
      * Function:
-     *   getOverlapAreaList
+     *   remap
+     * Purpose:
+     *   Remap several tracers in one pass over the overlaps, from fixed mesh
+     *   (qs[l] for tracerNames[l]) to tracers, or all the tracers onto the
+     *   fixed mesh (without qs).
+     */
+    void remap(const vector<string> &tracerNames,
+               const vector<const Field *> &qs,
+               TracerManager &tracerManager);
+    void remap(TracerManager &tracerManager);
+
+    /*
+     * Function:
+     *   calcWeightMatrix
      * Purpose:
-     *   Return overlap area list (for generating SCVT density function) 
+     *   Calculate the weight matrix from the tracer masses of the polygons to
+     *   the tracer densities on the cells of an arbitrary grid. The matrix
+     *   can be reused (and saved) as long as the polygons are not changed.
      */
-    const Array<list<OverlapArea>, 3> &getOverlapAreaList() const {
-        return overlapAreaList;
+    void calcWeightMatrix(TracerManager &tracerManager, const RemapGrid &grid,
+                          WeightMatrix &matrix);
+
+    /*
+     * Function:
+     *   remap
+     * Purpose:
+     *   Remap all the tracers onto the cells of a grid by applying the weight
+     *   matrix, and the densities are returned as [cell][tracer].
+     */
+    void remap(const WeightMatrix &matrix, TracerManager &tracerManager,
+               vector<double> &densities);
+
+    /*
+     * Function:
+     *   getNumPolygon
+     * Purpose:
+     *   Return the number of polygons that took the given path in the last
+     *   adapt.
+     */
+    int getNumPolygon(AdaptPath path) const {
+        return pathCounts[path];
+    }
+
+    /*
+     * Function:
+     *   getOverlapTable
+     * Purpose:
+     *   Return overlap table (for generating SCVT density function) 
+     */
+    const OverlapTable &getOverlapTable() const {
+        return overlapTable;
     }
 
 private:
@@ -68,6 +124,31 @@ private:
         WestBnd, SouthBnd, EastBnd, NorthBnd, NullBnd
     };
 
+    // working arrays of calcOverlapArea
+    struct OverlapScratch {
+        Array<Vector, 1> normVectors;
+        Array<Coordinate, 1> x;
+        Array<double, 1> polygonAngles, angles;
+    };
+
+    // overlap area of one polygon with cell (I, J)
+    struct OverlapRecord {
+        int I, J;
+        double area, totalArea;
+    };
+
+    // Note: Each thread of adapt has its own buffer, and the records of each
+    //       polygon are contiguous in it.
+    struct AdaptBuffer {
+        vector<OverlapRecord> records;
+        OverlapScratch scratch;
+        int pathCounts[NumAdaptPath];
+    };
+
+    struct PolygonRange {
+        int thread, first, last;
+    };
+
     static double calcCorrectArea(const Coordinate &x1, const Coordinate &x2,
                                   const Vector &normVector, int signFlag);
     double calcOverlapArea(int I, int J, Bnd from, Bnd to,
@@ -75,16 +156,25 @@ private:
                            double lonBnd1, double lonBnd2,
                            double latBnd1, double latBnd2,
                            Coordinate x0, EdgePointer *edgePointer0,
-                           Coordinate x1, EdgePointer *edgePointer1);
-    void recordOverlapArea(double cellArea, int I, int J,
-                           Bnd from, Bnd to, int bndDiff,
-                           Polygon *polygon, double area, double &totalArea,
-                           list<OverlapArea *> &overlapAreas);
+                           Coordinate x1, EdgePointer *edgePointer1,
+                           OverlapScratch &scratch);
     void recordOverlapArea(double cellArea, int I, int J,
-                           Polygon *polygon, double area, double &totalArea,
-                           list<OverlapArea *> &overlapAreas);
+                           double area, double &totalArea,
+                           vector<OverlapRecord> &records, int first);
+    // calculate the overlap areas of one polygon and return the relative
+    // area difference
+    double adaptPolygon(Polygon *polygon, const RLLMesh &mesh,
+                        CoverMask &coverMask, AdaptBuffer &buffer,
+                        AdaptPath &path);
+    void remap(const vector<int> &tracerIds, TracerManager &tracerManager);
 
-    Array<list<OverlapArea>, 3> overlapAreaList;
+    OverlapTable overlapTable;
+    vector<Polygon *> polygons;
+    vector<PolygonRange> polygonRanges;
+    vector<AdaptBuffer> adaptBuffers;
+    int pathCounts[NumAdaptPath];
+    // tracer masses of the polygons in the overlap table ([polygon][tracer])
+    vector<double> polygonMasses;
 };
 
 #endif
@@ -0,0 +1,79 @@
+#include "OverlapTable.hpp"
+#include "ReportMacros.hpp"
+#include <cassert>
+
+OverlapTable::OverlapTable()
+{
+    numLon = 0;
+    numLat = 0;
+}
+
+OverlapTable::~OverlapTable()
+{
+}
+
+void OverlapTable::init(int numLon, int numLat)
+{
+    this->numLon = numLon;
+    this->numLat = numLat;
+    cellOffsets.assign(numLon*numLat+1, 0);
+    overlaps.clear();
+    polygons.clear();
+    polygonOffsets.assign(1, 0);
+    polygonOverlaps.clear();
+}
+
+void OverlapTable::beginBuild()
+{
+    stagedCells.clear();
+    stagedOverlaps.clear();
+    polygons.clear();
+    polygonOffsets.clear();
+}
+
+void OverlapTable::addPolygon(Polygon *polygon)
+{
+    polygons.push_back(polygon);
+    polygonOffsets.push_back(static_cast<int>(stagedOverlaps.size()));
+}
+
+void OverlapTable::add(int i, int j, double area, double totalArea)
+{
+#ifdef DEBUG
+    assert(!polygons.empty());
+    assert(i >= 0 && i < numLon && j >= 0 && j < numLat);
+#endif
+    OverlapArea overlap;
+    overlap.polygon = polygons.back();
+    overlap.polygonIdx = static_cast<int>(polygons.size())-1;
+    overlap.area = area;
+    overlap.totalArea = totalArea;
+    stagedCells.push_back(i*numLat+j);
+    stagedOverlaps.push_back(overlap);
+}
+
+void OverlapTable::endBuild()
+{
+    int numCell = numLon*numLat;
+    int numOverlap = static_cast<int>(stagedOverlaps.size());
+    polygonOffsets.push_back(numOverlap);
+    // -------------------------------------------------------------------------
+    // count the overlaps of each cell
+    cellOffsets.assign(numCell+1, 0);
+    for (int k = 0; k < numOverlap; ++k)
+        cellOffsets[stagedCells[k]+1]++;
+    for (int c = 0; c < numCell; ++c)
+        cellOffsets[c+1] += cellOffsets[c];
+    // -------------------------------------------------------------------------
+    // distribute the overlaps into the cells
+    // Note: The sort is stable, so the overlaps in each cell are still in the
+    //       order of the polygons.
+    overlaps.resize(numOverlap);
+    polygonOverlaps.resize(numOverlap);
+    cellCursors.assign(cellOffsets.begin(), cellOffsets.end()-1);
+    for (int k = 0; k < numOverlap; ++k) {
+        int pos = cellCursors[stagedCells[k]]++;
+        overlaps[pos] = stagedOverlaps[k];
+        polygonOverlaps[k] = pos;
+    }
+}
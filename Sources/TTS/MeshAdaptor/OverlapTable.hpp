@@ -0,0 +1,68 @@
+#ifndef OverlapTable_h
+#define OverlapTable_h
+
+#include <vector>
+
+using std::vector;
+
+class Polygon;
+
+typedef struct {
+    Polygon *polygon;
+    int polygonIdx; // index in the overlap table
+    double area, totalArea;
+} OverlapArea;
+
+// -----------------------------------------------------------------------------
+// OverlapTable stores the overlap areas between polygons and mesh cells in
+// compressed sparse rows (CSR): the overlaps of cell (i, j) are at
+// [cellBegin(i, j), cellEnd(i, j)), in the order of the polygons. There is
+// also a polygon to overlap index, so the overlaps of the p-th polygon can be
+// visited without searching the cells.
+//
+// The table is built in bulk (addPolygon and add between beginBuild and
+// endBuild), and the overlaps are distributed into the cells by a counting
+// sort, so there is no allocation per overlap.
+
+class OverlapTable
+{
+public:
+    OverlapTable();
+    ~OverlapTable();
+
+    void init(int numLon, int numLat);
+
+    void beginBuild();
+    // Note: The overlaps of one polygon should be added just after it.
+    void addPolygon(Polygon *polygon);
+    void add(int i, int j, double area, double totalArea);
+    void endBuild();
+
+    int getNumLon() const { return numLon; }
+    int getNumLat() const { return numLat; }
+    int getNumOverlap() const { return static_cast<int>(overlaps.size()); }
+
+    // cell -> overlaps
+    int cellBegin(int i, int j) const { return cellOffsets[i*numLat+j]; }
+    int cellEnd(int i, int j) const { return cellOffsets[i*numLat+j+1]; }
+    const OverlapArea &getOverlap(int k) const { return overlaps[k]; }
+
+    // polygon -> overlaps (the indices are for getOverlap)
+    int getNumPolygon() const { return static_cast<int>(polygons.size()); }
+    Polygon *getPolygon(int p) const { return polygons[p]; }
+    int polygonBegin(int p) const { return polygonOffsets[p]; }
+    int polygonEnd(int p) const { return polygonOffsets[p+1]; }
+    int getPolygonOverlap(int k) const { return polygonOverlaps[k]; }
+
+private:
+    int numLon, numLat;
+    vector<int> cellOffsets;
+    vector<OverlapArea> overlaps;
+    vector<Polygon *> polygons;
+    vector<int> polygonOffsets, polygonOverlaps;
+    // staging area of the bulk build
+    vector<int> stagedCells, cellCursors;
+    vector<OverlapArea> stagedOverlaps;
+};
+
+#endif
@@ -0,0 +1,328 @@
+#include "MeshValidator.hpp"
+#include "PolygonManager.hpp"
+#include "ConfigTools.hpp"
+#include "TimeManager.hpp"
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <ctime>
+
+using std::vector;
+using std::pair;
+
+namespace MeshValidator
+{
+    // the grid of the spatial hash is bounded by this number along each axis
+    static const int maxNumCell = 1024;
+
+    struct EdgeBox
+    {
+        double min[3], max[3];
+    };
+}
+
+using namespace MeshValidator;
+
+// -----------------------------------------------------------------------------
+
+void Report::reset()
+{
+    numCrossEdgePair = 0;
+    numBadOrient = 0;
+    numBadArea = 0;
+    numBrokenRing = 0;
+    crossEdgeIDs[0] = INT_MAX;
+    crossEdgeIDs[1] = INT_MAX;
+    badOrientPolygonID = INT_MAX;
+    badAreaPolygonID = INT_MAX;
+    brokenRingPolygonID = INT_MAX;
+}
+
+bool Report::isValid() const
+{
+    return numCrossEdgePair == 0 && numBadOrient == 0 &&
+           numBadArea == 0 && numBrokenRing == 0;
+}
+
+void Report::dump() const
+{
+    cout << "Mesh validation report:" << endl;
+    cout << "  crossing edge pairs:    " << setw(10) << numCrossEdgePair;
+    if (numCrossEdgePair != 0)
+        cout << " (first: " << crossEdgeIDs[0] << ", " << crossEdgeIDs[1] << ")";
+    cout << endl;
+    cout << "  bad orientations:       " << setw(10) << numBadOrient;
+    if (numBadOrient != 0)
+        cout << " (first polygon: " << badOrientPolygonID << ")";
+    cout << endl;
+    cout << "  non-positive areas:     " << setw(10) << numBadArea;
+    if (numBadArea != 0)
+        cout << " (first polygon: " << badAreaPolygonID << ")";
+    cout << endl;
+    cout << "  broken edge rings:      " << setw(10) << numBrokenRing;
+    if (numBrokenRing != 0)
+        cout << " (first polygon: " << brokenRingPolygonID << ")";
+    cout << endl;
+}
+
+// -----------------------------------------------------------------------------
+
+// Note: Sphere::isIntersect uses static buffers, so it can not be called from
+//       multiple threads. This is the same test without them.
+inline bool isIntersect(const Vector &x1, const Vector &x2,
+                        const Vector &x3, const Vector &x4)
+{
+    static const double eps = 1.0e-12;
+    Vector v = cross(cross(x1, x2), cross(x3, x4));
+    double r = norm(v);
+    if (r <= eps)
+        return false;
+    v /= r;
+    for (int i = 0; i < 2; ++i) {
+        if (dot(cross(x1, v), cross(x2, v)) < 0.0 &&
+            dot(cross(x3, v), cross(x4, v)) < 0.0)
+            return true;
+        v *= -1.0;
+    }
+    return false;
+}
+
+inline int calcCell(double x, double h, int n)
+{
+    int i = static_cast<int>((x+1.0)/h);
+    return i < 0 ? 0 : (i >= n ? n-1 : i);
+}
+
+static void checkCrossEdges(const vector<Edge *> &edges, Report &report)
+{
+    int numEdge = static_cast<int>(edges.size());
+    if (numEdge == 0)
+        return;
+    // -------------------------------------------------------------------------
+    // calculate the boxes of the edges (the arc bulges out of the chord by no
+    // more than 1-cos(a/2), where a is the arc angle)
+    vector<EdgeBox> boxes(numEdge);
+    double meanLength = 0.0;
+#pragma omp parallel for reduction(+:meanLength)
+    for (int i = 0; i < numEdge; ++i) {
+        const Vector &x1 = edges[i]->getEndPoint(FirstPoint)->getCoordinate().getCAR();
+        const Vector &x2 = edges[i]->getEndPoint(SecondPoint)->getCoordinate().getCAR();
+        double chord = norm(x1-x2);
+        double angle = 2.0*asin(fmin(1.0, 0.5*chord));
+        double bulge = 1.0-cos(0.5*angle);
+        for (int m = 0; m < 3; ++m) {
+            boxes[i].min[m] = fmin(x1(m), x2(m))-bulge;
+            boxes[i].max[m] = fmax(x1(m), x2(m))+bulge;
+        }
+        meanLength += chord;
+    }
+    meanLength /= numEdge;
+    int n = static_cast<int>(2.0/fmax(2.0*meanLength, 2.0/maxNumCell));
+    n = n < 1 ? 1 : (n > maxNumCell ? maxNumCell : n);
+    double h = 2.0/n;
+    // -------------------------------------------------------------------------
+    // hash the edges into the cells and sort them by the cell keys
+    vector<pair<int, int> > entries;
+    entries.reserve(numEdge*2);
+    for (int i = 0; i < numEdge; ++i) {
+        int i0 = calcCell(boxes[i].min[0], h, n), i1 = calcCell(boxes[i].max[0], h, n);
+        int j0 = calcCell(boxes[i].min[1], h, n), j1 = calcCell(boxes[i].max[1], h, n);
+        int k0 = calcCell(boxes[i].min[2], h, n), k1 = calcCell(boxes[i].max[2], h, n);
+        for (int ci = i0; ci <= i1; ++ci)
+            for (int cj = j0; cj <= j1; ++cj)
+                for (int ck = k0; ck <= k1; ++ck)
+                    entries.push_back(pair<int, int>((ci*n+cj)*n+ck, i));
+    }
+    std::sort(entries.begin(), entries.end());
+    vector<int> runs;
+    for (int r = 0; r < static_cast<int>(entries.size()); ++r)
+        if (r == 0 || entries[r].first != entries[r-1].first)
+            runs.push_back(r);
+    runs.push_back(static_cast<int>(entries.size()));
+    // -------------------------------------------------------------------------
+    // test the edge pairs in each cell
+    // Note: A pair is only tested in the lowest cell of the overlap of its two
+    //       boxes, so each pair is tested once.
+    int numRun = static_cast<int>(runs.size())-1;
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int r = 0; r < numRun; ++r) {
+        int key = entries[runs[r]].first;
+        for (int a = runs[r]; a < runs[r+1]; ++a) {
+            Edge *edge1 = edges[entries[a].second];
+            const EdgeBox &box1 = boxes[entries[a].second];
+            Vertex *vertex1 = edge1->getEndPoint(FirstPoint);
+            Vertex *vertex2 = edge1->getEndPoint(SecondPoint);
+            for (int b = a+1; b < runs[r+1]; ++b) {
+                Edge *edge2 = edges[entries[b].second];
+                const EdgeBox &box2 = boxes[entries[b].second];
+                int c[3];
+                bool isOverlap = true;
+                for (int m = 0; m < 3; ++m) {
+                    if (box1.min[m] > box2.max[m] || box2.min[m] > box1.max[m])
+                        isOverlap = false;
+                    c[m] = calcCell(fmax(box1.min[m], box2.min[m]), h, n);
+                }
+                if (!isOverlap || (c[0]*n+c[1])*n+c[2] != key)
+                    continue;
+                Vertex *vertex3 = edge2->getEndPoint(FirstPoint);
+                Vertex *vertex4 = edge2->getEndPoint(SecondPoint);
+                if (vertex3 == vertex1 || vertex3 == vertex2 ||
+                    vertex4 == vertex1 || vertex4 == vertex2)
+                    continue;
+                if (isIntersect(vertex1->getCoordinate().getCAR(),
+                                vertex2->getCoordinate().getCAR(),
+                                vertex3->getCoordinate().getCAR(),
+                                vertex4->getCoordinate().getCAR())) {
+#pragma omp critical (MeshValidator_report)
+                    {
+                        report.numCrossEdgePair++;
+                        int id1 = std::min(edge1->getID(), edge2->getID());
+                        int id2 = std::max(edge1->getID(), edge2->getID());
+                        if (id1 < report.crossEdgeIDs[0] ||
+                            (id1 == report.crossEdgeIDs[0] &&
+                             id2 < report.crossEdgeIDs[1])) {
+                            report.crossEdgeIDs[0] = id1;
+                            report.crossEdgeIDs[1] = id2;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void checkPolygons(const vector<Polygon *> &polygons, Report &report)
+{
+    int numPolygon = static_cast<int>(polygons.size());
+    int numBadOrient = 0, numBadArea = 0, numBrokenRing = 0;
+#pragma omp parallel for reduction(+:numBadOrient,numBadArea,numBrokenRing)
+    for (int i = 0; i < numPolygon; ++i) {
+        Polygon *polygon = polygons[i];
+        bool isBrokenRing = false, isBadOrient = false;
+        // ---------------------------------------------------------------------
+        // edge pointer ring
+        int numEdge = polygon->edgePointers.size();
+        EdgePointer *edgePointer = polygon->edgePointers.front();
+        if (numEdge < 2 || edgePointer == NULL) {
+            isBrokenRing = true;
+        } else {
+            for (int j = 0; j < numEdge; ++j) {
+                if (edgePointer->next == NULL || edgePointer->next->prev != edgePointer ||
+                    edgePointer->edge == NULL) {
+                    isBrokenRing = true;
+                    break;
+                }
+                edgePointer = edgePointer->next;
+            }
+            if (!isBrokenRing && edgePointer != polygon->edgePointers.front())
+                isBrokenRing = true;
+        }
+        if (!isBrokenRing) {
+            // -----------------------------------------------------------------
+            // orientation consistency
+            for (int j = 0; j < numEdge; ++j) {
+                Edge *edge = edgePointer->edge;
+                if (edge->getEdgePointer(edgePointer->orient) != edgePointer ||
+                    edge->getPolygon(edgePointer->orient) != polygon ||
+                    edgePointer->getEndPoint(SecondPoint) !=
+                    edgePointer->next->getEndPoint(FirstPoint)) {
+                    isBadOrient = true;
+                    break;
+                }
+                edgePointer = edgePointer->next;
+            }
+        }
+        if (isBrokenRing) numBrokenRing++;
+        if (isBadOrient) numBadOrient++;
+        // ---------------------------------------------------------------------
+        // area
+        bool isBadArea = !isBrokenRing && polygon->getArea() <= 0.0;
+        if (isBadArea) numBadArea++;
+        if (isBrokenRing || isBadOrient || isBadArea) {
+#pragma omp critical (MeshValidator_report)
+            {
+                int id = polygon->getID();
+                if (isBrokenRing && id < report.brokenRingPolygonID)
+                    report.brokenRingPolygonID = id;
+                if (isBadOrient && id < report.badOrientPolygonID)
+                    report.badOrientPolygonID = id;
+                if (isBadArea && id < report.badAreaPolygonID)
+                    report.badAreaPolygonID = id;
+            }
+        }
+    }
+    report.numBadOrient += numBadOrient;
+    report.numBadArea += numBadArea;
+    report.numBrokenRing += numBrokenRing;
+}
+
+// -----------------------------------------------------------------------------
+
+void MeshValidator::init()
+{
+    if (ConfigTools::hasKey("mesh_check_frequency")) {
+        int frequency;
+        ConfigTools::read("mesh_check_frequency", frequency);
+        TimeManager::setAlarm("mesh validation", frequency);
+    }
+}
+
+bool MeshValidator::validate(PolygonManager &polygonManager, Report &report)
+{
+    report.reset();
+    // -------------------------------------------------------------------------
+    // collect the objects for random access
+    vector<Edge *> edges;
+    edges.reserve(polygonManager.edges.size());
+    Edge *edge = polygonManager.edges.front();
+    for (int i = 0; i < polygonManager.edges.size(); ++i) {
+        // edges should have both end points to be checked for crossing
+        if (edge->getEndPoint(FirstPoint) == NULL ||
+            edge->getEndPoint(SecondPoint) == NULL ||
+            edge->getEndPoint(FirstPoint) == edge->getEndPoint(SecondPoint))
+            report.numBadOrient++;
+        else
+            edges.push_back(edge);
+        // edges should be linked back by their edge pointers
+        for (int j = 0; j < 2; ++j) {
+            OrientStatus orient = j == 0 ? OrientLeft : OrientRight;
+            if (edge->getPolygon(orient) == NULL)
+                continue;
+            EdgePointer *edgePointer = edge->getEdgePointer(orient);
+            if (edgePointer == NULL || edgePointer->edge != edge ||
+                edgePointer->orient != orient)
+                report.numBadOrient++;
+        }
+        edge = edge->next;
+    }
+    vector<Polygon *> polygons;
+    polygons.reserve(polygonManager.polygons.size());
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int i = 0; i < polygonManager.polygons.size(); ++i) {
+        polygons.push_back(polygon);
+        polygon = polygon->next;
+    }
+    // -------------------------------------------------------------------------
+    checkPolygons(polygons, report);
+    checkCrossEdges(edges, report);
+    return report.isValid();
+}
+
+void MeshValidator::check(PolygonManager &polygonManager)
+{
+    if (!TimeManager::isAlarmed("mesh validation"))
+        return;
+    clock_t start, end;
+    Report report;
+    start = clock();
+    bool isValid = validate(polygonManager, report);
+    end = clock();
+    cout << "[Timing]: MeshValidator::validate: ";
+    cout << setprecision(5) << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
+    if (!isValid) {
+        report.dump();
+        Message message;
+        message << "Parcel mesh is invalid at step " << TimeManager::getSteps() << "!";
+        REPORT_ERROR(message.str());
+    }
+}
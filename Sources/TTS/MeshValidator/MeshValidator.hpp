@@ -0,0 +1,44 @@
+#ifndef MeshValidator_h
+#define MeshValidator_h
+
+class PolygonManager;
+
+// -----------------------------------------------------------------------------
+// MeshValidator checks the whole parcel mesh without relying on DEBUG asserts:
+//   (1) crossing edges, found by a spatial hash of the edge boxes so that only
+//       the nearby edges are tested, which is O(E log E) instead of O(E^2);
+//   (2) orientation consistency between polygons, edge pointers and edges;
+//   (3) non-positive polygon areas;
+//   (4) broken edge pointer rings.
+// The checks are parallelized with OpenMP when it is enabled.
+
+namespace MeshValidator
+{
+    struct Report
+    {
+        Report() { reset(); }
+
+        void reset();
+        bool isValid() const;
+        void dump() const;
+
+        int numCrossEdgePair;
+        int numBadOrient;
+        int numBadArea;
+        int numBrokenRing;
+        // the first offending objects (IDs) for inspection
+        int crossEdgeIDs[2];
+        int badOrientPolygonID;
+        int badAreaPolygonID;
+        int brokenRingPolygonID;
+    };
+
+    void init();
+
+    bool validate(PolygonManager &polygonManager, Report &report);
+
+    // validate the mesh if it is the time, and stop if it is invalid
+    void check(PolygonManager &polygonManager);
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "DensityBuilder.hpp"
+#include "TracerManager.hpp"
+#include "ConfigTools.hpp"
+#include "ReportMacros.hpp"
+#include <cmath>
+
+namespace
+{
+    // Note: The ternary maximum is vectorized by the compilers, while fmax is
+    //       not without relaxed floating point flags.
+    inline double maxDiff(double d, double a, double b)
+    {
+        double e = fabs(a-b);
+        return e > d ? e : d;
+    }
+}
+
+void DensityBuilder::init()
+{
+    numSmooth = 0;
+    tracerIds.clear();
+    weights.clear();
+    if (ConfigTools::hasKey("rezone_density_num_tracer")) {
+        int numTracer;
+        ConfigTools::read("rezone_density_num_tracer", numTracer);
+        tracerIds.resize(numTracer);
+        weights.resize(numTracer, 1.0);
+        ConfigTools::read("rezone_density_tracers", numTracer, &tracerIds[0]);
+        if (ConfigTools::hasKey("rezone_density_weights"))
+            ConfigTools::read("rezone_density_weights", numTracer, &weights[0]);
+    }
+    if (ConfigTools::hasKey("rezone_density_smooth"))
+        ConfigTools::read("rezone_density_smooth", numSmooth);
+}
+
+void DensityBuilder::gather(TracerManager &tracerManager, int tracerId)
+{
+    const Field &field = tracerManager.getTracerDensityField(tracerId);
+    const RLLMesh &mesh = field.getMesh();
+    int numLon = mesh.getNumLon(), numLat = mesh.getNumLat();
+    if (q.extent(0) != numLon || q.extent(1) != numLat)
+        q.resize(numLon, numLat);
+    for (int i = 0; i < numLon; ++i)
+        for (int j = 0; j < numLat; ++j)
+            q(i, j) = field.values(i, j, 0).getNew();
+}
+
+void DensityBuilder::build(TracerManager &tracerManager, Array<double, 2> &rho)
+{
+    if (tracerIds.size() == 0) {
+        tracerIds.push_back(tracerManager.getTracerId("test tracer 0"));
+        weights.push_back(1.0);
+    }
+    rho = 0.0;
+    for (int l = 0; l < tracerIds.size(); ++l) {
+        if (tracerIds[l] < 0 || tracerIds[l] >= tracerManager.getTracerNum()) {
+            Message message;
+            message << "Invalid tracer ID " << tracerIds[l] << " in ";
+            message << "rezone_density_tracers.";
+            REPORT_ERROR(message.str());
+        }
+        gather(tracerManager, tracerIds[l]);
+        int numLon = q.extent(0), numLat = q.extent(1);
+        if (rho.extent(0) != numLon-2 || rho.extent(1) != numLat)
+            REPORT_ERROR("Density function mismatches the tracer mesh!");
+        if (grad.extent(0) != rho.extent(0) || grad.extent(1) != numLat)
+            grad.resize(rho.shape());
+        // Note: The polar rows are left zero.
+        grad = 0.0;
+#pragma omp parallel for
+        for (int i = 1; i < numLon-1; ++i) {
+            const double *qm = &q(i-1, 0), *q0 = &q(i, 0), *qp = &q(i+1, 0);
+            double *g = &grad(i-1, 0);
+            for (int j = 1; j < numLat-1; ++j) {
+                double d = 0.0;
+                d = maxDiff(d, q0[j], qm[j-1]);
+                d = maxDiff(d, q0[j], qm[j  ]);
+                d = maxDiff(d, q0[j], qm[j+1]);
+                d = maxDiff(d, q0[j], q0[j-1]);
+                d = maxDiff(d, q0[j], q0[j+1]);
+                d = maxDiff(d, q0[j], qp[j-1]);
+                d = maxDiff(d, q0[j], qp[j  ]);
+                d = maxDiff(d, q0[j], qp[j+1]);
+                g[j] = d;
+            }
+        }
+        double maxGrad = max(grad);
+        if (maxGrad == 0.0)
+            continue;
+        double scale = weights[l]/maxGrad;
+#pragma omp parallel for
+        for (int i = 0; i < rho.extent(0); ++i) {
+            const double *g = &grad(i, 0);
+            double *r = &rho(i, 0);
+            for (int j = 0; j < numLat; ++j)
+                r[j] += scale*g[j];
+        }
+    }
+    for (int k = 0; k < numSmooth; ++k)
+        smooth(rho);
+}
+
+/*
+ * Function:
+ *   smooth
+ * Purpose:
+ *   Smooth the density by 1-2-1 filter along longitude (cyclic) and then
+ *   latitude (the polar rows are mirrored).
+ */
+void DensityBuilder::smooth(Array<double, 2> &rho)
+{
+    int numLon = rho.extent(0), numLat = rho.extent(1);
+    // Note: grad has the same shape as rho here.
+#pragma omp parallel for
+    for (int i = 0; i < numLon; ++i) {
+        const double *rm = &rho(i > 0 ? i-1 : numLon-1, 0);
+        const double *r0 = &rho(i, 0);
+        const double *rp = &rho(i < numLon-1 ? i+1 : 0, 0);
+        double *g = &grad(i, 0);
+        for (int j = 0; j < numLat; ++j)
+            g[j] = 0.25*(rm[j]+2.0*r0[j]+rp[j]);
+    }
+#pragma omp parallel for
+    for (int i = 0; i < numLon; ++i) {
+        const double *g = &grad(i, 0);
+        double *r = &rho(i, 0);
+        r[0] = 0.25*(3.0*g[0]+g[1]);
+        for (int j = 1; j < numLat-1; ++j)
+            r[j] = 0.25*(g[j-1]+2.0*g[j]+g[j+1]);
+        r[numLat-1] = 0.25*(g[numLat-2]+3.0*g[numLat-1]);
+    }
+}
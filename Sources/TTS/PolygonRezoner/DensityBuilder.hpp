@@ -0,0 +1,50 @@
+#ifndef DensityBuilder_h
+#define DensityBuilder_h
+
+#include <blitz/array.h>
+#include <vector>
+
+using blitz::Array;
+
+class TracerManager;
+
+// -----------------------------------------------------------------------------
+// DensityBuilder sets the density function of SCVT from the tracer density
+// fields. The density of each tracer is its maximum difference against the
+// eight neighbor cells, which is normalized by its own maximum, and the
+// densities of the tracers are summed with the weights, so the generators are
+// concentrated where any of the tracers has sharp gradients. The tracer field
+// is gathered into a contiguous buffer once (the field values are stored by
+// time levels on the heap), and the stencil runs along the contiguous rows.
+// The density can be smoothed by some passes of 1-2-1 filter, so that the
+// generator density does not jump between neighbor cells.
+//
+// Configuration keys:
+//   rezone_density_num_tracer  number of tracers (1, "test tracer 0")
+//   rezone_density_tracers     tracer IDs separated by commas
+//   rezone_density_weights     tracer weights separated by commas (1)
+//   rezone_density_smooth      passes of smoothing (0)
+
+class DensityBuilder
+{
+public:
+    DensityBuilder() {}
+    ~DensityBuilder() {}
+
+    void init();
+
+    // rho is on the cells of the tracer mesh without the ghost columns
+    void build(TracerManager &tracerManager, Array<double, 2> &rho);
+
+private:
+    void gather(TracerManager &tracerManager, int tracerId);
+    void smooth(Array<double, 2> &rho);
+
+    std::vector<int> tracerIds;
+    std::vector<double> weights;
+    int numSmooth;
+    // buffers of a tracer field (with the ghost columns) and its density
+    Array<double, 2> q, grad;
+};
+
+#endif
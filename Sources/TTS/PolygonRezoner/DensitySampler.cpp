@@ -0,0 +1,95 @@
+#include "DensitySampler.hpp"
+#include "RandomNumber.hpp"
+#include "ReportMacros.hpp"
+#include "Constants.hpp"
+#include <cmath>
+
+void DensitySampler::init(const Array<double, 1> &lonBnd,
+                          const Array<double, 1> &latBnd,
+                          const Array<double, 2> &rho)
+{
+    int numLon = lonBnd.size()-1;
+    int numLat = latBnd.size()-1;
+    this->lonBnd.resize(numLon+1);
+    this->latBnd.resize(numLat+1);
+    sinLatBnd.resize(numLat+1);
+    for (int i = 0; i <= numLon; ++i)
+        this->lonBnd[i] = lonBnd(i);
+    for (int j = 0; j <= numLat; ++j) {
+        this->latBnd[j] = latBnd(j);
+        sinLatBnd[j] = sin(latBnd(j));
+    }
+    // -------------------------------------------------------------------------
+    // Set the first cells of the uniform buckets
+    lonBuckets.resize(numLon);
+    lonBucketScale = numLon/(this->lonBnd[numLon]-this->lonBnd[0]);
+    for (int k = 0, i = 0; k < numLon; ++k) {
+        double lon = this->lonBnd[0]+k/lonBucketScale;
+        while (i < numLon-1 && lon >= this->lonBnd[i+1]) ++i;
+        lonBuckets[k] = i;
+    }
+    latBuckets.resize(numLat);
+    latBucketScale = numLat/(this->latBnd[0]-this->latBnd[numLat]);
+    for (int k = 0, j = 0; k < numLat; ++k) {
+        double lat = this->latBnd[0]-k/latBucketScale;
+        while (j < numLat-1 && lat < this->latBnd[j+1]) ++j;
+        latBuckets[k] = j;
+    }
+    // -------------------------------------------------------------------------
+    // Build the alias table by Vose's method
+    int numCell = numLon*numLat;
+    probs.resize(numCell);
+    aliases.resize(numCell);
+    double totalMass = 0.0;
+    for (int j = 0; j < numLat; ++j)
+        for (int i = 0; i < numLon; ++i) {
+            double area = (this->lonBnd[i+1]-this->lonBnd[i])*
+                (sinLatBnd[j]-sinLatBnd[j+1]);
+            probs[i+j*numLon] = rho(i, j)*area;
+            totalMass += probs[i+j*numLon];
+        }
+    if (totalMass <= 0.0)
+        REPORT_ERROR("Density function has no positive mass!");
+    std::vector<int> small, large;
+    for (int k = 0; k < numCell; ++k) {
+        probs[k] *= numCell/totalMass;
+        aliases[k] = k;
+        if (probs[k] < 1.0)
+            small.push_back(k);
+        else
+            large.push_back(k);
+    }
+    while (!small.empty() && !large.empty()) {
+        int s = small.back(), l = large.back();
+        small.pop_back();
+        aliases[s] = l;
+        probs[l] -= 1.0-probs[s];
+        if (probs[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Note: The left ones are 1 up to the rounding errors.
+    for (int k = 0; k < static_cast<int>(small.size()); ++k)
+        probs[small[k]] = 1.0;
+    for (int k = 0; k < static_cast<int>(large.size()); ++k)
+        probs[large[k]] = 1.0;
+}
+
+void DensitySampler::sample(double &lon, double &lat) const
+{
+    int numLon = static_cast<int>(lonBnd.size())-1;
+    int numCell = static_cast<int>(probs.size());
+    int k = RandomNumber::getRandomNumber(0, numCell);
+    if (RandomNumber::getRandomNumber(0.0, 1.0) >= probs[k])
+        k = aliases[k];
+    int i = k%numLon, j = k/numLon;
+    // -------------------------------------------------------------------------
+    // Uniform point inside the cell (area is linear in sin(lat))
+    lon = RandomNumber::getRandomNumber(lonBnd[i], lonBnd[i+1]);
+    if (lon < 0.0)
+        lon += PI2;
+    else if (lon >= PI2)
+        lon -= PI2;
+    lat = asin(RandomNumber::getRandomNumber(sinLatBnd[j+1], sinLatBnd[j]));
+}
@@ -0,0 +1,70 @@
+#ifndef DensitySampler_h
+#define DensitySampler_h
+
+#include <blitz/array.h>
+#include <vector>
+
+using blitz::Array;
+
+// -----------------------------------------------------------------------------
+// DensitySampler is built once from a piecewise constant density function on
+// the longitude-latitude cells of SCVT. It locates the cell of a point in O(1)
+// from the uniform buckets of the bounds (with at most a few steps of
+// refinement), and draws points distributed as the density on the sphere by
+// choosing a cell from an alias table of density times area, and then a
+// uniform point inside the cell. So each sample costs O(1) whatever the
+// density contrast is.
+
+class DensitySampler
+{
+public:
+    DensitySampler() {}
+    ~DensitySampler() {}
+
+    // lonBnd and latBnd are the cell bounds, where latBnd is from north to
+    // south, and rho is the density on the cells.
+    void init(const Array<double, 1> &lonBnd, const Array<double, 1> &latBnd,
+              const Array<double, 2> &rho);
+
+    // Return false if the latitude is out of the bounds. The longitude is
+    // cyclic, and the points outside the longitude bounds are in the first
+    // cell.
+    inline bool locate(double lon, double lat, int &i, int &j) const;
+
+    void sample(double &lon, double &lat) const;
+
+private:
+    std::vector<double> lonBnd, latBnd, sinLatBnd;
+    std::vector<int> lonBuckets, latBuckets;
+    double lonBucketScale, latBucketScale;
+    // alias table of the cells (i+j*numLon)
+    std::vector<double> probs;
+    std::vector<int> aliases;
+};
+
+// -----------------------------------------------------------------------------
+
+inline bool DensitySampler::locate(double lon, double lat, int &i, int &j) const
+{
+    int numLon = static_cast<int>(lonBnd.size())-1;
+    int numLat = static_cast<int>(latBnd.size())-1;
+    if (lon < lonBnd[0] || lon >= lonBnd[numLon]) {
+        i = 0;
+    } else {
+        int k = static_cast<int>((lon-lonBnd[0])*lonBucketScale);
+        if (k >= numLon) k = numLon-1;
+        i = lonBuckets[k];
+        while (i < numLon-1 && lon >= lonBnd[i+1]) ++i;
+        while (i > 0 && lon < lonBnd[i]) --i;
+    }
+    if (lat > latBnd[0] || lat < latBnd[numLat])
+        return false;
+    int k = static_cast<int>((latBnd[0]-lat)*latBucketScale);
+    if (k >= numLat) k = numLat-1;
+    j = latBuckets[k];
+    while (j < numLat-1 && lat < latBnd[j+1]) ++j;
+    while (j > 0 && lat > latBnd[j]) --j;
+    return true;
+}
+
+#endif
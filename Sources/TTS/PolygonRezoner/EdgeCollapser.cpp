@@ -0,0 +1,226 @@
+#include "EdgeCollapser.hpp"
+#include "RemapGrid.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace EdgeCollapser
+{
+    // the rings around each vertex
+    static vector<vector<int> > vertexRings;
+    // orientations of the rings, which should be kept
+    static vector<double> orients;
+
+    double calcLength(const Vector &x1, const Vector &x2);
+    double calcArea(const vector<Vector> &x, const vector<int> &ring,
+                    int a, int b, const Vector &y);
+    int findNeighbor(const vector<vector<int> > &rings, int k, int a, int b);
+    void getNeighbors(const vector<vector<int> > &rings, int a,
+                      vector<int> &neighbors);
+    bool canCollapse(const vector<Vector> &x,
+                     const vector<vector<int> > &rings, int numMovableVertex,
+                     int k, int i, Vector &y);
+    void apply(vector<Vector> &x, vector<vector<int> > &rings, int k, int i,
+               const Vector &y, vector<Collapse> &collapses);
+}
+
+using namespace EdgeCollapser;
+
+double EdgeCollapser::calcLength(const Vector &x1, const Vector &x2)
+{
+    return atan2(norm(cross(x1, x2)), dot(x1, x2));
+}
+
+/*
+ * Function:
+ *   calcArea
+ * Purpose:
+ *   Calculate the signed area of the ring with the vertices a and b merged
+ *   at y.
+ */
+double EdgeCollapser::calcArea(const vector<Vector> &x,
+                               const vector<int> &ring, int a, int b,
+                               const Vector &y)
+{
+    vector<Vector> z;
+    bool isLastMerged = false;
+    for (int i = 0; i < ring.size(); ++i) {
+        bool isMerged = ring[i] == a || ring[i] == b;
+        if (isMerged && isLastMerged)
+            continue;
+        z.push_back(isMerged ? y : x[ring[i]]);
+        isLastMerged = isMerged;
+    }
+    if (z.size() > 1 && isLastMerged && (ring[0] == a || ring[0] == b))
+        z.pop_back();
+    if (z.size() < 3)
+        return 0.0;
+    return RemapGrid::calcArea(&z[0], static_cast<int>(z.size()));
+}
+
+// find the ring other than k with the edge from b to a
+int EdgeCollapser::findNeighbor(const vector<vector<int> > &rings, int k,
+                                int a, int b)
+{
+    for (int j = 0; j < vertexRings[a].size(); ++j) {
+        int m = vertexRings[a][j];
+        if (m == k)
+            continue;
+        int n = static_cast<int>(rings[m].size());
+        for (int i = 0; i < n; ++i)
+            if (rings[m][i] == b && rings[m][(i+1)%n] == a)
+                return m;
+    }
+    return -1;
+}
+
+void EdgeCollapser::getNeighbors(const vector<vector<int> > &rings, int a,
+                                 vector<int> &neighbors)
+{
+    neighbors.clear();
+    for (int j = 0; j < vertexRings[a].size(); ++j) {
+        const vector<int> &ring = rings[vertexRings[a][j]];
+        int n = static_cast<int>(ring.size());
+        for (int i = 0; i < n; ++i)
+            if (ring[i] == a) {
+                neighbors.push_back(ring[(i+n-1)%n]);
+                neighbors.push_back(ring[(i+1)%n]);
+            }
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                    neighbors.end());
+}
+
+bool EdgeCollapser::canCollapse(const vector<Vector> &x,
+                                const vector<vector<int> > &rings,
+                                int numMovableVertex, int k, int i, Vector &y)
+{
+    int n = static_cast<int>(rings[k].size());
+    int a = rings[k][i], b = rings[k][(i+1)%n];
+    if (a >= numMovableVertex || b >= numMovableVertex || n <= 3)
+        return false;
+    int m = findNeighbor(rings, k, a, b);
+    if (m == -1 || rings[m].size() <= 3)
+        return false;
+    // -------------------------------------------------------------------------
+    // topology
+    for (int j = 0; j < vertexRings[a].size(); ++j) {
+        int r = vertexRings[a][j];
+        if (r != k && r != m &&
+            std::find(rings[r].begin(), rings[r].end(), b) != rings[r].end())
+            return false;
+    }
+    vector<int> neighbors1, neighbors2, commons;
+    getNeighbors(rings, a, neighbors1);
+    getNeighbors(rings, b, neighbors2);
+    std::set_intersection(neighbors1.begin(), neighbors1.end(),
+                          neighbors2.begin(), neighbors2.end(),
+                          std::back_inserter(commons));
+    if (!commons.empty())
+        return false;
+    // -------------------------------------------------------------------------
+    // geometry
+    y = x[a]+x[b];
+    y /= norm(y);
+    for (int l = 0; l < 2; ++l) {
+        const vector<int> &rs = vertexRings[l == 0 ? a : b];
+        for (int j = 0; j < rs.size(); ++j)
+            if (orients[rs[j]]*calcArea(x, rings[rs[j]], a, b, y) <= 0.0)
+                return false;
+    }
+    return true;
+}
+
+void EdgeCollapser::apply(vector<Vector> &x, vector<vector<int> > &rings,
+                          int k, int i, const Vector &y,
+                          vector<Collapse> &collapses)
+{
+    int n = static_cast<int>(rings[k].size());
+    Collapse collapse;
+    collapse.kept = rings[k][i];
+    collapse.removed = rings[k][(i+1)%n];
+    collapses.push_back(collapse);
+    int a = collapse.kept, b = collapse.removed;
+    x[a] = y;
+    for (int j = 0; j < vertexRings[b].size(); ++j) {
+        int r = vertexRings[b][j];
+        vector<int> &ring = rings[r];
+        std::replace(ring.begin(), ring.end(), b, a);
+        for (int l = 0; l < ring.size() && ring.size() > 1;) {
+            if (ring[l] == ring[(l+1)%ring.size()])
+                ring.erase(ring.begin()+(l+1)%ring.size());
+            else
+                ++l;
+        }
+        if (std::find(vertexRings[a].begin(), vertexRings[a].end(), r) ==
+            vertexRings[a].end())
+            vertexRings[a].push_back(r);
+    }
+    vertexRings[b].clear();
+}
+
+int EdgeCollapser::collapse(vector<Vector> &x, vector<vector<int> > &rings,
+                            int numMovableVertex, int maxNumEdge,
+                            double collapseRatio, vector<Collapse> &collapses)
+{
+    collapses.clear();
+    vertexRings.assign(x.size(), vector<int>());
+    orients.resize(rings.size());
+    double meanLength = 0.0;
+    int numEdge = 0;
+    for (int k = 0; k < rings.size(); ++k) {
+        int n = static_cast<int>(rings[k].size());
+        vector<Vector> z(n);
+        for (int i = 0; i < n; ++i) {
+            int a = rings[k][i];
+            if (vertexRings[a].empty() || vertexRings[a].back() != k)
+                vertexRings[a].push_back(k);
+            z[i] = x[a];
+            meanLength += calcLength(x[a], x[rings[k][(i+1)%n]]);
+            ++numEdge;
+        }
+        orients[k] = RemapGrid::calcArea(&z[0], n) > 0.0 ? 1.0 : -1.0;
+    }
+    if (numEdge == 0)
+        return 0;
+    meanLength /= numEdge;
+    // -------------------------------------------------------------------------
+    // short edges
+    Vector y;
+    for (int k = 0; k < rings.size(); ++k) {
+        int n = static_cast<int>(rings[k].size());
+        for (int i = 0; i < n; ++i) {
+            const Vector &x1 = x[rings[k][i]];
+            const Vector &x2 = x[rings[k][(i+1)%n]];
+            if (calcLength(x1, x2) < collapseRatio*meanLength &&
+                canCollapse(x, rings, numMovableVertex, k, i, y)) {
+                apply(x, rings, k, i, y, collapses);
+                break;
+            }
+        }
+    }
+    // -------------------------------------------------------------------------
+    // polygons over the limit of edge number
+    Vector bestY;
+    for (int k = 0; k < rings.size(); ++k) {
+        while (static_cast<int>(rings[k].size()) > maxNumEdge) {
+            int n = static_cast<int>(rings[k].size());
+            int best = -1;
+            double minLength = 0.0;
+            for (int i = 0; i < n; ++i) {
+                double length = calcLength(x[rings[k][i]],
+                                           x[rings[k][(i+1)%n]]);
+                if ((best == -1 || length < minLength) &&
+                    canCollapse(x, rings, numMovableVertex, k, i, y)) {
+                    best = i;
+                    minLength = length;
+                    bestY = y;
+                }
+            }
+            if (best == -1)
+                break;
+            apply(x, rings, k, best, bestY, collapses);
+        }
+    }
+    return static_cast<int>(collapses.size());
+}
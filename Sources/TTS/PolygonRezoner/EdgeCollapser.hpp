@@ -0,0 +1,39 @@
+#ifndef EdgeCollapser_h
+#define EdgeCollapser_h
+
+#include "Vector.hpp"
+#include <vector>
+
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// EdgeCollapser reduces the edge numbers of the polygons in a patch by
+// collapsing the edges between movable vertices into their middle points. It
+// works on the arrays of the patch (the polygons are the rings of the vertex
+// indices, and the movable vertices come first), so the polygons around each
+// movable vertex are all known, and the collapses are returned in order to be
+// applied to the mesh. An edge is collapsed only when
+//   (1) both polygons of it keep at least three edges;
+//   (2) its end points have no other common neighbor, so no duplicate edge or
+//       pinched polygon is created;
+//   (3) no polygon around it is inverted by the middle point.
+
+namespace EdgeCollapser
+{
+    // the removed vertex is merged into the kept one
+    struct Collapse
+    {
+        int kept, removed;
+    };
+
+    // Collapse the edges shorter than collapseRatio times the mean edge
+    // length (at most one for each polygon), and then the shortest edges of
+    // the polygons with more than maxNumEdge edges until they are under the
+    // limit or no edge of them can be collapsed. The coordinates and rings
+    // are updated, and the number of collapsed edges is returned.
+    int collapse(vector<Vector> &x, vector<vector<int> > &rings,
+                 int numMovableVertex, int maxNumEdge, double collapseRatio,
+                 vector<Collapse> &collapses);
+}
+
+#endif
@@ -0,0 +1,570 @@
+#include "PatchRezoner.hpp"
+#include "MeshManager.hpp"
+#include "MeshAdaptor.hpp"
+#include "FlowManager.hpp"
+#include "TracerManager.hpp"
+#include "ApproachDetector.hpp"
+#include "CommonTasks.hpp"
+#include "SweptEdgeDetector.hpp"
+#include "EdgeCollapser.hpp"
+#include "SupermeshRemapper.hpp"
+#include "RemapGrid.hpp"
+#include "ConfigTools.hpp"
+#include "Constants.hpp"
+#include <vector>
+#include <set>
+#include <map>
+#include <ctime>
+
+using std::vector;
+
+namespace PatchRezoner
+{
+    // thresholds of distortion
+    static int maxNumEdge = 10;
+    static double maxAspectRatio = 4.0;
+    static double maxAreaRatio = 4.0;
+    // rings of neighbors around the distorted polygons
+    static int numHalo = 1;
+    static int numIteration = 20;
+    // the edges inside the patches that are shorter than this ratio of the
+    // mean edge length are collapsed
+    static double collapseRatio = 0.2;
+
+    // The patch polygons in arrays, where the rings are the indices of the
+    // vertices, and the vertices that can be moved come first.
+    struct Patch
+    {
+        vector<Polygon *> polygons;
+        std::set<Polygon *> members;
+        vector<Vertex *> vertices;
+        int numMovableVertex;
+        vector<Vector> x;
+        vector<vector<int> > rings;
+        // the polygons around each movable vertex
+        vector<vector<int> > vertexPolygons;
+        // the polygons with movable vertices
+        vector<int> activePolygons;
+        // orientations of the polygons, and whether they are star-shaped with
+        // respect to their centroids
+        vector<double> orients;
+        vector<bool> isStarShaped;
+    };
+
+    static Patch patch;
+
+    double calcAspectRatio(const Vector *x, int n);
+    bool isDistorted(Polygon *polygon, double meanArea);
+    int selectPatch(PolygonManager &polygonManager);
+    void buildPatch();
+    Vector calcCentroid(int k);
+    bool isStarShaped(int k);
+    bool isValid(int k);
+    int relax();
+    int collapseEdges(PolygonManager &polygonManager);
+    int countOverLimit();
+    void setCoordinate(Vertex *vertex, const Vector &x);
+    void updateMesh(MeshManager &meshManager);
+}
+
+using namespace PatchRezoner;
+
+void PatchRezoner::init()
+{
+    if (ConfigTools::hasKey("rezone_patch_max_num_edge"))
+        ConfigTools::read("rezone_patch_max_num_edge", maxNumEdge);
+    if (ConfigTools::hasKey("rezone_patch_max_aspect_ratio"))
+        ConfigTools::read("rezone_patch_max_aspect_ratio", maxAspectRatio);
+    if (ConfigTools::hasKey("rezone_patch_max_area_ratio"))
+        ConfigTools::read("rezone_patch_max_area_ratio", maxAreaRatio);
+    if (ConfigTools::hasKey("rezone_patch_halo"))
+        ConfigTools::read("rezone_patch_halo", numHalo);
+    if (ConfigTools::hasKey("rezone_patch_iteration"))
+        ConfigTools::read("rezone_patch_iteration", numIteration);
+    if (ConfigTools::hasKey("rezone_patch_collapse_ratio"))
+        ConfigTools::read("rezone_patch_collapse_ratio", collapseRatio);
+}
+
+/*
+ * Function:
+ *   calcAspectRatio
+ * Purpose:
+ *   Calculate the aspect ratio of the polygon from the principal axes of its
+ *   vertices on the tangent plane at their centroid.
+ */
+double PatchRezoner::calcAspectRatio(const Vector *x, int n)
+{
+    Vector c = 0.0;
+    for (int i = 0; i < n; ++i)
+        c += x[i];
+    if (norm(c) < 1.0e-12)
+        return 1.0e34;
+    c /= norm(c);
+    Vector axis = 0.0;
+    axis(fabs(c(2)) < 0.9 ? 2 : 0) = 1.0;
+    Vector e1 = norm_cross(c, axis);
+    Vector e2 = cross(c, e1);
+    double u0 = 0.0, v0 = 0.0, uu = 0.0, uv = 0.0, vv = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double u = dot(x[i], e1), v = dot(x[i], e2);
+        u0 += u; v0 += v;
+        uu += u*u; uv += u*v; vv += v*v;
+    }
+    u0 /= n; v0 /= n;
+    uu = uu/n-u0*u0; uv = uv/n-u0*v0; vv = vv/n-v0*v0;
+    double mean = 0.5*(uu+vv);
+    double diff = sqrt(0.25*(uu-vv)*(uu-vv)+uv*uv);
+    if (mean-diff <= 1.0e-30)
+        return 1.0e34;
+    return sqrt((mean+diff)/(mean-diff));
+}
+
+bool PatchRezoner::isDistorted(Polygon *polygon, double meanArea)
+{
+    int n = polygon->edgePointers.size();
+    if (n > maxNumEdge)
+        return true;
+    double ratio = polygon->getArea()/meanArea;
+    if (ratio > maxAreaRatio || ratio < 1.0/maxAreaRatio)
+        return true;
+    vector<Vector> x(n);
+    EdgePointer *edgePointer = polygon->edgePointers.front();
+    for (int i = 0; i < n; ++i) {
+        x[i] = edgePointer->getEndPoint(FirstPoint)->getCoordinate().getCAR();
+        edgePointer = edgePointer->next;
+    }
+    return calcAspectRatio(&x[0], n) > maxAspectRatio;
+}
+
+/*
+ * Function:
+ *   selectPatch
+ * Purpose:
+ *   Collect the distorted polygons and their neighbors into the patch.
+ * Return value:
+ *   The number of the distorted polygons.
+ */
+int PatchRezoner::selectPatch(PolygonManager &polygonManager)
+{
+    patch.polygons.clear();
+    patch.members.clear();
+    double meanArea = 4.0*PI*Sphere::radius2/polygonManager.polygons.size();
+    vector<Polygon *> front, next;
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int i = 0; i < polygonManager.polygons.size(); ++i) {
+        // Note: The line polygons are handled by ApproachDetector.
+        if (polygon->edgePointers.size() > 2 &&
+            isDistorted(polygon, meanArea)) {
+            patch.members.insert(polygon);
+            patch.polygons.push_back(polygon);
+            front.push_back(polygon);
+        }
+        polygon = polygon->next;
+    }
+    int numDistorted = static_cast<int>(front.size());
+    for (int h = 0; h < numHalo; ++h) {
+        next.clear();
+        for (int k = 0; k < front.size(); ++k) {
+            EdgePointer *edgePointer = front[k]->edgePointers.front();
+            for (int i = 0; i < front[k]->edgePointers.size(); ++i) {
+                polygon = edgePointer->getPolygon(OrientRight);
+                if (polygon != NULL && polygon->edgePointers.size() > 2 &&
+                    patch.members.insert(polygon).second) {
+                    patch.polygons.push_back(polygon);
+                    next.push_back(polygon);
+                }
+                edgePointer = edgePointer->next;
+            }
+        }
+        front.swap(next);
+    }
+    return numDistorted;
+}
+
+/*
+ * Function:
+ *   buildPatch
+ * Purpose:
+ *   Set the arrays of the patch from the current polygons. A vertex can be
+ *   moved when all its edges are inside the patch, otherwise it is on the
+ *   patch boundary and is fixed.
+ */
+void PatchRezoner::buildPatch()
+{
+    vector<Vertex *> movables, fixeds;
+    std::set<Vertex *> visited;
+    for (int k = 0; k < patch.polygons.size(); ++k) {
+        EdgePointer *edgePointer = patch.polygons[k]->edgePointers.front();
+        for (int i = 0; i < patch.polygons[k]->edgePointers.size(); ++i) {
+            Vertex *vertex = edgePointer->getEndPoint(FirstPoint);
+            edgePointer = edgePointer->next;
+            if (!visited.insert(vertex).second)
+                continue;
+            bool isMovable = true;
+            EdgePointer *linkedEdge = vertex->linkedEdges.front();
+            for (int j = 0; j < vertex->linkedEdges.size(); ++j) {
+                if (patch.members.count(linkedEdge->edge->getPolygon(OrientLeft)) == 0 ||
+                    patch.members.count(linkedEdge->edge->getPolygon(OrientRight)) == 0) {
+                    isMovable = false;
+                    break;
+                }
+                linkedEdge = linkedEdge->next;
+            }
+            if (isMovable)
+                movables.push_back(vertex);
+            else
+                fixeds.push_back(vertex);
+        }
+    }
+    patch.numMovableVertex = static_cast<int>(movables.size());
+    patch.vertices.swap(movables);
+    patch.vertices.insert(patch.vertices.end(), fixeds.begin(), fixeds.end());
+    std::map<Vertex *, int> indices;
+    patch.x.resize(patch.vertices.size());
+    for (int i = 0; i < patch.vertices.size(); ++i) {
+        indices[patch.vertices[i]] = i;
+        patch.x[i] = patch.vertices[i]->getCoordinate().getCAR();
+    }
+    // -------------------------------------------------------------------------
+    int numPolygon = static_cast<int>(patch.polygons.size());
+    patch.rings.assign(numPolygon, vector<int>());
+    patch.vertexPolygons.assign(patch.numMovableVertex, vector<int>());
+    patch.activePolygons.clear();
+    patch.orients.resize(numPolygon);
+    patch.isStarShaped.resize(numPolygon);
+    for (int k = 0; k < numPolygon; ++k) {
+        bool isActive = false;
+        EdgePointer *edgePointer = patch.polygons[k]->edgePointers.front();
+        for (int i = 0; i < patch.polygons[k]->edgePointers.size(); ++i) {
+            int j = indices[edgePointer->getEndPoint(FirstPoint)];
+            patch.rings[k].push_back(j);
+            if (j < patch.numMovableVertex) {
+                if (patch.vertexPolygons[j].empty() ||
+                    patch.vertexPolygons[j].back() != k)
+                    patch.vertexPolygons[j].push_back(k);
+                isActive = true;
+            }
+            edgePointer = edgePointer->next;
+        }
+        if (isActive)
+            patch.activePolygons.push_back(k);
+        // Note: The orientation is kept during the relaxation.
+        vector<Vector> x(patch.rings[k].size());
+        for (int i = 0; i < x.size(); ++i)
+            x[i] = patch.x[patch.rings[k][i]];
+        patch.orients[k] = RemapGrid::calcArea(&x[0], static_cast<int>(x.size())) > 0.0 ? 1.0 : -1.0;
+        patch.isStarShaped[k] = isStarShaped(k);
+    }
+}
+
+void PatchRezoner::setCoordinate(Vertex *vertex, const Vector &x)
+{
+    Vector y = x;
+    y /= norm(y);
+    Coordinate coordinate;
+    coordinate.setCAR(y(0), y(1), y(2));
+    vertex->setCoordinate(coordinate);
+}
+
+Vector PatchRezoner::calcCentroid(int k)
+{
+    // Note: The centroid is the same as Sphere::calcCentroid.
+    Vector c = 0.0;
+    for (int i = 0; i < patch.rings[k].size(); ++i)
+        c += patch.x[patch.rings[k][i]];
+    c /= norm(c);
+    return c;
+}
+
+bool PatchRezoner::isStarShaped(int k)
+{
+    const vector<int> &ring = patch.rings[k];
+    Vector c = calcCentroid(k);
+    int n = static_cast<int>(ring.size());
+    for (int i = 0; i < n; ++i)
+        if (patch.orients[k]*dot(c, cross(patch.x[ring[i]],
+                                          patch.x[ring[(i+1)%n]])) <= 0.0)
+            return false;
+    return true;
+}
+
+bool PatchRezoner::isValid(int k)
+{
+    if (patch.isStarShaped[k])
+        return isStarShaped(k);
+    vector<Vector> x(patch.rings[k].size());
+    for (int i = 0; i < x.size(); ++i)
+        x[i] = patch.x[patch.rings[k][i]];
+    return patch.orients[k]*RemapGrid::calcArea(&x[0], static_cast<int>(x.size())) > 0.0;
+}
+
+/*
+ * Function:
+ *   relax
+ * Purpose:
+ *   Move the movable vertices to the Voronoi vertices of the centroids of
+ *   their polygons (or the mean of the centroids when the Voronoi vertex is
+ *   not inside them) iteratively. The moves are halved when any polygon gets
+ *   invalid (inverted or not star-shaped any more).
+ * Return value:
+ *   The number of iterations.
+ */
+int PatchRezoner::relax()
+{
+    static const double eps = 1.0e-8;
+    int numPolygon = static_cast<int>(patch.polygons.size());
+    vector<Vector> centroids(numPolygon), targets(patch.numMovableVertex);
+    vector<Vector> x0(patch.numMovableVertex);
+    int k;
+    for (k = 0; k < numIteration; ++k) {
+        for (int p = 0; p < numPolygon; ++p)
+            centroids[p] = calcCentroid(p);
+        for (int i = 0; i < patch.numMovableVertex; ++i) {
+            const vector<int> &ps = patch.vertexPolygons[i];
+            Vector mean = 0.0;
+            for (int j = 0; j < ps.size(); ++j)
+                mean += centroids[ps[j]];
+            targets[i] = mean;
+            targets[i] /= norm(mean);
+            if (ps.size() != 3)
+                continue;
+            const Vector &g0 = centroids[ps[0]];
+            const Vector &g1 = centroids[ps[1]];
+            const Vector &g2 = centroids[ps[2]];
+            Vector c = cross(g1-g0, g2-g0);
+            if (norm(c) < eps*eps)
+                continue;
+            c /= norm(c);
+            if (dot(c, targets[i]) < 0.0)
+                c *= -1.0;
+            double s0 = dot(c, cross(g0, g1));
+            double s1 = dot(c, cross(g1, g2));
+            double s2 = dot(c, cross(g2, g0));
+            if ((s0 > 0.0 && s1 > 0.0 && s2 > 0.0) ||
+                (s0 < 0.0 && s1 < 0.0 && s2 < 0.0))
+                targets[i] = c;
+        }
+        // ---------------------------------------------------------------------
+        for (int i = 0; i < patch.numMovableVertex; ++i)
+            x0[i] = patch.x[i];
+        double omega = 1.0, maxMove = 0.0;
+        bool isAccepted = false;
+        for (int trial = 0; trial < 5 && !isAccepted; ++trial, omega *= 0.5) {
+            maxMove = 0.0;
+            for (int i = 0; i < patch.numMovableVertex; ++i) {
+                patch.x[i] = (1.0-omega)*x0[i]+omega*targets[i];
+                patch.x[i] /= norm(patch.x[i]);
+                maxMove = fmax(maxMove, norm(patch.x[i]-x0[i]));
+            }
+            isAccepted = true;
+            for (int j = 0; j < patch.activePolygons.size(); ++j)
+                if (!isValid(patch.activePolygons[j])) {
+                    isAccepted = false;
+                    break;
+                }
+        }
+        if (!isAccepted) {
+            for (int i = 0; i < patch.numMovableVertex; ++i)
+                patch.x[i] = x0[i];
+            break;
+        }
+        if (maxMove < eps)
+            break;
+    }
+    for (int i = 0; i < patch.numMovableVertex; ++i)
+        setCoordinate(patch.vertices[i], patch.x[i]);
+    return k;
+}
+
+/*
+ * Function:
+ *   collapseEdges
+ * Purpose:
+ *   Collapse the short edges between two movable vertices into their middle
+ *   points, and the edges of the polygons over the limit of edge number until
+ *   they are under it (see EdgeCollapser), and apply them to the mesh.
+ * Return value:
+ *   The number of collapsed edges.
+ */
+int PatchRezoner::collapseEdges(PolygonManager &polygonManager)
+{
+    vector<EdgeCollapser::Collapse> collapses;
+    EdgeCollapser::collapse(patch.x, patch.rings, patch.numMovableVertex,
+                            maxNumEdge, collapseRatio, collapses);
+    for (int c = 0; c < collapses.size(); ++c) {
+        Vertex *vertex1 = patch.vertices[collapses[c].kept];
+        Vertex *vertex2 = patch.vertices[collapses[c].removed];
+        // find the edge pointer from vertex1 to vertex2, so that vertex1 is
+        // kept by removeEdge
+        EdgePointer *edgePointer = NULL;
+        EdgePointer *linkedEdge = vertex1->linkedEdges.front();
+        for (int j = 0; j < vertex1->linkedEdges.size(); ++j) {
+            Edge *edge = linkedEdge->edge;
+            if (edge->getEndPoint(SecondPoint) == vertex2) {
+                edgePointer = edge->getEdgePointer(OrientLeft);
+                break;
+            } else if (edge->getEndPoint(FirstPoint) == vertex2) {
+                edgePointer = edge->getEdgePointer(OrientRight);
+                break;
+            }
+            linkedEdge = linkedEdge->next;
+        }
+        if (edgePointer == NULL)
+            REPORT_ERROR("The edge to be collapsed is not found!");
+        // Note: The projections of the removed vertex are cleaned, and those
+        //       of the removed edge are cleaned by itself.
+        vertex2->detectAgent.clean();
+        edgePointer->getPolygon(OrientLeft)->removeEdge(edgePointer,
+                                                        polygonManager);
+        setCoordinate(vertex1, patch.x[collapses[c].kept]);
+    }
+    return static_cast<int>(collapses.size());
+}
+
+int PatchRezoner::countOverLimit()
+{
+    int count = 0;
+    for (int k = 0; k < patch.rings.size(); ++k)
+        if (static_cast<int>(patch.rings[k].size()) > maxNumEdge)
+            ++count;
+    return count;
+}
+
+/*
+ * Function:
+ *   updateMesh
+ * Purpose:
+ *   Update the geometry and locations of the moved vertices, and the edges
+ *   and polygons of the patch. The old time levels are set the same as the
+ *   new ones, since the moves are not advection.
+ */
+void PatchRezoner::updateMesh(MeshManager &meshManager)
+{
+    std::set<Edge *> edges;
+    for (int i = 0; i < patch.numMovableVertex; ++i) {
+        Vertex *vertex = patch.vertices[i];
+        Coordinate x = vertex->getCoordinate();
+        vertex->setCoordinate(x, OldTimeLevel);
+        Location loc;
+        meshManager.checkLocation(x, loc, vertex);
+        vertex->setLocation(loc);
+        EdgePointer *linkedEdge = vertex->linkedEdges.front();
+        for (int j = 0; j < vertex->linkedEdges.size(); ++j) {
+            edges.insert(linkedEdge->edge);
+            linkedEdge = linkedEdge->next;
+        }
+    }
+    for (std::set<Edge *>::iterator it = edges.begin(); it != edges.end(); ++it) {
+        Edge *edge = *it;
+        edge->calcNormVector();
+        edge->calcNormVector();
+        edge->calcLength();
+        TestPoint *testPoint = edge->getTestPoint();
+        testPoint->reset(meshManager);
+        testPoint->setCoordinate(testPoint->getCoordinate(), OldTimeLevel);
+    }
+    for (int k = 0; k < patch.polygons.size(); ++k) {
+        Polygon *polygon = patch.polygons[k];
+        EdgePointer *edgePointer = polygon->edgePointers.front();
+        for (int i = 0; i < polygon->edgePointers.size(); ++i) {
+            edgePointer->calcAngle();
+            edgePointer->calcAngle();
+            edgePointer = edgePointer->next;
+        }
+        polygon->calcArea();
+        polygon->calcArea();
+    }
+}
+
+void PatchRezoner::rezone(MeshManager &meshManager, MeshAdaptor &meshAdaptor,
+                          const FlowManager &flowManager,
+                          TracerManager &tracerManager)
+{
+    clock_t start, end;
+    start = clock();
+    PolygonManager &polygonManager = tracerManager.polygonManager;
+    // -------------------------------------------------------------------------
+    // 1. Select the patches
+    int numDistorted = selectPatch(polygonManager);
+    if (numDistorted == 0) {
+        NOTICE("PatchRezoner::rezone", "No distorted polygon is found.");
+        return;
+    }
+    buildPatch();
+    // -------------------------------------------------------------------------
+    // 2. Clean the projections of the objects to be changed
+    for (int i = 0; i < patch.numMovableVertex; ++i) {
+        Vertex *vertex = patch.vertices[i];
+        vertex->detectAgent.clean();
+        EdgePointer *linkedEdge = vertex->linkedEdges.front();
+        for (int j = 0; j < vertex->linkedEdges.size(); ++j) {
+            linkedEdge->edge->detectAgent.clean();
+            linkedEdge->edge->getTestPoint()->detectAgent.clean();
+            linkedEdge = linkedEdge->next;
+        }
+    }
+    SupermeshRemapper::saveSource(patch.polygons, tracerManager);
+    // -------------------------------------------------------------------------
+    // 3. Relax the patches with the boundaries fixed, and collapse the short
+    //    edges and those of the polygons over the limit of edge number
+    // Note: The relaxation may allow more collapses, and each round removes
+    //       some vertices, so the rounds stop.
+    int numIter = relax();
+    int numCollapsed = 0;
+    while (true) {
+        int n = collapseEdges(polygonManager);
+        if (n == 0)
+            break;
+        numCollapsed += n;
+        buildPatch();
+        numIter += relax();
+        if (countOverLimit() == 0)
+            break;
+    }
+    int numOverLimit = countOverLimit();
+    if (numOverLimit > 0) {
+        Message message;
+        message << numOverLimit << " patch polygons are still over ";
+        message << "rezone_patch_max_num_edge, since their edges can not be ";
+        message << "collapsed.";
+        NOTICE("PatchRezoner::rezone", message.str());
+    }
+    updateMesh(meshManager);
+    // -------------------------------------------------------------------------
+    // 4. Transfer the tracer masses among the patch polygons
+    SupermeshRemapper::remap(patch.polygons, tracerManager);
+    // -------------------------------------------------------------------------
+    // 5. Redetect the approaching vertices in the patches
+    SweptEdgeDetector::build(polygonManager);
+    for (int k = 0; k < patch.polygons.size(); ++k) {
+        // Note: The polygon may be removed by the previous detections.
+        if (patch.polygons[k]->endTag == ListElement<Polygon>::Null)
+            continue;
+        ApproachDetector::detectPolygon(meshManager, flowManager,
+                                        polygonManager, patch.polygons[k]);
+    }
+#ifdef TTS_CGA_SPLIT_POLYGONS
+    ApproachDetector::ApproachingVertices::clear();
+#endif
+    for (int k = 0; k < patch.polygons.size(); ++k) {
+        if (patch.polygons[k]->endTag == ListElement<Polygon>::Null)
+            continue;
+        EdgePointer *edgePointer = patch.polygons[k]->edgePointers.front();
+        for (int i = 0; i < patch.polygons[k]->edgePointers.size(); ++i) {
+            edgePointer->getEndPoint(FirstPoint)->tags.reset();
+            edgePointer->edge->tags.reset();
+            edgePointer = edgePointer->next;
+        }
+    }
+    CommonTasks::resetTasks();
+    SweptEdgeDetector::clear();
+#ifdef TTS_REMAP
+    tracerManager.setDensityStale(meshAdaptor, meshManager);
+#endif
+    end = clock();
+    cout << "[Timing]: PatchRezoner::rezone: " << numDistorted;
+    cout << " distorted polygons in " << patch.polygons.size();
+    cout << " patch polygons, " << numIter << " iterations, ";
+    cout << numCollapsed << " collapsed edges: " << setprecision(5);
+    cout << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
+}
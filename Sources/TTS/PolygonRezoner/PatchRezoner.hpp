@@ -0,0 +1,44 @@
+#ifndef PatchRezoner_h
+#define PatchRezoner_h
+
+class MeshManager;
+class MeshAdaptor;
+class FlowManager;
+class TracerManager;
+
+// -----------------------------------------------------------------------------
+// PatchRezoner rezones only the distorted regions of the polygon mesh instead
+// of replacing all the polygons with a global SCVT:
+//   (1) The polygons whose edge numbers, aspect ratios or area ratios against
+//       the mean area exceed the thresholds are selected, and each of them is
+//       extended by some rings of neighbors to form the patches.
+//   (2) The vertices inside the patches are relaxed by the Lloyd iteration
+//       with fixed connectivity (each vertex moves to the circumcenter of the
+//       centroids of its polygons, which is the Voronoi vertex of them), and
+//       the vertices on the patch boundaries are fixed, so the polygons
+//       outside are untouched. The short edges inside the patches are
+//       collapsed, and so are the edges of the polygons over the limit of
+//       edge number until they are under it (see EdgeCollapser).
+//   (3) The tracer masses are transferred among the patch polygons by
+//       SupermeshRemapper, which is conservative since the patches cover the
+//       same regions before and after.
+// So the cost scales with the distorted area rather than the whole sphere.
+//
+// Configuration keys:
+//   rezone_patch_max_num_edge      limit of edge number (10)
+//   rezone_patch_max_aspect_ratio  limit of aspect ratio (4)
+//   rezone_patch_max_area_ratio    limit of area ratio against the mean (4)
+//   rezone_patch_halo              rings of neighbors in the patches (1)
+//   rezone_patch_iteration         maximum iterations of relaxation (20)
+//   rezone_patch_collapse_ratio    edges shorter than this ratio of the mean
+//                                  edge length are collapsed (0.2)
+
+namespace PatchRezoner
+{
+    void init();
+
+    void rezone(MeshManager &, MeshAdaptor &, const FlowManager &,
+                TracerManager &);
+}
+
+#endif
@@ -5,42 +5,154 @@
 #include "TracerManager.hpp"
 #include "DelaunayDriver.hpp"
 #include "SCVT.hpp"
+#include "DensityBuilder.hpp"
+#include "PatchRezoner.hpp"
+#include "QualityMonitor.hpp"
 #include "TimeManager.hpp"
 #include "ApproachDetector.hpp"
 #include "CommonTasks.hpp"
+#include "SweptEdgeDetector.hpp"
+#include "SupermeshRemapper.hpp"
 #include "ConfigTools.hpp"
 #include "CppHelper.hpp"
+#include "SystemCalls.hpp"
 #include <netcdfcpp.h>
+#include <pthread.h>
+#include <sstream>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace PolygonRezoner {
     // running controls
     int frequency = -1;
+    // rezone the distorted patches only (see PatchRezoner)
+    bool isLocal = false;
+    // generate SCVT in a worker thread while advecting (see handover)
+    bool isAsync = false;
+    // trigger the rezoning by mesh quality instead of frequency
+    bool isQualityTriggered = false;
     // SCVT controls
     int numGenerator = -1;
     int maxIteration = -1;
     double minRho = 0.0;
+    DensityBuilder densityBuilder;
+    // write the density function into scvt_rho_<ID>.nc on each rezoning
+    bool isOutputDensity = false;
     //
     DelaunayDriver driver;
+    // the background rezoning job
+    struct Job
+    {
+        Job() : isRunning(false), isDone(false), startStep(-1), workTime(0.0) {
+            pthread_mutex_init(&mutex, NULL);
+        }
+
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        bool isRunning, isDone;
+        int startStep;
+        double workTime;
+        string ID;
+        // the notices and timings of the worker, which are printed in
+        // handover, since cout is used by the main thread
+        std::ostringstream log;
+    } job;
+
+    void generateDensity(MeshManager &meshManager,
+                         TracerManager &tracerManager, const string &ID);
+    void replacePolygons(MeshManager &meshManager, MeshAdaptor &meshAdaptor,
+                         const FlowManager &flowManager,
+                         TracerManager &tracerManager);
+    void *runJob(void *);
+    double getWallTime();
 }
 
 void PolygonRezoner::init()
 {
-    if (ConfigTools::hasKey("rezone_num_generator")) {
-        ConfigTools::read("rezone_num_generator", numGenerator);
+    if (ConfigTools::hasKey("rezone_mode")) {
+        string mode;
+        ConfigTools::read("rezone_mode", mode);
+        if (mode == "local")
+            isLocal = true;
+        else if (mode == "async")
+            isAsync = true;
+        else if (mode != "global")
+            REPORT_ERROR("Unknown rezone_mode \""+mode+"\".");
+    }
+    if (ConfigTools::hasKey("rezone_trigger")) {
+        string trigger;
+        ConfigTools::read("rezone_trigger", trigger);
+        if (trigger == "quality")
+            isQualityTriggered = true;
+        else if (trigger != "frequency")
+            REPORT_ERROR("Unknown rezone_trigger \""+trigger+"\".");
+    }
+    if (isQualityTriggered)
+        QualityMonitor::init();
+    else if (isLocal || ConfigTools::hasKey("rezone_num_generator")) {
         ConfigTools::read("rezone_frequency", frequency);
+        TimeManager::setAlarm("polygon rezoning", frequency);
+    }
+    if (isLocal) {
+        PatchRezoner::init();
+    } else if (ConfigTools::hasKey("rezone_num_generator")) {
+        ConfigTools::read("rezone_num_generator", numGenerator);
         ConfigTools::read("rezone_min_rho", minRho);
         ConfigTools::read("rezone_max_iteration", maxIteration);
-        TimeManager::setAlarm("polygon rezoning", frequency);
+        densityBuilder.init();
+        if (ConfigTools::hasKey("rezone_output_density")) {
+            string output;
+            ConfigTools::read("rezone_output_density", output);
+            if (output == "yes")
+                isOutputDensity = true;
+            else if (output != "no")
+                REPORT_ERROR("Unknown rezone_output_density \""+output+"\".");
+        }
+        if (ConfigTools::hasKey("rezone_quadrature_order")) {
+            int quadratureOrder;
+            ConfigTools::read("rezone_quadrature_order", quadratureOrder);
+            SCVT::setQuadratureOrder(quadratureOrder);
+        }
+        if (ConfigTools::hasKey("rezone_scvt_solver")) {
+            string solver;
+            ConfigTools::read("rezone_scvt_solver", solver);
+            SCVT::setSolver(solver);
+        }
+        if (ConfigTools::hasKey("rezone_anderson_depth")) {
+            int depth;
+            ConfigTools::read("rezone_anderson_depth", depth);
+            SCVT::setAndersonDepth(depth);
+        }
+        if (ConfigTools::hasKey("rezone_scvt_num_level")) {
+            int numLevel;
+            ConfigTools::read("rezone_scvt_num_level", numLevel);
+            SCVT::setNumLevel(numLevel);
+        }
     }
 }
 
-void PolygonRezoner::rezone(MeshManager &meshManager,
-                            MeshAdaptor &meshAdaptor,
-                            const FlowManager &flowManager,
-                            TracerManager &tracerManager)
+bool PolygonRezoner::isTriggered(const MeshManager &meshManager,
+                                 const TracerManager &tracerManager)
+{
+    if (isQualityTriggered)
+        return QualityMonitor::check(meshManager, tracerManager.polygonManager);
+    return TimeManager::isAlarmed("polygon rezoning");
+}
+
+/*
+ * Function:
+ *   generateDensity
+ * Purpose:
+ *   Set the density function of SCVT from the current tracer density field.
+ *   The density function is the snapshot that SCVT uses afterwards, so the
+ *   tracer field can change during the background rezoning.
+ */
+void PolygonRezoner::generateDensity(MeshManager &meshManager,
+                                     TracerManager &tracerManager,
+                                     const string &ID)
 {
-    string ID = to_string(TimeManager::getSteps(), "%5.5d");
-    PolygonManager &polygonManager = tracerManager.polygonManager;
     // -------------------------------------------------------------------------
     // 0. Initialize SCVT
     static bool isFirstCall = true;
@@ -52,34 +164,35 @@ void PolygonRezoner::rezone(MeshManager &meshManager,
         isFirstCall = false;
     }
     // -------------------------------------------------------------------------
-    // 1. Generate density function
-    // =========================================================================
-    // 1.1. Use tracer density difference as a guide of density function setting
-    int idx = tracerManager.getTracerId("test tracer 0");
+    // 1. Generate density function from the tracer density differences
+    clock_t start = clock();
     Array<double, 2> &rho = SCVT::getDensityFunction();
-    rho = 0.0;
-    const Field &q = tracerManager.getTracerDensityField(idx);
-    const RLLMesh &mesh = q.getMesh();
-    for (int i = 1; i < mesh.getNumLon()-1; ++i)
-        for (int j = 1; j < mesh.getNumLat()-1; ++j) {
-            int k = i-1;
-            rho(k, j) =                 fabs(q.values(i, j).getNew()-q.values(i-1, j-1).getNew());
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i-1, j  ).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i-1, j+1).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i,   j-1).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i,   j+1).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i+1, j-1).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i+1, j  ).getNew()));
-            rho(k, j) = fmax(rho(k, j), fabs(q.values(i, j).getNew()-q.values(i+1, j+1).getNew()));
-        }
+    densityBuilder.build(tracerManager, rho);
     rho /= max(rho);
     rho = where(rho < minRho, minRho, rho);
-    SCVT::outputDensityFunction(ID);
-    // -------------------------------------------------------------------------
-    // 2. Generate SCVT according to the previous density function
-    SCVT::run(numGenerator, driver, ID);
+    cout << "[Timing]: PolygonRezoner::generateDensity: ";
+    cout << setprecision(5) << (double)(clock()-start)/CLOCKS_PER_SEC;
+    cout << " seconds." << endl;
+    if (isOutputDensity)
+        SCVT::outputDensityFunction(ID);
+}
+
+/*
+ * Function:
+ *   replacePolygons
+ * Purpose:
+ *   Replace the current polygons with the Voronoi cells in the driver, and
+ *   transfer the tracer masses from the current polygons to them.
+ */
+void PolygonRezoner::replacePolygons(MeshManager &meshManager,
+                                     MeshAdaptor &meshAdaptor,
+                                     const FlowManager &flowManager,
+                                     TracerManager &tracerManager)
+{
+    PolygonManager &polygonManager = tracerManager.polygonManager;
     // -------------------------------------------------------------------------
-    // 3. Replace the polygons with SCVT
+    // 1. Replace the polygons with SCVT
+    SupermeshRemapper::saveSource(polygonManager, tracerManager);
     polygonManager.reinit();
     polygonManager.init(driver);
     Vertex *vertex = polygonManager.vertices.front();
@@ -97,18 +210,116 @@ void PolygonRezoner::rezone(MeshManager &meshManager,
         testPoint->setLocation(loc);
         edge = edge->next;
     }
+    SweptEdgeDetector::build(polygonManager);
     ApproachDetector::detectPolygons(meshManager, flowManager, polygonManager);
 #ifdef TTS_CGA_SPLIT_POLYGONS
-    ApproachDetector::ApproachingVertices::vertices.clear();
+    ApproachDetector::ApproachingVertices::clear();
 #endif
     ApproachDetector::reset(polygonManager);
     CommonTasks::resetTasks();
+    SweptEdgeDetector::clear();
     // -------------------------------------------------------------------------
+    // 2. Transfer the tracer masses from the old polygons to the new ones
+    SupermeshRemapper::remap(tracerManager);
 #ifdef TTS_REMAP
-    meshAdaptor.adapt(tracerManager, meshManager);
-    for (int i = 0; i < tracerManager.getTracerNum(); ++i)
-        meshAdaptor.remap(tracerManager.getTracerName(i),
-                          tracerManager.getTracerDensityField(i),
-                          tracerManager);
+    tracerManager.setDensityStale(meshAdaptor, meshManager);
+#endif
+    if (isQualityTriggered)
+        QualityMonitor::reset(polygonManager);
+}
+
+double PolygonRezoner::getWallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return static_cast<double>(time(NULL));
 #endif
 }
+
+void *PolygonRezoner::runJob(void *)
+{
+    double start = getWallTime();
+    SCVT::run(numGenerator, driver, job.ID, &job.log);
+    pthread_mutex_lock(&job.mutex);
+    job.workTime = getWallTime()-start;
+    job.isDone = true;
+    pthread_mutex_unlock(&job.mutex);
+    return NULL;
+}
+
+void PolygonRezoner::rezone(MeshManager &meshManager,
+                            MeshAdaptor &meshAdaptor,
+                            const FlowManager &flowManager,
+                            TracerManager &tracerManager)
+{
+    if (isLocal) {
+        PatchRezoner::rezone(meshManager, meshAdaptor, flowManager,
+                             tracerManager);
+        if (isQualityTriggered)
+            QualityMonitor::reset(tracerManager.polygonManager);
+        return;
+    }
+    string ID = to_string(TimeManager::getSteps(), "%5.5d");
+    if (isAsync) {
+        if (job.isRunning) {
+            NOTICE("PolygonRezoner::rezone", "The previous rezoning is "
+                   "still running, so this one is skipped.");
+            return;
+        }
+        // Note: The density function and the driver are only touched by the
+        //       worker until the handover.
+        generateDensity(meshManager, tracerManager, ID);
+        job.ID = ID;
+        job.log.str("");
+        job.startStep = TimeManager::getSteps();
+        job.isDone = false;
+        job.isRunning = true;
+        if (pthread_create(&job.thread, NULL, runJob, NULL) != 0)
+            REPORT_ERROR("Failed to create the rezoning thread!");
+        Message message;
+        message << "Generating " << numGenerator << " generators in background.";
+        NOTICE("PolygonRezoner::rezone", message.str());
+        return;
+    }
+    generateDensity(meshManager, tracerManager, ID);
+    SCVT::run(numGenerator, driver, ID);
+    replacePolygons(meshManager, meshAdaptor, flowManager, tracerManager);
+    cout << "[Notice]: PolygonRezoner::rezone: Peak resident memory is ";
+    cout << SystemCalls::getPeakMemory() << " MB." << endl;
+}
+
+void PolygonRezoner::handover(MeshManager &meshManager,
+                              MeshAdaptor &meshAdaptor,
+                              const FlowManager &flowManager,
+                              TracerManager &tracerManager)
+{
+    if (!job.isRunning)
+        return;
+    pthread_mutex_lock(&job.mutex);
+    bool isDone = job.isDone;
+    pthread_mutex_unlock(&job.mutex);
+    // Note: The new polygons are swapped in at a later step than the one that
+    //       starts the job.
+    if (!isDone || TimeManager::getSteps() <= job.startStep)
+        return;
+    pthread_join(job.thread, NULL);
+    job.isRunning = false;
+    // -------------------------------------------------------------------------
+    // Note: The worker keeps the Delaunay triangulation (with the generators)
+    //       and the density snapshot besides the current polygons until here.
+    double overhead = (driver.DVT.size()*(sizeof(DelaunayVertex)+sizeof(Point))+
+                       driver.DT.size()*sizeof(DelaunayTriangle)+
+                       SCVT::getDensityFunction().size()*sizeof(double))/1048576.0;
+    clock_t start = clock();
+    replacePolygons(meshManager, meshAdaptor, flowManager, tracerManager);
+    cout << job.log.str();
+    cout << "[Timing]: PolygonRezoner::handover: Job started at step ";
+    cout << job.startStep << " is swapped in after ";
+    cout << TimeManager::getSteps()-job.startStep << " steps (worker ";
+    cout << setprecision(5) << job.workTime << " seconds, handover ";
+    cout << (double)(clock()-start)/CLOCKS_PER_SEC << " seconds)." << endl;
+    cout << "[Notice]: PolygonRezoner::handover: Background memory overhead is ";
+    cout << overhead << " MB, and peak resident memory is ";
+    cout << SystemCalls::getPeakMemory() << " MB." << endl;
+}
@@ -9,7 +9,23 @@ class TracerManager;
 namespace PolygonRezoner {
     void init();
 
+    // Return true if it is the time to rezone, which is given by the alarm of
+    // rezone_frequency, or by QualityMonitor when rezone_trigger = "quality".
+    // This should be called once per step after the vertices are tracked.
+    bool isTriggered(const MeshManager &, const TracerManager &);
+
+    // With rezone_mode = "async", rezone only snapshots the density function
+    // and starts to generate the SCVT in a worker thread (the alarms during
+    // the job are skipped), and the new polygons are swapped in by handover,
+    // which should be called at every step. The worker keeps the Delaunay
+    // triangulation and the density snapshot in memory besides the current
+    // polygons until the handover.
     void rezone(MeshManager &, MeshAdaptor &, const FlowManager &, TracerManager &);
+
+    // Replace the polygons with the result of the finished background job,
+    // and transfer the tracer masses conservatively from the current
+    // polygons. Do nothing if there is no finished job.
+    void handover(MeshManager &, MeshAdaptor &, const FlowManager &, TracerManager &);
 }
 
 #endif
@@ -0,0 +1,153 @@
+#include "QualityMonitor.hpp"
+#include "MeshManager.hpp"
+#include "PolygonManager.hpp"
+#include "TimeManager.hpp"
+#include "ConfigTools.hpp"
+#include "MetricsWriter.hpp"
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+
+namespace QualityMonitor
+{
+    // thresholds
+    static int maxEdgeNum = 40;
+    static double percentile = 0.95;
+    static int maxPercentileEdgeNum = 12;
+    static double maxOccupancy = 50.0;
+    static double maxVertexGrowth = 1.0;
+    static double hysteresis = 0.8;
+    static int minInterval = 1;
+    // states
+    static bool isArmed = true;
+    static int lastStep = -1;
+    static int referenceNumVertex = -1;
+    // histogram of the edge numbers of polygons
+    static vector<int> histogram;
+}
+
+using namespace QualityMonitor;
+
+void QualityMonitor::init()
+{
+    MetricsWriter::describe("quality", "max_edge_num  percentile_edge_num  "
+                            "occupancy  vertex_growth  armed");
+    MetricsWriter::describe("trigger", "reason");
+    MetricsWriter::describe("defer", "reason");
+    if (ConfigTools::hasKey("rezone_max_edge_num"))
+        ConfigTools::read("rezone_max_edge_num", maxEdgeNum);
+    if (ConfigTools::hasKey("rezone_edge_num_percentile"))
+        ConfigTools::read("rezone_edge_num_percentile", percentile);
+    if (ConfigTools::hasKey("rezone_percentile_edge_num"))
+        ConfigTools::read("rezone_percentile_edge_num", maxPercentileEdgeNum);
+    if (ConfigTools::hasKey("rezone_max_occupancy"))
+        ConfigTools::read("rezone_max_occupancy", maxOccupancy);
+    if (ConfigTools::hasKey("rezone_max_vertex_growth"))
+        ConfigTools::read("rezone_max_vertex_growth", maxVertexGrowth);
+    if (ConfigTools::hasKey("rezone_hysteresis"))
+        ConfigTools::read("rezone_hysteresis", hysteresis);
+    if (ConfigTools::hasKey("rezone_min_interval"))
+        ConfigTools::read("rezone_min_interval", minInterval);
+    if (percentile <= 0.0 || percentile > 1.0)
+        REPORT_ERROR("rezone_edge_num_percentile should be in (0, 1].");
+    if (hysteresis <= 0.0 || hysteresis > 1.0)
+        REPORT_ERROR("rezone_hysteresis should be in (0, 1].");
+}
+
+bool QualityMonitor::check(const MeshManager &meshManager,
+                           const PolygonManager &polygonManager)
+{
+    int step = TimeManager::getSteps();
+    if (referenceNumVertex < 0)
+        reset(polygonManager);
+    // -------------------------------------------------------------------------
+    // edge numbers of polygons
+    int numPolygon = polygonManager.polygons.size();
+    int maxNum = 0;
+    std::fill(histogram.begin(), histogram.end(), 0);
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int i = 0; i < numPolygon; ++i) {
+        int n = polygon->edgePointers.size();
+        if (n >= static_cast<int>(histogram.size()))
+            histogram.resize(n+1, 0);
+        histogram[n]++;
+        if (n > maxNum) maxNum = n;
+        polygon = polygon->next;
+    }
+    int percentileNum = 0;
+    int count = 0, target = static_cast<int>(ceil(percentile*numPolygon));
+    for (int n = 0; n < static_cast<int>(histogram.size()); ++n) {
+        count += histogram[n];
+        if (count >= target) {
+            percentileNum = n;
+            break;
+        }
+    }
+    // -------------------------------------------------------------------------
+    // occupancy of point counter (the points are counted during tracking)
+    const Array<int, 3> &counters = meshManager.getPointCounter().counters;
+    int maxCount = 0;
+    long totalCount = 0;
+    for (int i = 0; i < counters.extent(0); ++i)
+        for (int j = 0; j < counters.extent(1); ++j)
+            for (int k = 0; k < counters.extent(2); ++k) {
+                totalCount += counters(i, j, k);
+                if (counters(i, j, k) > maxCount)
+                    maxCount = counters(i, j, k);
+            }
+    double occupancy = totalCount != 0 ?
+        maxCount*static_cast<double>(counters.size())/totalCount : 0.0;
+    // -------------------------------------------------------------------------
+    // growth of vertex number since the last rezoning
+    double vertexGrowth = referenceNumVertex != 0 ?
+        static_cast<double>(polygonManager.vertices.size()-referenceNumVertex)/
+        referenceNumVertex : 0.0;
+    std::ostream &metrics = MetricsWriter::record("quality");
+    metrics << setw(6) << maxNum << "  ";
+    metrics << setw(6) << percentileNum << "  " << std::scientific;
+    metrics << setprecision(6) << occupancy << "  " << vertexGrowth << "  ";
+    metrics << isArmed << endl;
+    // -------------------------------------------------------------------------
+    // decide whether to trigger with hysteresis
+    if (!isArmed) {
+        if (maxNum < hysteresis*maxEdgeNum &&
+            percentileNum < hysteresis*maxPercentileEdgeNum &&
+            occupancy < hysteresis*maxOccupancy &&
+            vertexGrowth < hysteresis*maxVertexGrowth) {
+            isArmed = true;
+            MetricsWriter::record("rearm") << endl;
+        }
+        MetricsWriter::flush();
+        return false;
+    }
+    string reason;
+    if (maxNum > maxEdgeNum)
+        reason = "max_edge_num";
+    else if (percentileNum > maxPercentileEdgeNum)
+        reason = "percentile_edge_num";
+    else if (occupancy > maxOccupancy)
+        reason = "occupancy";
+    else if (vertexGrowth > maxVertexGrowth)
+        reason = "vertex_growth";
+    if (reason == "") {
+        MetricsWriter::flush();
+        return false;
+    }
+    if (lastStep >= 0 && step-lastStep < minInterval) {
+        MetricsWriter::record("defer") << reason << endl;
+        MetricsWriter::flush();
+        return false;
+    }
+    isArmed = false;
+    lastStep = step;
+    MetricsWriter::record("trigger") << reason << endl;
+    MetricsWriter::flush();
+    NOTICE("QualityMonitor::check", "Rezoning is triggered by "+reason+".");
+    return true;
+}
+
+void QualityMonitor::reset(const PolygonManager &polygonManager)
+{
+    referenceNumVertex = polygonManager.vertices.size();
+}
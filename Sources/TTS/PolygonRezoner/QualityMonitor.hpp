@@ -0,0 +1,45 @@
+#ifndef QualityMonitor_h
+#define QualityMonitor_h
+
+class MeshManager;
+class PolygonManager;
+
+// -----------------------------------------------------------------------------
+// QualityMonitor decides when to rezone from the quality of the polygon mesh
+// instead of a fixed frequency. The statistics are cheap enough to be gathered
+// on every step:
+//   (1) the maximum and a percentile of the edge numbers of the polygons,
+//       which drive the cost of the approach detection;
+//   (2) the occupancy of PointCounter, i.e. the maximum vertex number in a
+//       cell against the mean one, which shows the clustering of vertices;
+//   (3) the growth of the vertex number since the last rezoning.
+// The rezoning is triggered when any statistic exceeds its threshold. After
+// that, the monitor is disarmed until all the statistics fall below the
+// thresholds times the hysteresis ratio, so the rezoning does not fire again
+// and again around the thresholds (e.g. when the background job is running).
+// The statistics and the trigger decisions are written into the metrics file
+// (see MetricsWriter) as the "quality", "trigger", "defer" and "rearm" records.
+//
+// Configuration keys:
+//   rezone_max_edge_num          threshold of maximum edge number (40)
+//   rezone_edge_num_percentile   percentile of edge numbers (0.95)
+//   rezone_percentile_edge_num   threshold of the percentile (12)
+//   rezone_max_occupancy         threshold of PointCounter occupancy (50)
+//   rezone_max_vertex_growth     threshold of relative vertex growth (1)
+//   rezone_hysteresis            ratio of thresholds to rearm (0.8)
+//   rezone_min_interval          minimum steps between rezonings (1)
+
+namespace QualityMonitor
+{
+    void init();
+
+    // gather the statistics of this step, and return true if the rezoning
+    // should be triggered
+    bool check(const MeshManager &meshManager,
+               const PolygonManager &polygonManager);
+
+    // take the current mesh as the reference after rezoning
+    void reset(const PolygonManager &polygonManager);
+}
+
+#endif
@@ -3,17 +3,95 @@
 #include "RandomNumber.hpp"
 #include "Sphere.hpp"
 #include "PolygonManager.hpp"
+#include "ReportMacros.hpp"
+#include "DensitySampler.hpp"
 #include <netcdfcpp.h>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
 
 namespace SCVT {
     // density function
     Array<double, 2> rho;
     Array<double, 1> lonBnd, latBnd;
+    DensitySampler sampler;
     // running controls
     int maxIteration;
     double eps;
+    int quadratureOrder = 1;
 
     double getDensity(double lon, double lat);
+    void integrate(const Coordinate &x0, const Coordinate &x1,
+                   const Coordinate &x2, double rho0, double rho1,
+                   double rho2, Vector &car, double &W);
+
+    /*
+     * Symmetric quadrature rules on triangle in barycentric coordinates,
+     * which are exact for polynomials of degree 2 and 5, respectively.
+     */
+    const int numQuadPoint2 = 3;
+    const double quadPoint2[3][3] = {
+        {2.0/3.0, 1.0/6.0, 1.0/6.0},
+        {1.0/6.0, 2.0/3.0, 1.0/6.0},
+        {1.0/6.0, 1.0/6.0, 2.0/3.0}
+    };
+    const double quadWeight2[3] = {1.0/3.0, 1.0/3.0, 1.0/3.0};
+    const int numQuadPoint5 = 7;
+    const double quadPoint5[7][3] = {
+        {1.0/3.0, 1.0/3.0, 1.0/3.0},
+        {0.059715871789770, 0.470142064105115, 0.470142064105115},
+        {0.470142064105115, 0.059715871789770, 0.470142064105115},
+        {0.470142064105115, 0.470142064105115, 0.059715871789770},
+        {0.797426985353087, 0.101286507323456, 0.101286507323456},
+        {0.101286507323456, 0.797426985353087, 0.101286507323456},
+        {0.101286507323456, 0.101286507323456, 0.797426985353087}
+    };
+    const double quadWeight5[7] = {
+        0.225,
+        0.132394152788506, 0.132394152788506, 0.132394152788506,
+        0.125939180544827, 0.125939180544827, 0.125939180544827
+    };
+
+    double getWallTime();
+
+    // solvers
+    enum Solver {
+        LloydSolver, AndersonSolver
+    };
+    Solver solver = LloydSolver;
+    int andersonDepth = 5;
+    int numLevel = 1;
+    // Anderson history
+    vector<vector<Vector> > dF, dG;
+    vector<Vector> lastF, lastG;
+    double lastL2;
+
+    // buffers of the centroid calculation
+    vector<DelaunayVertex *> DVTs;
+    vector<DelaunayTriangle *> DTs;
+    vector<double> rhoDVT, rhoDT;
+
+    // the generators that the driver refers to
+    PointManager *pointManager = NULL;
+
+    // where the notices and timings of run go (see run)
+    std::ostream *logStream = &cout;
+
+    double calcCentroids(DelaunayDriver &driver, vector<Vector> &centroids,
+                         double &Linf);
+    double dot(const vector<Vector> &a, const vector<Vector> &b);
+    void accelerate(vector<Vector> &x, const vector<Vector> &g, double L2);
+    int iterate(DelaunayDriver &driver, double &L2);
+    void refine(DelaunayDriver &driver, int numPoint, vector<double> &lon,
+                vector<double> &lat);
+    void triangulate(DelaunayDriver &driver, vector<double> &lon,
+                     vector<double> &lat);
 }
 
 void SCVT::init(int numLon, int numLat, const double *lon, const double *lat,
@@ -45,26 +123,7 @@ void SCVT::init(int numLon, int numLat, const double *lon, const double *lat,
 double SCVT::getDensity(double lon, double lat)
 {
     int i, j;
-    bool isFound;
-    // -------------------------------------------------------------------------
-    isFound = false;
-    for (i = 0; i < lonBnd.size()-1; ++i) {
-        if (lon >= lonBnd(i) && lon < lonBnd(i+1)) {
-            isFound = true;
-            break;
-        }
-    }
-    if (!isFound)
-        i = 0;
-    // -------------------------------------------------------------------------
-    isFound = false;
-    for (j = 0; j < latBnd.size()-1; ++j) {
-        if (lat <= latBnd(j) && lat >= latBnd(j+1)) {
-            isFound = true;
-            break;
-        }
-    }
-    if (!isFound) {
+    if (!sampler.locate(lon, lat, i, j)) {
         cout << "[Error]: SCVT::getDensity: Could not locate point!" << endl;
         cout << "[Debug]: SCVT::getDensity: Point coordinate is ";
         cout << setw(10) << setprecision(5) << lon*Rad2Deg;
@@ -74,95 +133,153 @@ double SCVT::getDensity(double lon, double lat)
     return rho(i, j);
 }
 
-void SCVT::run(int numPoint, DelaunayDriver &driver, const string &ID)
+void SCVT::setQuadratureOrder(int order)
 {
-    // -------------------------------------------------------------------------
-    // 1. Initialize Voronoi generators using Monte Carlo method
-#if defined (DEBUG) || defined (VERBOSE)
-    cout << "[Notice]: SCVT::run: Initialize Voronoi generators." << endl;
+    if (order != 1 && order != 2 && order != 5) {
+        Message message;
+        message << "Unsupported quadrature order " << order << "!";
+        REPORT_ERROR(message.str());
+    }
+    quadratureOrder = order;
+}
+
+double SCVT::getWallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return static_cast<double>(clock())/CLOCKS_PER_SEC;
 #endif
-    double lon[numPoint], lat[numPoint];
-    double maxRho = max(rho);
-    double ratio;
-    RandomNumber::setRandomSeed();
+}
+
+/*
+ * Function:
+ *   integrate
+ * Purpose:
+ *   Accumulate the integrals of rho*x and rho over the spherical triangle
+ *   (x0,x1,x2), where rho0, rho1 and rho2 are the densities on the vertices.
+ *   The vertex rule is used for order 1, and the quadrature points of the
+ *   higher orders are projected onto the sphere.
+ */
+void SCVT::integrate(const Coordinate &x0, const Coordinate &x1,
+                     const Coordinate &x2, double rho0, double rho1,
+                     double rho2, Vector &car, double &W)
+{
+    double area = Sphere::calcArea(x0, x1, x2);
+    if (quadratureOrder == 1) {
+        car += area*(x0.getCAR()*rho0+x1.getCAR()*rho1+x2.getCAR()*rho2);
+        W += area*(rho0+rho1+rho2);
+        return;
+    }
+    int numQuadPoint;
+    const double (*quadPoint)[3];
+    const double *quadWeight;
+    if (quadratureOrder == 2) {
+        numQuadPoint = numQuadPoint2;
+        quadPoint = quadPoint2;
+        quadWeight = quadWeight2;
+    } else {
+        numQuadPoint = numQuadPoint5;
+        quadPoint = quadPoint5;
+        quadWeight = quadWeight5;
+    }
+    for (int q = 0; q < numQuadPoint; ++q) {
+        Vector x = x0.getCAR()*quadPoint[q][0]+x1.getCAR()*quadPoint[q][1]+
+                   x2.getCAR()*quadPoint[q][2];
+        x /= norm(x);
+        double lon, lat;
+        Sphere::convertCAR(x(0), x(1), x(2), lon, lat);
+        double rho = getDensity(lon, lat);
+        car += (area*quadWeight[q]*rho)*x;
+        W += area*quadWeight[q]*rho;
+    }
+}
+
+void SCVT::setSolver(const string &name)
+{
+    if (name == "lloyd") {
+        solver = LloydSolver;
+    } else if (name == "anderson") {
+        solver = AndersonSolver;
+    } else {
+        REPORT_ERROR("Unknown SCVT solver \""+name+"\"!");
+    }
+}
+
+void SCVT::setAndersonDepth(int depth)
+{
+    andersonDepth = depth;
+}
+
+void SCVT::setNumLevel(int numLevel_)
+{
+    numLevel = numLevel_ < 1 ? 1 : numLevel_;
+}
+
+/*
+ * Function:
+ *   calcCentroids
+ * Purpose:
+ *   Calculate the density-weighted centroids (unit vectors) of the Voronoi
+ *   cells of the generators in the order of driver.DVT.
+ * Return value:
+ *   The L2 norm of the distances between the generators and the centroids,
+ *   and Linf is returned by argument.
+ */
+double SCVT::calcCentroids(DelaunayDriver &driver, vector<Vector> &centroids,
+                           double &Linf)
+{
+    int numPoint = driver.DVT.size();
+    DVTs.resize(numPoint);
+    rhoDVT.resize(numPoint);
+    centroids.resize(numPoint);
+    DelaunayVertex *DVT = driver.DVT.front();
     for (int i = 0; i < numPoint; ++i) {
-        while (true) {
-        get_random_car:
-            double x = RandomNumber::getRandomNumber(-1.0, 1.0);
-            double y = RandomNumber::getRandomNumber(-1.0, 1.0);
-            double z = RandomNumber::getRandomNumber(-1.0, 1.0);
-            double r = x*x+y*y+z*z;
-            if (r <= 1.0) {
-                r = sqrt(r);
-                x /= r;
-                y /= r;
-                z /= r;
-            } else {
-                goto get_random_car;
-            }
-            ratio = RandomNumber::getRandomNumber(0.0, 1.0);
-            Sphere::convertCAR(x, y, z, lon[i], lat[i]);
-            if (ratio <= getDensity(lon[i], lat[i])/maxRho)
-                break;
-        }
+        DVTs[i] = DVT;
+        DVT = DVT->next;
+    }
+    int numDT = driver.DT.size();
+    DTs.resize(numDT);
+    rhoDT.resize(numDT);
+    DelaunayTriangle *DT = driver.DT.front();
+    for (int i = 0; i < numDT; ++i) {
+        DTs[i] = DT;
+        DT = DT->next;
     }
-#if defined (DEBUG) || defined (VERBOSE)
-    cout << "[Notice]: SCVT::run: DONE!" << endl;
-#endif
     // -------------------------------------------------------------------------
-    // 2. Run the Lloyd's algorithm
-#if defined (DEBUG) || defined (VERBOSE)
-    cout << "[Notice]: SCVT::run: Running the Lloyd's algorithm." << endl;
-#endif
-    PointManager pointManager;
-    pointManager.init(numPoint, lon, lat);
-    driver.init(pointManager);
-    bool isCriteriaMeet = false;
-    for (int k = 0; k < maxIteration && !isCriteriaMeet; ++k) {
-        double Linf = 0.0, L2 = 0.0;
-        // =====================================================================
-        // Run Delaunay triangulation and infer Voronoi diagram
-        driver.reinit();
-        driver.run();
-#if defined (DEBUG) || defined (VERBOSE)
-        if (k == 0) {
-            cout << "[Notice]: SCVT::run: Check initial generators in scvt_mc.nc" << endl;
-            driver.output("scvt_mc_"+ID+".nc");
-        }
-#endif
-        driver.calcCircumcenter();
-        // =====================================================================
-        // Calculate centroids of Voronoi cells (approximated)
-        DelaunayVertex *DVT;
-        // Evaluate the density on the generators (DVT)
-        assert(numPoint == driver.DVT.size());
-        double rho0[driver.DT.size()];
-        DelaunayTriangle *DT = driver.DT.front();
-        for (int i = 0; i < driver.DT.size(); ++i) {
-            rho0[i] = getDensity(DT->circumcenter.getCoordinate().getLon(),
-                                 DT->circumcenter.getCoordinate().getLat());
-            DT = DT->next;
-        }
-        DVT = driver.DVT.front();
-        for (int i = 0; i < driver.DVT.size(); ++i) {
+    // Evaluate the density on the circumcenters (Voronoi vertices) and on the
+    // generators
+#pragma omp parallel for
+    for (int i = 0; i < numDT; ++i) {
+        DTs[i]->calcCircumcenter();
+        const Coordinate &x = DTs[i]->circumcenter.getCoordinate();
+        rhoDT[i] = getDensity(x.getLon(), x.getLat());
+    }
+#pragma omp parallel for
+    for (int i = 0; i < numPoint; ++i) {
+        const Coordinate &x = DVTs[i]->point->getCoordinate();
+        rhoDVT[i] = getDensity(x.getLon(), x.getLat());
+    }
+    // -------------------------------------------------------------------------
+    // Integrate over the fan of triangles formed by the generator and the
+    // Voronoi vertices
+    double L2 = 0.0;
+    Linf = 0.0;
+#pragma omp parallel
+    {
+        double myLinf = 0.0;
+#pragma omp for reduction(+:L2) schedule(dynamic, 256)
+        for (int i = 0; i < numPoint; ++i) {
             Vector car = 0.0;
             double W = 0.0;
-            const Coordinate &x0 = DVT->point->getCoordinate();
-            DelaunayTrianglePointer *incidentDT = DVT->topology.incidentDT.front();
-            for (int j = 0; j < DVT->topology.incidentDT.size(); ++j) {
+            const Coordinate &x0 = DVTs[i]->point->getCoordinate();
+            DelaunayTrianglePointer *incidentDT = DVTs[i]->topology.incidentDT.front();
+            for (int j = 0; j < DVTs[i]->topology.incidentDT.size(); ++j) {
                 int i1 = incidentDT->ptr->getID()-1;
                 int i2 = incidentDT->next->ptr->getID()-1;
                 const Coordinate &x1 = incidentDT->ptr->circumcenter.getCoordinate();
                 const Coordinate &x2 = incidentDT->next->ptr->circumcenter.getCoordinate();
-                double w0, w1, w2;
-                w0 = x0.getX()*rho0[i]+x1.getX()*rho0[i1]+x2.getX()*rho0[i2];
-                w1 = x0.getY()*rho0[i]+x1.getY()*rho0[i1]+x2.getY()*rho0[i2];
-                w2 = x0.getZ()*rho0[i]+x1.getZ()*rho0[i1]+x2.getZ()*rho0[i2];
-                double area = Sphere::calcArea(x0, x1, x2);
-                car(0) += area*w0;
-                car(1) += area*w1;
-                car(2) += area*w2;
-                W += area*(rho0[i]+rho0[i1]+rho0[i2]);
+                integrate(x0, x1, x2, rhoDVT[i], rhoDT[i1], rhoDT[i2], car, W);
                 incidentDT = incidentDT->next;
             }
             car /= W;
@@ -171,28 +288,291 @@ void SCVT::run(int numPoint, DelaunayDriver &driver, const string &ID)
             c0.setCAR(car(0), car(1), car(2));
             double distance = Sphere::calcDistance(x0, c0)/Sphere::radius;
             L2 += distance*distance;
-            if (distance > Linf) Linf = distance;
-            lon[i] = c0.getLon();
-            lat[i] = c0.getLat();
-            DVT = DVT->next;
+            if (distance > myLinf) myLinf = distance;
+            centroids[i] = car;
+        }
+#pragma omp critical
+        if (myLinf > Linf) Linf = myLinf;
+    }
+    return sqrt(L2/(1.0*numPoint));
+}
+
+double SCVT::dot(const vector<Vector> &a, const vector<Vector> &b)
+{
+    int n = static_cast<int>(a.size());
+    double res = 0.0;
+#pragma omp parallel for reduction(+:res)
+    for (int i = 0; i < n; ++i)
+        res += a[i](0)*b[i](0)+a[i](1)*b[i](1)+a[i](2)*b[i](2);
+    return res;
+}
+
+/*
+ * Function:
+ *   accelerate
+ * Purpose:
+ *   Extrapolate the next generators from the latest Lloyd steps (Anderson
+ *   mixing), where x and g are the generators and their centroids. The
+ *   history is restarted when the residual grows.
+ * Return value:
+ *   The new generators are returned by x.
+ */
+void SCVT::accelerate(vector<Vector> &x, const vector<Vector> &g, double L2)
+{
+    int n = static_cast<int>(x.size());
+    vector<Vector> f(n);
+    for (int i = 0; i < n; ++i)
+        f[i] = g[i]-x[i];
+    if (lastL2 >= 0.0 && L2 < lastL2) {
+        if (static_cast<int>(dF.size()) == andersonDepth) {
+            dF.erase(dF.begin());
+            dG.erase(dG.begin());
+        }
+        dF.push_back(vector<Vector>(n));
+        dG.push_back(vector<Vector>(n));
+        for (int i = 0; i < n; ++i) {
+            dF.back()[i] = f[i]-lastF[i];
+            dG.back()[i] = g[i]-lastG[i];
         }
-        L2 = sqrt(L2/(1.0*numPoint));
+    } else {
+        dF.clear();
+        dG.clear();
+    }
+    lastF = f;
+    lastG = g;
+    lastL2 = L2;
+    // -------------------------------------------------------------------------
+    // solve the least squares problem min |f-dF*gamma| by normal equations
+    int m = static_cast<int>(dF.size());
+    if (m == 0) {
+        x = g;
+        return;
+    }
+    vector<double> A(m*m), b(m), gamma(m);
+    double trace = 0.0;
+    for (int j1 = 0; j1 < m; ++j1) {
+        for (int j2 = j1; j2 < m; ++j2)
+            A[j1*m+j2] = A[j2*m+j1] = dot(dF[j1], dF[j2]);
+        b[j1] = dot(dF[j1], f);
+        trace += A[j1*m+j1];
+    }
+    for (int j = 0; j < m; ++j)
+        A[j*m+j] += 1.0e-10*trace/m;
+    // Gaussian elimination with partial pivoting
+    for (int j = 0; j < m; ++j) {
+        int p = j;
+        for (int r = j+1; r < m; ++r)
+            if (fabs(A[r*m+j]) > fabs(A[p*m+j])) p = r;
+        if (p != j) {
+            for (int c = 0; c < m; ++c)
+                std::swap(A[j*m+c], A[p*m+c]);
+            std::swap(b[j], b[p]);
+        }
+        for (int r = j+1; r < m; ++r) {
+            double factor = A[r*m+j]/A[j*m+j];
+            for (int c = j; c < m; ++c)
+                A[r*m+c] -= factor*A[j*m+c];
+            b[r] -= factor*b[j];
+        }
+    }
+    for (int j = m-1; j >= 0; --j) {
+        gamma[j] = b[j];
+        for (int c = j+1; c < m; ++c)
+            gamma[j] -= A[j*m+c]*gamma[c];
+        gamma[j] /= A[j*m+j];
+    }
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i) {
+        Vector y = g[i];
+        for (int j = 0; j < m; ++j)
+            y -= gamma[j]*dG[j][i];
+        x[i] = y/norm(y);
+    }
+}
+
+/*
+ * Function:
+ *   iterate
+ * Purpose:
+ *   Run the selected solver on the triangulated generators until the L2
+ *   norm of the generator movements is less than eps.
+ * Return value:
+ *   The number of iterations, and L2 is returned by argument.
+ */
+int SCVT::iterate(DelaunayDriver &driver, double &L2)
+{
+    int numPoint = driver.DVT.size();
+    vector<Vector> x(numPoint), g;
+    vector<double> lon(numPoint), lat(numPoint);
+    lastL2 = -1.0;
+    dF.clear();
+    dG.clear();
+    bool isCriteriaMeet = false;
+    int k;
+    for (k = 0; k < maxIteration && !isCriteriaMeet; ++k) {
+#if defined (DEBUG) || defined (VERBOSE)
+        double start = getWallTime();
+#endif
+        double Linf;
+        L2 = calcCentroids(driver, g, Linf);
         if (L2 < eps) {
             isCriteriaMeet = true;
         } else {
-            DVT = driver.DVT.front();
-            for (int i = 0; i < driver.DVT.size(); ++i) {
-                DVT->point->setCoordinate(lon[i], lat[i]);
-                DVT = DVT->next;
+            if (solver == AndersonSolver && andersonDepth > 0) {
+                DelaunayVertex *DVT = driver.DVT.front();
+                for (int i = 0; i < numPoint; ++i) {
+                    x[i] = DVT->point->getCoordinate().getCAR();
+                    DVT = DVT->next;
+                }
+                accelerate(x, g, L2);
+            } else
+                x = g;
+            for (int i = 0; i < numPoint; ++i)
+                Sphere::convertCAR(x[i](0), x[i](1), x[i](2), lon[i], lat[i]);
+            driver.moveVertices(&lon[0], &lat[0]);
+        }
+#if defined (DEBUG) || defined (VERBOSE)
+        *logStream << "[Notice]: SCVT::run: Iteration " << k << ": ";
+        *logStream << "L2 = " << L2 << " Linf = " << Linf << " (";
+        *logStream << setprecision(5) << getWallTime()-start << " seconds)" << endl;
+#endif
+    }
+    // Note: The generators may have been moved in the last iteration.
+    if (!isCriteriaMeet)
+        driver.calcCircumcenter();
+    dF.clear();
+    dG.clear();
+    lastF.clear();
+    lastG.clear();
+    return k;
+}
+
+/*
+ * Function:
+ *   refine
+ * Purpose:
+ *   Split the generators for the next level by adding the midpoints of the
+ *   Delaunay edges that carry the most mass (rho*length^2).
+ */
+void SCVT::refine(DelaunayDriver &driver, int numPoint, vector<double> &lon,
+                  vector<double> &lat)
+{
+    int numOldPoint = driver.DVT.size();
+    vector<std::pair<double, int> > keys;
+    vector<Vector> midpoints;
+    keys.reserve(numOldPoint*3);
+    midpoints.reserve(numOldPoint*3);
+    lon.resize(numPoint);
+    lat.resize(numPoint);
+    DelaunayVertex *DVT = driver.DVT.front();
+    for (int i = 0; i < numOldPoint; ++i) {
+        lon[i] = DVT->point->getCoordinate().getLon();
+        lat[i] = DVT->point->getCoordinate().getLat();
+        DelaunayVertexPointer *linkDVT = DVT->topology.linkDVT.front();
+        for (int j = 0; j < DVT->topology.linkDVT.size(); ++j) {
+            // Note: Each edge is counted by the vertex with smaller ID.
+            if (DVT->getID() < linkDVT->ptr->getID()) {
+                const Vector &x1 = DVT->point->getCoordinate().getCAR();
+                const Vector &x2 = linkDVT->ptr->point->getCoordinate().getCAR();
+                Vector x = x1+x2;
+                x /= norm(x);
+                double lon0, lat0;
+                Sphere::convertCAR(x(0), x(1), x(2), lon0, lat0);
+                double length = norm(x1-x2);
+                double mass = getDensity(lon0, lat0)*length*length;
+                keys.push_back(std::make_pair(-mass,
+                    static_cast<int>(midpoints.size())));
+                midpoints.push_back(x);
             }
+            linkDVT = linkDVT->next;
         }
+        DVT = DVT->next;
+    }
+    int numNewPoint = numPoint-numOldPoint;
+    if (numNewPoint > static_cast<int>(keys.size()))
+        REPORT_ERROR("Not enough Delaunay edges to split generators!");
+    std::partial_sort(keys.begin(), keys.begin()+numNewPoint, keys.end());
+    for (int i = 0; i < numNewPoint; ++i) {
+        const Vector &x = midpoints[keys[i].second];
+        Sphere::convertCAR(x(0), x(1), x(2), lon[numOldPoint+i],
+                           lat[numOldPoint+i]);
+    }
+}
+
+void SCVT::triangulate(DelaunayDriver &driver, vector<double> &lon,
+                       vector<double> &lat)
+{
+    // Note: The points are kept until the next triangulation, since the
+    //       driver refers to them after SCVT::run.
+    if (pointManager != NULL)
+        delete pointManager;
+    pointManager = new PointManager;
+    pointManager->init(static_cast<int>(lon.size()), &lon[0], &lat[0]);
+    driver.init(*pointManager);
+    driver.reinit();
+    driver.run();
+}
+
+void SCVT::run(int numPoint, DelaunayDriver &driver, const string &ID,
+               std::ostream *log)
+{
+    logStream = log != NULL ? log : &cout;
+    // -------------------------------------------------------------------------
+    // 0. Set the numbers of generators on the levels, each of which is about
+    //    a quarter of the next one
+    static const int minNumPoint = 32;
+    vector<int> numPoints(1, numPoint);
+    while (static_cast<int>(numPoints.size()) < numLevel) {
+        int numCoarsePoint = (numPoints.front()+9)/4;
+        if (numCoarsePoint < minNumPoint)
+            break;
+        numPoints.insert(numPoints.begin(), numCoarsePoint);
+    }
+    // -------------------------------------------------------------------------
+    // 1. Initialize Voronoi generators by sampling the density function
 #if defined (DEBUG) || defined (VERBOSE)
-        cout << "[Notice]: SCVT::run: Iteration " << k << ": ";
-        cout << "L2 = " << L2 << " Linf = " << Linf << endl;
+    *logStream << "[Notice]: SCVT::run: Initialize Voronoi generators." << endl;
 #endif
+    sampler.init(lonBnd, latBnd, rho);
+    vector<double> lon(numPoints.front()), lat(numPoints.front());
+    RandomNumber::setRandomSeed();
+    for (int i = 0; i < numPoints.front(); ++i)
+        sampler.sample(lon[i], lat[i]);
+#if defined (DEBUG) || defined (VERBOSE)
+    *logStream << "[Notice]: SCVT::run: DONE!" << endl;
+#endif
+    // -------------------------------------------------------------------------
+    // 2. Run the solver on each level, and split the generators for the next
+    //    level
+#if defined (DEBUG) || defined (VERBOSE)
+    *logStream << "[Notice]: SCVT::run: Running the Lloyd's algorithm." << endl;
+#endif
+    double totalStart = getWallTime();
+    for (int l = 0; l < static_cast<int>(numPoints.size()); ++l) {
+        double start = getWallTime();
+        if (l > 0)
+            refine(driver, numPoints[l], lon, lat);
+        triangulate(driver, lon, lat);
+#if defined (DEBUG) || defined (VERBOSE)
+        // Note: netCDF is not thread-safe, so the background job does not
+        //       output.
+        if (l == 0 && log == NULL) {
+            cout << "[Notice]: SCVT::run: Check initial generators in scvt_mc.nc" << endl;
+            driver.output("scvt_mc_"+ID+".nc");
+        }
+#endif
+        double L2;
+        int numIteration = iterate(driver, L2);
+        *logStream << "[Timing]: SCVT::run: " << numPoints[l] << " generators, ";
+        *logStream << numIteration << " iterations, L2 = " << L2 << ": ";
+        *logStream << setprecision(5) << getWallTime()-start << " seconds." << endl;
     }
+    *logStream << "[Timing]: SCVT::run: " << (solver == AndersonSolver ? "Anderson" : "Lloyd");
+    *logStream << " solver on " << numPoints.size() << " levels with quadrature order ";
+    *logStream << quadratureOrder << ": " << setprecision(5);
+    *logStream << getWallTime()-totalStart << " seconds." << endl;
 #if defined (DEBUG) || defined (VERBOSE)
-    cout << "[Notice]: SCVT::run: DONE!" << endl;
+    *logStream << "[Notice]: SCVT::run: DONE!" << endl;
 #endif
 }
 
@@ -217,26 +597,29 @@ void SCVT::outputDensityFunction(const string &ID)
     lonVar->add_att("units", "degree_east");
     latVar->add_att("long_name", "latitude");
     latVar->add_att("units", "degree_north");
-    double lon[rho.extent(0)], lat[rho.extent(1)];
-    double lonBnd_[2][rho.extent(0)], latBnd_[2][rho.extent(1)];
-    for (int i = 0; i < rho.extent(0); ++i) {
+    int numLon = rho.extent(0), numLat = rho.extent(1);
+    // Note: The bounds and the density are stored with the bound index and
+    //       the latitude first respectively.
+    vector<double> lon(numLon), lat(numLat);
+    vector<double> lonBnd_(2*numLon), latBnd_(2*numLat);
+    for (int i = 0; i < numLon; ++i) {
         lon[i] = (lonBnd(i)+lonBnd(i+1))*0.5*Rad2Deg;
-        lonBnd_[0][i] = lonBnd(i)*Rad2Deg;
-        lonBnd_[1][i] = lonBnd(i+1)*Rad2Deg;
+        lonBnd_[i] = lonBnd(i)*Rad2Deg;
+        lonBnd_[numLon+i] = lonBnd(i+1)*Rad2Deg;
     }
-    for (int j = 0; j < rho.extent(1); ++j) {
+    for (int j = 0; j < numLat; ++j) {
         lat[j] = (latBnd(j)+latBnd(j+1))*0.5*Rad2Deg;
-        latBnd_[0][j] = latBnd(j)*Rad2Deg;
-        latBnd_[1][j] = latBnd(j+1)*Rad2Deg;
-    }
-    double tmp[rho.extent(1)][rho.extent(0)];
-    for (int i = 0; i < rho.extent(0); ++i)
-        for (int j = 0; j < rho.extent(1); ++j)
-            tmp[j][i] = rho(i, j);
-    lonVar->put(lon, rho.extent(0));
-    latVar->put(lat, rho.extent(1));
-    lonBndVar->put(&lonBnd_[0][0], 2, rho.extent(0));
-    latBndVar->put(&latBnd_[0][0], 2, rho.extent(1));
-    rhoVar->put(&tmp[0][0], rho.extent(1), rho.extent(0));
+        latBnd_[j] = latBnd(j)*Rad2Deg;
+        latBnd_[numLat+j] = latBnd(j+1)*Rad2Deg;
+    }
+    vector<double> tmp(numLat*numLon);
+    for (int i = 0; i < numLon; ++i)
+        for (int j = 0; j < numLat; ++j)
+            tmp[j*numLon+i] = rho(i, j);
+    lonVar->put(&lon[0], numLon);
+    latVar->put(&lat[0], numLat);
+    lonBndVar->put(&lonBnd_[0], 2, numLon);
+    latBndVar->put(&latBnd_[0], 2, numLat);
+    rhoVar->put(&tmp[0], numLat, numLon);
     file.close();
 }
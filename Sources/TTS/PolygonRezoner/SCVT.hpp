@@ -2,6 +2,8 @@
 #define SCVT_h
 
 #include <blitz/array.h>
+#include <string>
+#include <ostream>
 
 using blitz::Array;
 
@@ -12,11 +14,32 @@ namespace SCVT
     void init(int numLon, int numLat, const double *lon, const double *lat,
               int maxIteration = 10);
 
+    // Set the order of the quadrature rule on the triangles that form the
+    // Voronoi cells when calculating the centroids (1, 2 or 5). The default
+    // order 1 is the vertex rule.
+    void setQuadratureOrder(int order);
+
+    // Set the solver of the generators, which is "lloyd" (default) or
+    // "anderson" (Anderson-accelerated Lloyd iterations with the given depth
+    // of history).
+    void setSolver(const std::string &name);
+    void setAndersonDepth(int depth);
+
+    // Set the number of levels for the multilevel scheme, where the
+    // generators are converged on the coarse level and split for the next
+    // one (about four times more generators). The default is one level.
+    void setNumLevel(int numLevel);
+
     Array<double, 2> &getDensityFunction();
     void outputDensityFunction(const std::string &ID);
 
     void run(int numPoint, double *lon, double *lat);
-    void run(int numPoint, DelaunayDriver &driver, const std::string &ID);
+    // When log is given (e.g. the background job of PolygonRezoner), the
+    // notices and timings are written into it instead of cout, which the main
+    // thread is writing, and no netCDF file is written, since netCDF is not
+    // thread-safe.
+    void run(int numPoint, DelaunayDriver &driver, const std::string &ID,
+             std::ostream *log = NULL);
 }
 
 #endif
@@ -4,6 +4,10 @@
 #include "Vertex.hpp"
 #include "Edge.hpp"
 #include "MeshManager.hpp"
+#include "SweptEdgeDetector.hpp"
+#include <list>
+#include <vector>
+#include <algorithm>
 
 using namespace PotentialCrossDetector;
 using namespace ApproachDetector;
@@ -13,8 +17,8 @@ Status PotentialCrossDetector::detectReplaceVertex(EdgePointer *edgePointer,
                                                    Vertex *oldVertex,
                                                    Vertex *newVertex)
 {
-    static std::list<Vertex *>::const_iterator itVtx;
-    static std::list<Projection>::const_iterator itPrj;
+    static EdgeAgent::VertexList::const_iterator itVtx;
+    static VertexAgent::ProjectionMap::const_iterator itPrj;
     Vertex *vertex1, *vertex2, *vertex3, *vertex4;
     Projection *projection;
     OrientStatus orient;
@@ -148,12 +152,13 @@ Status PotentialCrossDetector::detectInsertVertexOnEdge
     // -------------------------------------------------------------------------
     Vertex *vertex1, *vertex2, *vertex3, *vertex4, *vertices[3];
     OrientStatus orient;
-    static std::list<Projection>::iterator itPrj;
-    static std::list<Vertex *>::iterator itVtx;
+    static VertexAgent::ProjectionMap::iterator itPrj;
+    static EdgeAgent::VertexList::iterator itVtx;
     Projection *projection;
     EdgePointer *linkedEdge;
     Edge *edge3;
     static std::list<Edge *> checkedEdges;
+    static std::vector<Edge *> nearEdges, queryEdges;
     checkedEdges.clear();
     // -------------------------------------------------------------------------
     // collect information
@@ -219,33 +224,45 @@ Status PotentialCrossDetector::detectInsertVertexOnEdge
         itVtx++;
     }
     // =========================================================================
-    // paired edges of end points of old edge
-    for (int i = 0; i < 3; ++i) {
-        itPrj = vertices[i]->detectAgent.getProjections().begin();
-        while (itPrj != vertices[i]->detectAgent.getProjections().end()) {
-            edge3 = (*itPrj).getEdge();
+    // edges around the two new edges
+    // Note: The swept edge detector gives all the edges that may be crossed
+    //       by the new edges. If it is not built, fall back to the paired
+    //       edges of the end points of the old edge.
+    nearEdges.clear();
+    if (SweptEdgeDetector::isBuilt()) {
+        for (int i = 0; i < 2; ++i) {
+            SweptEdgeDetector::queryEdges(vertices[i]->getCoordinate(),
+                                          newVertex->getCoordinate(),
+                                          queryEdges);
+            nearEdges.insert(nearEdges.end(),
+                             queryEdges.begin(), queryEdges.end());
+        }
+    } else {
+        for (int i = 0; i < 3; ++i) {
+            for (itPrj = vertices[i]->detectAgent.getProjections().begin();
+                 itPrj != vertices[i]->detectAgent.getProjections().end();
+                 ++itPrj)
+                nearEdges.push_back((*itPrj).getEdge());
+        }
+    }
+    for (int i = 0; i < static_cast<int>(nearEdges.size()); ++i) {
+        edge3 = nearEdges[i];
 #ifdef DEBUG
-            assert(edge3->endTag != ListElement<Edge>::Null);
+        assert(edge3->endTag != ListElement<Edge>::Null);
 #endif
-            if (find(checkedEdges.begin(), checkedEdges.end(), edge3)
-                != checkedEdges.end()) {
-                itPrj++;
-                continue;
-            }
-            vertex3 = edge3->getEndPoint(FirstPoint);
-            vertex4 = edge3->getEndPoint(SecondPoint);
-            if (vertex3 == oldVertex || vertex4 == oldVertex) {
-                itPrj++;
-                continue;
-            }
-            if ((vertex1 != vertex3 && vertex1 != vertex4 &&
-                 Sphere::isIntersect(vertex1, newVertex, vertex3, vertex4)) ||
-                (vertex2 != vertex3 && vertex2 != vertex4 &&
-                 Sphere::isIntersect(vertex2, newVertex, vertex3, vertex4)))
-                goto return_insert_vertex_cross_edge;
-            checkedEdges.push_back(edge3);
-            itPrj++;
-        }
+        if (find(checkedEdges.begin(), checkedEdges.end(), edge3)
+            != checkedEdges.end())
+            continue;
+        vertex3 = edge3->getEndPoint(FirstPoint);
+        vertex4 = edge3->getEndPoint(SecondPoint);
+        if (vertex3 == oldVertex || vertex4 == oldVertex)
+            continue;
+        if ((vertex1 != vertex3 && vertex1 != vertex4 &&
+             Sphere::isIntersect(vertex1, newVertex, vertex3, vertex4)) ||
+            (vertex2 != vertex3 && vertex2 != vertex4 &&
+             Sphere::isIntersect(vertex2, newVertex, vertex3, vertex4)))
+            goto return_insert_vertex_cross_edge;
+        checkedEdges.push_back(edge3);
     }
     // -------------------------------------------------------------------------
     // branch-2:
@@ -269,8 +286,12 @@ Status PotentialCrossDetector::detectInsertVertexOnEdge
               Sphere::isIntersect(vertex2, newVertex, vertex3, testPoint)) ||
              (vertex2 != vertex4 &&
               Sphere::isIntersect(vertex2, newVertex, vertex4, testPoint)))) {
-            itVtx++;
+            // Note: The test point may be unpaired with the old edge during
+            //       resetting, in which case the iterator is already on the
+            //       next vertex.
             testPoint->reset(meshManager);
+            if (testPoint->detectAgent.getProjection(oldEdge) != NULL)
+                itVtx++;
         } else
             itVtx++;
     }
@@ -292,9 +313,10 @@ Status PotentialCrossDetector::detectRemoveVertexOnEdges(MeshManager &meshManage
     EdgePointer *linkedEdge;
     Polygon *markPolygon;
     static std::list<Edge *> checkedEdges;
+    static std::vector<Edge *> nearEdges, queryEdges;
     checkedEdges.clear();
-    static std::list<Vertex *>::const_iterator itVtx;
-    static std::list<Projection>::const_iterator itPrj;
+    static EdgeAgent::VertexList::const_iterator itVtx;
+    static VertexAgent::ProjectionMap::const_iterator itPrj;
     OrientStatus orient;
     Projection *projection;
     int mode;
@@ -372,96 +394,70 @@ Status PotentialCrossDetector::detectRemoveVertexOnEdges(MeshManager &meshManage
             markPolygon = polygon;
     }
     // =========================================================================
-    // edge 1
-    for (itVtx = edge1->detectAgent.vertices.begin();
-         itVtx != edge1->detectAgent.vertices.end(); ++itVtx) {
-        vertex4 = *itVtx;
-        projection = vertex4->detectAgent.getProjection(edge1);
-        if (((mode == 1 || mode == 3) && projection->getOrient() != orient) ||
-            ((mode == 2 || mode == 4) && projection->getOrient() == orient))
-            continue;
-        if (vertex4->getID() == -1)
-            continue;
-        linkedEdge = vertex4->linkedEdges.front();
-        while (linkedEdge != NULL) {
-            edge = linkedEdge->edge;
-            if (find(checkedEdges.begin(), checkedEdges.end(), edge)
-                == checkedEdges.end()) {
-                vertex5 = NULL; vertex6 = NULL;
-                if (edge->getPolygon(OrientLeft) == markPolygon ||
-                    edge->getPolygon(OrientRight) == markPolygon) {
-                    vertex5 = edge->getEndPoint(FirstPoint);
-                    vertex6 = edge->getEndPoint(SecondPoint);
-                }
-                if (vertex5 != NULL) {
-                    if (((vertex5 != vertex1 && vertex6 != vertex1) &&
-                         Sphere::isIntersect(vertex1, testPoint, vertex5, vertex6)) ||
-                        ((vertex5 != vertex3 && vertex6 != vertex3) &&
-                         Sphere::isIntersect(vertex3, testPoint, vertex5, vertex6)))
-                        goto return_nocross_but_reset_testpoint;
-                }
-                checkedEdges.push_back(edge);
-            }
-            linkedEdge = linkedEdge->next;
+    // Note: The swept edge detector gives all the edges that may be crossed by
+    //       the new edges. If it is not built, fall back to the linked edges of
+    //       the paired vertices of edge 1/2 and the paired edges of the end
+    //       points.
+    nearEdges.clear();
+    if (SweptEdgeDetector::isBuilt()) {
+        SweptEdgeDetector::queryEdges(vertex1->getCoordinate(),
+                                      testPoint->getCoordinate(), queryEdges);
+        nearEdges.insert(nearEdges.end(), queryEdges.begin(), queryEdges.end());
+        SweptEdgeDetector::queryEdges(vertex3->getCoordinate(),
+                                      testPoint->getCoordinate(), queryEdges);
+        nearEdges.insert(nearEdges.end(), queryEdges.begin(), queryEdges.end());
+    } else {
+        // edge 1
+        for (itVtx = edge1->detectAgent.vertices.begin();
+             itVtx != edge1->detectAgent.vertices.end(); ++itVtx) {
+            vertex4 = *itVtx;
+            projection = vertex4->detectAgent.getProjection(edge1);
+            if (((mode == 1 || mode == 3) && projection->getOrient() != orient) ||
+                ((mode == 2 || mode == 4) && projection->getOrient() == orient))
+                continue;
+            if (vertex4->getID() == -1)
+                continue;
+            for (linkedEdge = vertex4->linkedEdges.front(); linkedEdge != NULL;
+                 linkedEdge = linkedEdge->next)
+                nearEdges.push_back(linkedEdge->edge);
         }
-    }
-    // =========================================================================
-    // edge 2
-    for (itVtx = edge2->detectAgent.vertices.begin();
-         itVtx != edge2->detectAgent.vertices.end(); ++itVtx) {
-        vertex4 = *itVtx;
-        projection = vertex4->detectAgent.getProjection(edge2);
-        if (((mode == 1 || mode == 2) && projection->getOrient() != orient) ||
-            ((mode == 3 || mode == 4) && projection->getOrient() == orient))
-            continue;
-        if (vertex4->getID() == -1)
-            continue;
-        linkedEdge = vertex4->linkedEdges.front();
-        while (linkedEdge != NULL) {
-            edge = linkedEdge->edge;
-            if (find(checkedEdges.begin(), checkedEdges.end(), edge)
-                == checkedEdges.end()) {
-                vertex5 = NULL; vertex6 = NULL;
-                if (edge->getPolygon(OrientLeft) == markPolygon ||
-                    edge->getPolygon(OrientRight) == markPolygon) {
-                    vertex5 = edge->getEndPoint(FirstPoint);
-                    vertex6 = edge->getEndPoint(SecondPoint);
-                }
-                if (vertex5 != NULL) {
-                    if (((vertex5 != vertex1 && vertex6 != vertex1) &&
-                         Sphere::isIntersect(vertex1, testPoint, vertex5, vertex6)) ||
-                        ((vertex5 != vertex3 && vertex6 != vertex3) &&
-                         Sphere::isIntersect(vertex3, testPoint, vertex5, vertex6)))
-                        goto return_nocross_but_reset_testpoint;
-                }
-                checkedEdges.push_back(edge);
-            }
-            linkedEdge = linkedEdge->next;
+        // edge 2
+        for (itVtx = edge2->detectAgent.vertices.begin();
+             itVtx != edge2->detectAgent.vertices.end(); ++itVtx) {
+            vertex4 = *itVtx;
+            projection = vertex4->detectAgent.getProjection(edge2);
+            if (((mode == 1 || mode == 2) && projection->getOrient() != orient) ||
+                ((mode == 3 || mode == 4) && projection->getOrient() == orient))
+                continue;
+            if (vertex4->getID() == -1)
+                continue;
+            for (linkedEdge = vertex4->linkedEdges.front(); linkedEdge != NULL;
+                 linkedEdge = linkedEdge->next)
+                nearEdges.push_back(linkedEdge->edge);
+        }
+        // end points
+        for (int i = 0; i < 3; ++i) {
+            for (itPrj = vertices[i]->detectAgent.getProjections().begin();
+                 itPrj != vertices[i]->detectAgent.getProjections().end(); ++itPrj)
+                nearEdges.push_back((*itPrj).getEdge());
         }
     }
-    // =========================================================================
-    for (int i = 0; i < 3; ++i) {
-        for (itPrj = vertices[i]->detectAgent.getProjections().begin();
-             itPrj != vertices[i]->detectAgent.getProjections().end(); ++itPrj) {
-            edge = (*itPrj).getEdge();
-            if (find(checkedEdges.begin(), checkedEdges.end(), edge)
-                == checkedEdges.end()) {
-                vertex5 = NULL; vertex6 = NULL;
-                if (edge->getPolygon(OrientLeft) == markPolygon ||
-                    edge->getPolygon(OrientRight) == markPolygon) {
-                    vertex5 = edge->getEndPoint(FirstPoint);
-                    vertex6 = edge->getEndPoint(SecondPoint);
-                }
-                if (vertex5 != NULL) {
-                    if (((vertex5 != vertex1 && vertex6 != vertex1) &&
-                         Sphere::isIntersect(vertex1, testPoint, vertex5, vertex6)) ||
-                        ((vertex5 != vertex3 && vertex6 != vertex3) &&
-                         Sphere::isIntersect(vertex3, testPoint, vertex5, vertex6)))
-                        goto return_nocross_but_reset_testpoint;
-                }
-                checkedEdges.push_back(edge);
-            }
+    for (int i = 0; i < static_cast<int>(nearEdges.size()); ++i) {
+        edge = nearEdges[i];
+        if (find(checkedEdges.begin(), checkedEdges.end(), edge)
+            != checkedEdges.end())
+            continue;
+        if (edge->getPolygon(OrientLeft) == markPolygon ||
+            edge->getPolygon(OrientRight) == markPolygon) {
+            vertex5 = edge->getEndPoint(FirstPoint);
+            vertex6 = edge->getEndPoint(SecondPoint);
+            if (((vertex5 != vertex1 && vertex6 != vertex1) &&
+                 Sphere::isIntersect(vertex1, testPoint, vertex5, vertex6)) ||
+                ((vertex5 != vertex3 && vertex6 != vertex3) &&
+                 Sphere::isIntersect(vertex3, testPoint, vertex5, vertex6)))
+                goto return_nocross_but_reset_testpoint;
         }
+        checkedEdges.push_back(edge);
     }
     // -------------------------------------------------------------------------
     return NoCross;
@@ -535,7 +531,7 @@ void PotentialCrossDetector::adjustMergeEdgeAngleThreshold(Edge *edge1,
 {
     static const double smallDistance = 0.1/Rad2Deg*Sphere::radius;
     Vertex *vertex;
-    std::list<Vertex *>::const_iterator itVtx;
+    EdgeAgent::VertexList::const_iterator itVtx;
     for (itVtx = edge1->detectAgent.vertices.begin();
          itVtx != edge1->detectAgent.vertices.end(); ++itVtx) {
         vertex = *itVtx;
@@ -562,7 +558,7 @@ void PotentialCrossDetector::adjustMergeEdgeAngleThreshold(Edge *edge1,
     else if (edge1->getEndPoint(FirstPoint) == edge2->getEndPoint(FirstPoint) ||
              edge1->getEndPoint(FirstPoint) == edge2->getEndPoint(SecondPoint))
         vertex = edge1->getEndPoint(FirstPoint);
-    std::list<Projection>::const_iterator itPrj;
+    VertexAgent::ProjectionMap::const_iterator itPrj;
     for (itPrj = vertex->detectAgent.getProjections().begin();
          itPrj != vertex->detectAgent.getProjections().end(); ++itPrj) {
         if ((*itPrj).getDistance(NewTimeLevel) < smallDistance ||
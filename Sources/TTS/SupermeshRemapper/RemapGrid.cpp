@@ -0,0 +1,258 @@
+#include "RemapGrid.hpp"
+#include "RLLMesh.hpp"
+#include "Sphere.hpp"
+#include "ReportMacros.hpp"
+#include <netcdfcpp.h>
+#include <algorithm>
+
+static const double capEps = 1.0e-12;
+
+inline double calcAngle(const Vector &x1, const Vector &x2)
+{
+    return atan2(norm(cross(x1, x2)), dot(x1, x2));
+}
+
+inline Vector convertSPH(double lon, double lat)
+{
+    Vector x;
+    Sphere::convertSPH(lon, lat, x(0), x(1), x(2));
+    return x;
+}
+
+RemapGrid::RemapGrid()
+{
+    clear();
+}
+
+RemapGrid::~RemapGrid()
+{
+}
+
+void RemapGrid::init(const RLLMesh &meshBnd)
+{
+    clear();
+    int numLon = meshBnd.getNumLon()-2;
+    int numLat = meshBnd.getNumLat()-1;
+    Vector x[4];
+    for (int j = 0; j < numLat; ++j)
+        for (int i = 0; i < numLon; ++i) {
+            x[0] = convertSPH(meshBnd.lon(i),   meshBnd.lat(j));
+            x[1] = convertSPH(meshBnd.lon(i),   meshBnd.lat(j+1));
+            x[2] = convertSPH(meshBnd.lon(i+1), meshBnd.lat(j+1));
+            x[3] = convertSPH(meshBnd.lon(i+1), meshBnd.lat(j));
+            addCell(x, 4);
+        }
+    dims.push_back(numLon);
+    dims.push_back(numLat);
+}
+
+void RemapGrid::init(int numCell, int numCorner, const double *cornerLon,
+                     const double *cornerLat)
+{
+    clear();
+    vector<Vector> x(numCorner);
+    for (int c = 0; c < numCell; ++c) {
+        for (int k = 0; k < numCorner; ++k)
+            x[k] = convertSPH(cornerLon[c*numCorner+k],
+                              cornerLat[c*numCorner+k]);
+        addCell(&x[0], numCorner);
+    }
+    dims.push_back(numCell);
+}
+
+void RemapGrid::init(const string &fileName)
+{
+    NOTICE("RemapGrid::init", "Reading grid from \""+fileName+"\" ...");
+    NcError ncError(NcError::silent_nonfatal);
+    NcFile file(fileName.c_str(), NcFile::ReadOnly);
+    if (!file.is_valid()) {
+        Message message;
+        message << "Failed to open grid file \"" << fileName << "\"!";
+        REPORT_ERROR(message.str());
+    }
+    NcDim *sizeDim = file.get_dim("grid_size");
+    NcDim *cornerDim = file.get_dim("grid_corners");
+    NcVar *lonVar = file.get_var("grid_corner_lon");
+    NcVar *latVar = file.get_var("grid_corner_lat");
+    if (sizeDim == NULL || cornerDim == NULL ||
+        lonVar == NULL || latVar == NULL) {
+        Message message;
+        message << "Grid file \"" << fileName << "\" is not in SCRIP format!";
+        REPORT_ERROR(message.str());
+    }
+    int numCell = static_cast<int>(sizeDim->size());
+    int numCorner = static_cast<int>(cornerDim->size());
+    vector<double> cornerLon(numCell*numCorner), cornerLat(numCell*numCorner);
+    lonVar->get(&cornerLon[0], numCell, numCorner);
+    latVar->get(&cornerLat[0], numCell, numCorner);
+    NcAtt *unitsAtt = latVar->get_att("units");
+    if (unitsAtt == NULL || string(unitsAtt->as_string(0)) != "radians")
+        for (int k = 0; k < numCell*numCorner; ++k) {
+            cornerLon[k] /= Rad2Deg;
+            cornerLat[k] /= Rad2Deg;
+        }
+    init(numCell, numCorner, &cornerLon[0], &cornerLat[0]);
+    NcVar *dimsVar = file.get_var("grid_dims");
+    if (dimsVar != NULL) {
+        dims.resize(dimsVar->num_vals());
+        dimsVar->get(&dims[0], dims.size());
+    }
+    file.close();
+}
+
+void RemapGrid::clear()
+{
+    corners.clear();
+    begin.assign(1, 0);
+    areas.clear();
+    centers.clear();
+    radii.clear();
+    dims.clear();
+}
+
+void RemapGrid::addCell(const Vector *x, int n)
+{
+    int first = static_cast<int>(corners.size());
+    for (int k = 0; k < n; ++k)
+        if (calcAngle(x[k], x[(k+1)%n]) > capEps)
+            corners.push_back(x[k]);
+    n = static_cast<int>(corners.size())-first;
+    if (n < 3) {
+        // degenerated cell, which is represented by its first corner
+        centers.push_back(x[0]);
+        radii.push_back(0.0);
+        areas.push_back(0.0);
+        corners.resize(first);
+        begin.push_back(first);
+        return;
+    }
+    double area = calcArea(&corners[first], n);
+    if (area < 0.0)
+        std::reverse(corners.begin()+first, corners.end());
+    areas.push_back(fabs(area));
+    begin.push_back(static_cast<int>(corners.size()));
+    // bounding cap
+    Vector center = 0.0;
+    for (int k = first; k < first+n; ++k)
+        center += corners[k];
+    double length = norm(center);
+    if (length < capEps) {
+        centers.push_back(corners[first]);
+        radii.push_back(PI);
+        return;
+    }
+    center /= length;
+    double radius = 0.0;
+    for (int k = first; k < first+n; ++k)
+        radius = fmax(radius, calcAngle(center, corners[k]));
+    // Note: The arcs between the corners are inside the cap only when the
+    //       cap is smaller than a hemisphere.
+    centers.push_back(center);
+    radii.push_back(radius < PI05 ? radius+capEps : PI);
+}
+
+double RemapGrid::calcArea(const Vector *x, int n)
+{
+    double excess = 0.0;
+    for (int i = 1; i < n-1; ++i) {
+        const Vector &a = x[0], &b = x[i], &c = x[i+1];
+        excess += 2.0*atan2(dot(a, cross(b, c)),
+                            1.0+dot(a, b)+dot(b, c)+dot(c, a));
+    }
+    return excess*Sphere::radius2;
+}
+
+bool RemapGrid::isConvex(const Vector *x, int n)
+{
+    for (int k = 0; k < n; ++k)
+        if (dot(x[(k+2)%n], cross(x[k], x[(k+1)%n])) < 0.0)
+            return false;
+    return true;
+}
+
+inline bool isInTriangle(const Vector &x, const Vector &a, const Vector &b,
+                         const Vector &c)
+{
+    return dot(x, cross(a, b)) >= 0.0 && dot(x, cross(b, c)) >= 0.0 &&
+           dot(x, cross(c, a)) >= 0.0;
+}
+
+void RemapGrid::splitConvex(const Vector *x, int n, vector<Vector> &pieces,
+                            vector<int> &pieceBegin)
+{
+    if (isConvex(x, n)) {
+        pieces.insert(pieces.end(), x, x+n);
+        pieceBegin.push_back(static_cast<int>(pieces.size()));
+        return;
+    }
+    // -------------------------------------------------------------------------
+    // ear clipping
+    vector<int> ring(n);
+    for (int k = 0; k < n; ++k)
+        ring[k] = k;
+    while (ring.size() > 3) {
+        int m = static_cast<int>(ring.size());
+        int ear = -1, convex = -1;
+        for (int k = 0; k < m && ear == -1; ++k) {
+            const Vector &a = x[ring[(k+m-1)%m]];
+            const Vector &b = x[ring[k]];
+            const Vector &c = x[ring[(k+1)%m]];
+            if (dot(c, cross(a, b)) <= 0.0)
+                continue;
+            if (convex == -1)
+                convex = k;
+            ear = k;
+            for (int i = 0; i < m; ++i) {
+                if (i == (k+m-1)%m || i == k || i == (k+1)%m)
+                    continue;
+                if (isInTriangle(x[ring[i]], a, b, c)) {
+                    ear = -1;
+                    break;
+                }
+            }
+        }
+        // Note: There is always an ear in a simple polygon, so the fallbacks
+        //       are only for the degenerated ones due to rounding errors.
+        if (ear == -1)
+            ear = convex != -1 ? convex : 0;
+        pieces.push_back(x[ring[(ear+m-1)%m]]);
+        pieces.push_back(x[ring[ear]]);
+        pieces.push_back(x[ring[(ear+1)%m]]);
+        pieceBegin.push_back(static_cast<int>(pieces.size()));
+        ring.erase(ring.begin()+ear);
+    }
+    pieces.push_back(x[ring[0]]);
+    pieces.push_back(x[ring[1]]);
+    pieces.push_back(x[ring[2]]);
+    pieceBegin.push_back(static_cast<int>(pieces.size()));
+}
+
+// Note: Sutherland-Hodgman with the great circle planes of the clip edges. The
+//       clipped ring of a concave subject may contain degenerated edges along
+//       the clip edges, but its area is right.
+double RemapGrid::calcOverlapArea(const Vector *subject, int numSubject,
+                                  const Vector *clip, int numClip,
+                                  vector<Vector> &ring1, vector<Vector> &ring2)
+{
+    ring1.assign(subject, subject+numSubject);
+    for (int k = 0; k < numClip; ++k) {
+        Vector normal = cross(clip[k], clip[(k+1)%numClip]);
+        int n = static_cast<int>(ring1.size());
+        ring2.clear();
+        for (int i = 0; i < n; ++i) {
+            const Vector &p = ring1[i];
+            const Vector &q = ring1[(i+1)%n];
+            double dp = dot(p, normal), dq = dot(q, normal);
+            if ((dp >= 0.0) != (dq >= 0.0)) {
+                Vector x = (dp*q-dq*p)/(dp-dq);
+                ring2.push_back(x/norm(x));
+            }
+            if (dq >= 0.0)
+                ring2.push_back(q);
+        }
+        ring1.swap(ring2);
+        if (ring1.size() < 3)
+            return 0.0;
+    }
+    return calcArea(&ring1[0], static_cast<int>(ring1.size()));
+}
@@ -0,0 +1,82 @@
+#ifndef RemapGrid_h
+#define RemapGrid_h
+
+#include "Vector.hpp"
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+class RLLMesh;
+
+// -----------------------------------------------------------------------------
+// RemapGrid is a list of spherical cells whose edges are great circle arcs, in
+// the same sense as the SCRIP grid files. The corners of each cell are stored
+// as unit vectors in counter-clockwise order, and each cell is bounded by a
+// spherical cap for searching. It is used as the target of remapping (e.g. a
+// Gaussian, reduced or coarse diagnostics grid of the host model).
+//
+// Note: The cells may be concave, and they are split into convex pieces when
+//       they are used to clip other cells (see splitConvex).
+// Note: The latitudinal edges of RLLMesh cells are approximated by great circle
+//       arcs.
+
+class RemapGrid
+{
+public:
+    RemapGrid();
+    virtual ~RemapGrid();
+
+    // cells of the bound mesh (the same layout as PointCounter::Bound)
+    void init(const RLLMesh &meshBnd);
+    // cells given by the corners in radian ([cell][corner])
+    void init(int numCell, int numCorner, const double *cornerLon,
+              const double *cornerLat);
+    // cells in a SCRIP grid file
+    void init(const string &fileName);
+
+    void clear();
+    // Note: The repeated corners are removed, and the cells with less than
+    //       three corners are kept as points.
+    void addCell(const Vector *corners, int numCorner);
+
+    int getNumCell() const { return static_cast<int>(radii.size()); }
+    int getNumCorner(int cell) const { return begin[cell+1]-begin[cell]; }
+    const Vector *getCorners(int cell) const { return &corners[begin[cell]]; }
+    double getArea(int cell) const { return areas[cell]; }
+    const Vector &getCapCenter(int cell) const { return centers[cell]; }
+    double getCapRadius(int cell) const { return radii[cell]; }
+
+    // shape of the grid for output (e.g. numLon and numLat)
+    const vector<int> &getDims() const { return dims; }
+
+    // signed area of a spherical polygon (positive for counter-clockwise one)
+    static double calcArea(const Vector *x, int n);
+
+    static bool isConvex(const Vector *x, int n);
+
+    // Split a counter-clockwise polygon into convex pieces, which is itself if
+    // it is convex, or the triangles by ear clipping otherwise. The corners of
+    // the pieces are appended to pieces, and their offsets to pieceBegin
+    // (which should start with the offset of the first piece).
+    static void splitConvex(const Vector *x, int n, vector<Vector> &pieces,
+                            vector<int> &pieceBegin);
+
+    // Clip the subject polygon (may be concave) by the convex clip polygon,
+    // and return the overlap area. ring1 and ring2 are the buffers.
+    static double calcOverlapArea(const Vector *subject, int numSubject,
+                                  const Vector *clip, int numClip,
+                                  vector<Vector> &ring1,
+                                  vector<Vector> &ring2);
+
+private:
+    vector<Vector> corners;
+    vector<int> begin;
+    vector<double> areas;
+    vector<Vector> centers;
+    vector<double> radii;
+    vector<int> dims;
+};
+
+#endif
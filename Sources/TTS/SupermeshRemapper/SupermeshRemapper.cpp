@@ -0,0 +1,446 @@
+#include "SupermeshRemapper.hpp"
+#include "PolygonManager.hpp"
+#include "TracerManager.hpp"
+#include "Sphere.hpp"
+#include "ConservationMonitor.hpp"
+#include "CompensatedSum.hpp"
+#include <vector>
+#include <algorithm>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
+using std::pair;
+
+namespace SupermeshRemapper
+{
+    // buckets of cells on a regular longitude-latitude grid
+    struct CapIndex
+    {
+        void build(const RemapGrid &grid);
+        void getRange(const Vector &center, double radius,
+                      int &i0, int &numI, int &j0, int &j1) const;
+        // collect the cells whose caps overlap with the given cap, and the
+        // stamps are used to avoid duplicates
+        void query(const RemapGrid &grid, const Vector &center, double radius,
+                   vector<int> &stamps, int stamp,
+                   vector<int> &candidates) const;
+
+        int numLon, numLat;
+        double dlon, dlat;
+        vector<int> begin, items;
+    };
+
+    struct OverlapRecord
+    {
+        int source;
+        double area;
+    };
+
+    // Note: Each thread has its own buffer, and the records of each target
+    //       cell are contiguous in it.
+    struct ThreadBuffer
+    {
+        vector<OverlapRecord> records;
+        vector<int> stamps, candidates;
+        vector<Vector> ring1, ring2;
+        // convex pieces of the current target cell
+        vector<Vector> pieces;
+        vector<int> pieceBegin;
+    };
+
+    struct TargetRange
+    {
+        int thread, first, last;
+    };
+
+    // the polygons to be replaced during rezoning
+    static RemapGrid sources;
+    // tracer masses of the source polygons ([polygon][tracer])
+    static vector<double> sourceMasses;
+    static int numTracer = 0;
+    // the current polygons
+    static RemapGrid polygonCells;
+    static CapIndex sourceIndex, targetIndex;
+    static vector<ThreadBuffer> buffers;
+    static vector<TargetRange> targetRanges;
+    // total overlap area of each source cell
+    static vector<double> totalAreas;
+    // target cells of the source cells without any overlap
+    static vector<int> orphanTargets;
+}
+
+using namespace SupermeshRemapper;
+
+// -----------------------------------------------------------------------------
+
+inline double calcAngle(const Vector &x1, const Vector &x2)
+{
+    return atan2(norm(cross(x1, x2)), dot(x1, x2));
+}
+
+inline bool isInside(const Vector &x, const Vector *ring, int n)
+{
+    for (int k = 0; k < n; ++k)
+        if (dot(x, cross(ring[k], ring[(k+1)%n])) < 0.0)
+            return false;
+    return true;
+}
+
+inline bool isInside(const Vector &x, const vector<Vector> &pieces,
+                     const vector<int> &pieceBegin)
+{
+    for (int k = 0; k < static_cast<int>(pieceBegin.size())-1; ++k)
+        if (isInside(x, &pieces[pieceBegin[k]], pieceBegin[k+1]-pieceBegin[k]))
+            return true;
+    return false;
+}
+
+// collect the polygons as the cells of the grid in the given order
+static void addPolygons(const vector<Polygon *> &polygons, RemapGrid &grid)
+{
+    vector<Vector> ring;
+    grid.clear();
+    for (int p = 0; p < polygons.size(); ++p) {
+        ring.clear();
+        EdgePointer *edgePointer = polygons[p]->edgePointers.front();
+        for (int i = 0; i < polygons[p]->edgePointers.size(); ++i) {
+            ring.push_back(edgePointer->getEndPoint(FirstPoint)->
+                           getCoordinate().getCAR());
+            edgePointer = edgePointer->next;
+        }
+        grid.addCell(&ring[0], static_cast<int>(ring.size()));
+    }
+}
+
+static void getPolygons(PolygonManager &polygonManager,
+                        vector<Polygon *> &polygons)
+{
+    polygons.resize(polygonManager.polygons.size());
+    Polygon *polygon = polygonManager.polygons.front();
+    for (int p = 0; p < polygonManager.polygons.size(); ++p) {
+        polygons[p] = polygon;
+        polygon = polygon->next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void CapIndex::build(const RemapGrid &grid)
+{
+    numLat = static_cast<int>(sqrt(grid.getNumCell()*0.5))+1;
+    numLon = numLat*2;
+    dlon = PI2/numLon;
+    dlat = PI/numLat;
+    begin.assign(numLon*numLat+1, 0);
+    int i0, numI, j0, j1;
+    for (int c = 0; c < grid.getNumCell(); ++c) {
+        getRange(grid.getCapCenter(c), grid.getCapRadius(c), i0, numI, j0, j1);
+        for (int j = j0; j <= j1; ++j)
+            for (int i = i0; i < i0+numI; ++i)
+                begin[j*numLon+(i+numLon)%numLon+1]++;
+    }
+    for (int k = 0; k < numLon*numLat; ++k)
+        begin[k+1] += begin[k];
+    items.resize(begin.back());
+    vector<int> cursors(begin.begin(), begin.end()-1);
+    for (int c = 0; c < grid.getNumCell(); ++c) {
+        getRange(grid.getCapCenter(c), grid.getCapRadius(c), i0, numI, j0, j1);
+        for (int j = j0; j <= j1; ++j)
+            for (int i = i0; i < i0+numI; ++i)
+                items[cursors[j*numLon+(i+numLon)%numLon]++] = c;
+    }
+}
+
+void CapIndex::getRange(const Vector &center, double radius,
+                        int &i0, int &numI, int &j0, int &j1) const
+{
+    double lat = asin(fmax(-1.0, fmin(1.0, center(2))));
+    double lon = atan2(center(1), center(0));
+    if (lon < 0.0) lon += PI2;
+    j0 = static_cast<int>((lat-radius+PI05)/dlat);
+    j1 = static_cast<int>((lat+radius+PI05)/dlat);
+    j0 = j0 < 0 ? 0 : j0 >= numLat ? numLat-1 : j0;
+    j1 = j1 < 0 ? 0 : j1 >= numLat ? numLat-1 : j1;
+    // the zonal extent of the cap, which is full if the cap includes a pole
+    if (lat+radius >= PI05 || lat-radius <= -PI05 ||
+        sin(radius) >= cos(lat)) {
+        i0 = 0;
+        numI = numLon;
+        return;
+    }
+    double dlonCap = asin(sin(radius)/cos(lat));
+    i0 = static_cast<int>(floor((lon-dlonCap)/dlon));
+    int i1 = static_cast<int>(floor((lon+dlonCap)/dlon));
+    numI = i1-i0+1 < numLon ? i1-i0+1 : numLon;
+}
+
+void CapIndex::query(const RemapGrid &grid, const Vector &center,
+                     double radius, vector<int> &stamps, int stamp,
+                     vector<int> &candidates) const
+{
+    int i0, numI, j0, j1;
+    candidates.clear();
+    getRange(center, radius, i0, numI, j0, j1);
+    for (int j = j0; j <= j1; ++j)
+        for (int i = i0; i < i0+numI; ++i) {
+            int k = j*numLon+(i+numLon)%numLon;
+            for (int m = begin[k]; m < begin[k+1]; ++m) {
+                int c = items[m];
+                if (stamps[c] == stamp)
+                    continue;
+                stamps[c] = stamp;
+                if (calcAngle(center, grid.getCapCenter(c)) <=
+                    radius+grid.getCapRadius(c))
+                    candidates.push_back(c);
+            }
+        }
+}
+
+// -----------------------------------------------------------------------------
+
+// Calculate the overlap areas between the source and target cells in parallel
+// over the target cells, and sum them for each source cell. The target cells
+// may be concave (e.g. the relaxed polygons of a rezoned patch), so they are
+// split into convex pieces, and the overlap area is summed over the pieces.
+// Note: The source cells without any overlap (e.g. degenerated ones) are given
+//       to the target cell where their first corner is in.
+static void calcOverlaps(const RemapGrid &sources, const RemapGrid &targets)
+{
+    int numSource = sources.getNumCell();
+    int numTarget = targets.getNumCell();
+    sourceIndex.build(sources);
+    targetIndex.build(targets);
+    int numThread = 1;
+#ifdef _OPENMP
+    numThread = omp_get_max_threads();
+#endif
+    if (static_cast<int>(buffers.size()) < numThread)
+        buffers.resize(numThread);
+    targetRanges.resize(numTarget);
+#pragma omp parallel
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        ThreadBuffer &buffer = buffers[thread];
+        buffer.records.clear();
+        buffer.stamps.assign(numSource, -1);
+#pragma omp for schedule(dynamic, 64)
+        for (int t = 0; t < numTarget; ++t) {
+            targetRanges[t].thread = thread;
+            targetRanges[t].first = static_cast<int>(buffer.records.size());
+            if (targets.getNumCorner(t) == 0) {
+                targetRanges[t].last = targetRanges[t].first;
+                continue;
+            }
+            buffer.pieces.clear();
+            buffer.pieceBegin.assign(1, 0);
+            RemapGrid::splitConvex(targets.getCorners(t),
+                                   targets.getNumCorner(t),
+                                   buffer.pieces, buffer.pieceBegin);
+            int numPiece = static_cast<int>(buffer.pieceBegin.size())-1;
+            sourceIndex.query(sources, targets.getCapCenter(t),
+                              targets.getCapRadius(t), buffer.stamps, t,
+                              buffer.candidates);
+            for (int k = 0; k < buffer.candidates.size(); ++k) {
+                int s = buffer.candidates[k];
+                if (sources.getNumCorner(s) == 0)
+                    continue;
+                OverlapRecord record;
+                record.source = s;
+                record.area = 0.0;
+                for (int m = 0; m < numPiece; ++m) {
+                    int first = buffer.pieceBegin[m];
+                    record.area += RemapGrid::calcOverlapArea(
+                        sources.getCorners(s), sources.getNumCorner(s),
+                        &buffer.pieces[first], buffer.pieceBegin[m+1]-first,
+                        buffer.ring1, buffer.ring2);
+                }
+                if (record.area > 0.0)
+                    buffer.records.push_back(record);
+            }
+            targetRanges[t].last = static_cast<int>(buffer.records.size());
+        }
+    }
+    // -------------------------------------------------------------------------
+    // sum the overlap areas of each source cell in the target order, so the
+    // result does not depend on the number of threads
+    totalAreas.assign(numSource, 0.0);
+    for (int t = 0; t < numTarget; ++t) {
+        const vector<OverlapRecord> &records =
+            buffers[targetRanges[t].thread].records;
+        for (int k = targetRanges[t].first; k < targetRanges[t].last; ++k)
+            totalAreas[records[k].source] += records[k].area;
+    }
+    // -------------------------------------------------------------------------
+    orphanTargets.assign(numSource, -1);
+    vector<int> stamps(numTarget, -1), candidates, pieceBegin;
+    vector<Vector> pieces;
+    for (int s = 0; s < numSource; ++s) {
+        if (totalAreas[s] > 0.0)
+            continue;
+        const Vector &x = sources.getNumCorner(s) > 0 ?
+            sources.getCorners(s)[0] : sources.getCapCenter(s);
+        targetIndex.query(targets, x, 0.0, stamps, s, candidates);
+        for (int k = 0; k < candidates.size(); ++k) {
+            int t = candidates[k];
+            int n = targets.getNumCorner(t);
+            if (n == 0)
+                continue;
+            pieces.clear();
+            pieceBegin.assign(1, 0);
+            RemapGrid::splitConvex(targets.getCorners(t), n, pieces,
+                                   pieceBegin);
+            if (isInside(x, pieces, pieceBegin)) {
+                orphanTargets[s] = t;
+                break;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SupermeshRemapper::saveSource(PolygonManager &polygonManager,
+                                   TracerManager &tracerManager)
+{
+    vector<Polygon *> polygons;
+    getPolygons(polygonManager, polygons);
+    saveSource(polygons, tracerManager);
+}
+
+void SupermeshRemapper::saveSource(const vector<Polygon *> &polygons,
+                                   TracerManager &tracerManager)
+{
+    numTracer = tracerManager.getTracerNum();
+    addPolygons(polygons, sources);
+    sourceMasses.resize(polygons.size()*numTracer);
+    for (int p = 0; p < polygons.size(); ++p)
+        for (int l = 0; l < numTracer; ++l)
+            sourceMasses[p*numTracer+l] = polygons[p]->getTracerMass(l);
+}
+
+void SupermeshRemapper::remap(TracerManager &tracerManager)
+{
+    vector<Polygon *> polygons;
+    getPolygons(tracerManager.polygonManager, polygons);
+    remap(polygons, tracerManager);
+}
+
+void SupermeshRemapper::remap(const vector<Polygon *> &polygons,
+                              TracerManager &tracerManager)
+{
+    NOTICE("SupermeshRemapper::remap", "running ...");
+    clock_t start, end;
+    start = clock();
+    int numSource = sources.getNumCell();
+    int numTarget = static_cast<int>(polygons.size());
+    addPolygons(polygons, polygonCells);
+    // -------------------------------------------------------------------------
+    // calculate the overlap areas between the target and source polygons
+    calcOverlaps(sources, polygonCells);
+    // -------------------------------------------------------------------------
+    // distribute the tracer masses with partition of unity
+    vector<double> targetMasses(numTarget*numTracer, 0.0);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int t = 0; t < numTarget; ++t) {
+        const vector<OverlapRecord> &records =
+            buffers[targetRanges[t].thread].records;
+        double *masses = &targetMasses[t*numTracer];
+        for (int k = targetRanges[t].first; k < targetRanges[t].last; ++k) {
+            double weight = records[k].area/totalAreas[records[k].source];
+            const double *source = &sourceMasses[records[k].source*numTracer];
+            for (int l = 0; l < numTracer; ++l)
+                masses[l] += source[l]*weight;
+        }
+    }
+    for (int s = 0; s < numSource; ++s)
+        if (orphanTargets[s] != -1)
+            for (int l = 0; l < numTracer; ++l)
+                targetMasses[orphanTargets[s]*numTracer+l] +=
+                    sourceMasses[s*numTracer+l];
+    // -------------------------------------------------------------------------
+    // set tracer mass and calculate tracer density
+    vector<CompensatedSum> totalSourceMasses(numTracer);
+    vector<CompensatedSum> totalTargetMasses(numTracer);
+    for (int s = 0; s < numSource; ++s)
+        for (int l = 0; l < numTracer; ++l)
+            totalSourceMasses[l].add(sourceMasses[s*numTracer+l]);
+    for (int t = 0; t < numTarget; ++t) {
+        for (int l = 0; l < numTracer; ++l) {
+            polygons[t]->setTracerMass(l, targetMasses[t*numTracer+l]);
+            polygons[t]->updateTracer(l);
+            totalTargetMasses[l].add(targetMasses[t*numTracer+l]);
+        }
+    }
+    // -------------------------------------------------------------------------
+    for (int l = 0; l < numTracer; ++l) {
+        double sourceMass = totalSourceMasses[l].getSum();
+        double targetMass = totalTargetMasses[l].getSum();
+        ConservationMonitor::addMass(l, targetMass-sourceMass);
+        ConservationMonitor::recordRemap(l, sourceMass, targetMass);
+    }
+#ifdef DEBUG
+    // check the coverage of each target polygon
+    double maxDiffArea = 0.0;
+    for (int t = 0; t < numTarget; ++t) {
+        const vector<OverlapRecord> &records =
+            buffers[targetRanges[t].thread].records;
+        double area = 0.0;
+        for (int k = targetRanges[t].first; k < targetRanges[t].last; ++k)
+            area += records[k].area;
+        if (polygons[t]->getArea() > 0.0)
+            maxDiffArea = fmax(maxDiffArea, fabs(area-polygons[t]->getArea())/
+                               polygons[t]->getArea());
+    }
+    cout << "Maximum area difference: " << maxDiffArea*100 << "%" << endl;
+#endif
+    end = clock();
+    cout << "[Timing]: SupermeshRemapper::remap: ";
+    cout << setprecision(5) << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
+}
+
+void SupermeshRemapper::calcWeightMatrix(PolygonManager &polygonManager,
+                                         const RemapGrid &grid,
+                                         WeightMatrix &matrix)
+{
+    NOTICE("SupermeshRemapper::calcWeightMatrix", "running ...");
+    clock_t start, end;
+    start = clock();
+    vector<Polygon *> polygons;
+    getPolygons(polygonManager, polygons);
+    addPolygons(polygons, polygonCells);
+    calcOverlaps(polygonCells, grid);
+    int numPolygon = polygonCells.getNumCell();
+    // -------------------------------------------------------------------------
+    // sort the orphan polygons by their cells
+    vector<pair<int, int> > orphans;
+    for (int p = 0; p < numPolygon; ++p)
+        if (orphanTargets[p] != -1)
+            orphans.push_back(pair<int, int>(orphanTargets[p], p));
+    std::sort(orphans.begin(), orphans.end());
+    // -------------------------------------------------------------------------
+    // w(cell, polygon) = overlap/(total overlap of polygon)/(area of cell)
+    matrix.beginBuild(numPolygon);
+    int m = 0;
+    for (int c = 0; c < grid.getNumCell(); ++c) {
+        matrix.addRow();
+        if (grid.getArea(c) == 0.0)
+            continue;
+        const vector<OverlapRecord> &records =
+            buffers[targetRanges[c].thread].records;
+        for (int k = targetRanges[c].first; k < targetRanges[c].last; ++k)
+            matrix.add(records[k].source, records[k].area/
+                       totalAreas[records[k].source]/grid.getArea(c));
+        for (; m < orphans.size() && orphans[m].first == c; ++m)
+            matrix.add(orphans[m].second, 1.0/grid.getArea(c));
+    }
+    matrix.endBuild();
+    end = clock();
+    cout << "[Timing]: SupermeshRemapper::calcWeightMatrix: ";
+    cout << setprecision(5) << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
+}
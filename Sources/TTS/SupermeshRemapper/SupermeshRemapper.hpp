@@ -0,0 +1,51 @@
+#ifndef SupermeshRemapper_h
+#define SupermeshRemapper_h
+
+class PolygonManager;
+class TracerManager;
+class Polygon;
+#include "RemapGrid.hpp"
+#include "WeightMatrix.hpp"
+
+// -----------------------------------------------------------------------------
+// SupermeshRemapper transfers the tracer masses from the polygons that are
+// replaced during rezoning to the new polygons directly, without going through
+// the point counter mesh. The old polygons are clipped by the convex pieces of
+// the new ones (both may be concave, e.g. the relaxed polygons of a patch) with
+// great circle planes, and the masses are distributed by the exact overlap
+// areas with partition of unity, so the total mass is conserved. The candidate pairs are found by bucketing the bounding
+// caps of both polygon sets, and the new polygons are processed in parallel.
+//
+// The same engine calculates the weight matrix from the polygons to the cells
+// of any RemapGrid (see MeshAdaptor::calcWeightMatrix).
+//
+// Usage:
+//   SupermeshRemapper::saveSource(polygonManager, tracerManager);
+//   ... replace the polygons ...
+//   SupermeshRemapper::remap(tracerManager);
+//
+// The polygons can also be given explicitly (e.g. the patch of polygons that
+// are rezoned locally), in which case the masses are only transferred among
+// them, so the patch must cover the same region before and after.
+
+namespace SupermeshRemapper
+{
+    // save the geometry and tracer masses of the polygons to be replaced
+    void saveSource(PolygonManager &polygonManager,
+                    TracerManager &tracerManager);
+
+    void saveSource(const vector<Polygon *> &polygons,
+                    TracerManager &tracerManager);
+
+    // transfer the saved tracer masses onto the current polygons
+    void remap(TracerManager &tracerManager);
+    void remap(const vector<Polygon *> &polygons,
+               TracerManager &tracerManager);
+
+    // calculate the weight matrix from the tracer masses of the polygons to
+    // the tracer densities on the grid cells
+    void calcWeightMatrix(PolygonManager &polygonManager,
+                          const RemapGrid &grid, WeightMatrix &matrix);
+}
+
+#endif
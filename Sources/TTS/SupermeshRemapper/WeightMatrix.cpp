@@ -0,0 +1,141 @@
+#include "WeightMatrix.hpp"
+#include "ReportMacros.hpp"
+#include <netcdfcpp.h>
+
+WeightMatrix::WeightMatrix()
+{
+    numCol = 0;
+    rowBegins.assign(1, 0);
+}
+
+WeightMatrix::~WeightMatrix()
+{
+}
+
+void WeightMatrix::beginBuild(int numCol)
+{
+    this->numCol = numCol;
+    rowBegins.assign(1, 0);
+    cols.clear();
+    weights.clear();
+}
+
+void WeightMatrix::addRow()
+{
+    // Note: The end of the last row is the beginning of the new one, and it
+    //       is moved by add.
+    rowBegins.push_back(static_cast<int>(cols.size()));
+}
+
+void WeightMatrix::add(int col, double weight)
+{
+    cols.push_back(col);
+    weights.push_back(weight);
+    rowBegins.back()++;
+}
+
+void WeightMatrix::endBuild()
+{
+    assert(rowBegins.back() == static_cast<int>(cols.size()));
+}
+
+void WeightMatrix::apply(const double *x, int numTracer, double *y) const
+{
+    int numRow = getNumRow();
+#pragma omp parallel for
+    for (int row = 0; row < numRow; ++row) {
+        double *y0 = &y[row*numTracer];
+        for (int l = 0; l < numTracer; ++l)
+            y0[l] = 0.0;
+        for (int k = rowBegins[row]; k < rowBegins[row+1]; ++k) {
+            const double *x0 = &x[cols[k]*numTracer];
+            for (int l = 0; l < numTracer; ++l)
+                y0[l] += weights[k]*x0[l];
+        }
+    }
+}
+
+void WeightMatrix::output(const string &fileName) const
+{
+    NcFile file(fileName.c_str(), NcFile::Replace);
+    if (!file.is_valid()) {
+        Message message;
+        message << "Failed to open file \"" << fileName << "\"!";
+        REPORT_ERROR(message.str());
+    }
+    int numNonZero = getNumNonZero();
+    // Note: The sizes of the source and target grids are only recorded as
+    //       the dimensions like the SCRIP weight files.
+    file.add_dim("n_a", numCol);
+    file.add_dim("n_b", getNumRow());
+    NcDim *numNonZeroDim = file.add_dim("n_s", numNonZero);
+    file.add_att("source", "polygons");
+    file.add_att("normalization", "none");
+    NcVar *rowVar = file.add_var("row", ncInt, numNonZeroDim);
+    NcVar *colVar = file.add_var("col", ncInt, numNonZeroDim);
+    NcVar *weightVar = file.add_var("S", ncDouble, numNonZeroDim);
+    rowVar->add_att("long_name", "target cell index (1-based)");
+    colVar->add_att("long_name", "source polygon index (1-based)");
+    weightVar->add_att("long_name", "weight from polygon mass to cell density");
+    vector<int> rows(numNonZero), cols1(numNonZero);
+    for (int row = 0; row < getNumRow(); ++row)
+        for (int k = rowBegins[row]; k < rowBegins[row+1]; ++k) {
+            rows[k] = row+1;
+            cols1[k] = cols[k]+1;
+        }
+    if (numNonZero > 0) {
+        rowVar->put(&rows[0], numNonZero);
+        colVar->put(&cols1[0], numNonZero);
+        weightVar->put(&weights[0], numNonZero);
+    }
+    file.close();
+    NOTICE("WeightMatrix", fileName+" is generated.");
+}
+
+void WeightMatrix::input(const string &fileName)
+{
+    NcError ncError(NcError::silent_nonfatal);
+    NcFile file(fileName.c_str(), NcFile::ReadOnly);
+    if (!file.is_valid()) {
+        Message message;
+        message << "Failed to open file \"" << fileName << "\"!";
+        REPORT_ERROR(message.str());
+    }
+    NcDim *numColDim = file.get_dim("n_a");
+    NcDim *numRowDim = file.get_dim("n_b");
+    NcDim *numNonZeroDim = file.get_dim("n_s");
+    NcVar *rowVar = file.get_var("row");
+    NcVar *colVar = file.get_var("col");
+    NcVar *weightVar = file.get_var("S");
+    if (numColDim == NULL || numRowDim == NULL || numNonZeroDim == NULL ||
+        rowVar == NULL || colVar == NULL || weightVar == NULL) {
+        Message message;
+        message << "File \"" << fileName << "\" is not a weight matrix!";
+        REPORT_ERROR(message.str());
+    }
+    int numRow = static_cast<int>(numRowDim->size());
+    int numNonZero = static_cast<int>(numNonZeroDim->size());
+    vector<int> rows(numNonZero), cols1(numNonZero);
+    vector<double> weights1(numNonZero);
+    if (numNonZero > 0) {
+        rowVar->get(&rows[0], numNonZero);
+        colVar->get(&cols1[0], numNonZero);
+        weightVar->get(&weights1[0], numNonZero);
+    }
+    file.close();
+    // sort the entries into rows (stable, so the order in each row is kept)
+    numCol = static_cast<int>(numColDim->size());
+    rowBegins.assign(numRow+1, 0);
+    for (int k = 0; k < numNonZero; ++k)
+        rowBegins[rows[k]]++;
+    for (int row = 0; row < numRow; ++row)
+        rowBegins[row+1] += rowBegins[row];
+    cols.resize(numNonZero);
+    weights.resize(numNonZero);
+    vector<int> cursors(rowBegins.begin(), rowBegins.end()-1);
+    for (int k = 0; k < numNonZero; ++k) {
+        int m = cursors[rows[k]-1]++;
+        cols[m] = cols1[k]-1;
+        weights[m] = weights1[k];
+    }
+}
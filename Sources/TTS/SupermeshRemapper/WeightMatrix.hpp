@@ -0,0 +1,52 @@
+#ifndef WeightMatrix_h
+#define WeightMatrix_h
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// WeightMatrix is a sparse matrix in compressed rows, which maps the tracer
+// masses of the polygons (columns) to the tracer densities on the cells of a
+// remap grid (rows):
+//   q(cell) = sum_polygon w(cell, polygon)*m(polygon).
+// It can be applied to several tracers at once, and it can be written into
+// a file in the SCRIP convention (row, col and S variables in 1-based indices)
+// for reuse when the polygons are not moved (e.g. during initialization).
+
+class WeightMatrix
+{
+public:
+    WeightMatrix();
+    virtual ~WeightMatrix();
+
+    // building interface, the rows should be added in order
+    void beginBuild(int numCol);
+    void addRow();
+    void add(int col, double weight);
+    void endBuild();
+
+    int getNumRow() const { return static_cast<int>(rowBegins.size())-1; }
+    int getNumCol() const { return numCol; }
+    int getNumNonZero() const { return static_cast<int>(cols.size()); }
+    int rowBegin(int row) const { return rowBegins[row]; }
+    int rowEnd(int row) const { return rowBegins[row+1]; }
+    int getCol(int k) const { return cols[k]; }
+    double getWeight(int k) const { return weights[k]; }
+
+    // y[row][l] = sum_col w(row, col)*x[col][l] for l = 0 ... numTracer-1
+    void apply(const double *x, int numTracer, double *y) const;
+
+    void output(const string &fileName) const;
+    void input(const string &fileName);
+
+private:
+    int numCol;
+    vector<int> rowBegins;
+    vector<int> cols;
+    vector<double> weights;
+};
+
+#endif
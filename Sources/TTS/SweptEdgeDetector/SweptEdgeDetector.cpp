@@ -0,0 +1,316 @@
+#include "SweptEdgeDetector.hpp"
+#include "PolygonManager.hpp"
+#include "Vertex.hpp"
+#include "Edge.hpp"
+#include "Sphere.hpp"
+#include <algorithm>
+
+using namespace SweptEdgeDetector;
+
+// -----------------------------------------------------------------------------
+// spherical cap (center is a unit vector, radius is an angle)
+
+struct Cap
+{
+    Vector center;
+    double radius;
+};
+
+static const double capEps = 1.0e-12;
+static const int maxLeafSize = 4;
+
+inline double calcAngle(const Vector &x1, const Vector &x2)
+{
+    return atan2(norm(cross(x1, x2)), dot(x1, x2));
+}
+
+inline void calcArcCap(const Vector &x1, const Vector &x2, Cap &cap)
+{
+    Vector x = x1+x2;
+    double n = norm(x);
+    if (n < capEps) {
+        cap.center = x1;
+        cap.radius = PI;
+    } else {
+        cap.center = x/n;
+        cap.radius = calcAngle(x1, cap.center)+capEps;
+    }
+}
+
+inline void mergeCap(Cap &cap1, const Cap &cap2)
+{
+    double d = calcAngle(cap1.center, cap2.center);
+    if (d+cap2.radius <= cap1.radius)
+        return;
+    if (d+cap1.radius <= cap2.radius) {
+        cap1 = cap2;
+        return;
+    }
+    double radius = 0.5*(d+cap1.radius+cap2.radius);
+    if (radius >= PI || sin(d) < capEps) {
+        cap1.radius = fmin(PI, fmax(radius, fmax(cap1.radius, cap2.radius)));
+        return;
+    }
+    // move the center along the great circle from cap1 to cap2
+    double t = radius-cap1.radius;
+    Vector center = (sin(d-t)*cap1.center+sin(t)*cap2.center)/sin(d);
+    cap1.center = center/norm(center);
+    cap1.radius = radius+capEps;
+}
+
+inline bool isOverlap(const Cap &cap1, const Cap &cap2, double margin)
+{
+    return calcAngle(cap1.center, cap2.center) <=
+           cap1.radius+cap2.radius+margin;
+}
+
+inline void calcPathCap(Point *point, Cap &cap)
+{
+    const Coordinate &x0 = point->getCoordinate(OldTimeLevel);
+    const Coordinate &x1 = point->getCoordinate(NewTimeLevel);
+    if (x0.isSet())
+        calcArcCap(x0.getCAR(), x1.getCAR(), cap);
+    else
+        calcArcCap(x1.getCAR(), x1.getCAR(), cap);
+}
+
+inline void calcSweptCap(Edge *edge, Cap &cap)
+{
+    Vertex *vertex1 = edge->getEndPoint(FirstPoint);
+    Vertex *vertex2 = edge->getEndPoint(SecondPoint);
+    Cap tmp;
+    calcArcCap(vertex1->getCoordinate(NewTimeLevel).getCAR(),
+               vertex2->getCoordinate(NewTimeLevel).getCAR(), cap);
+    if (vertex1->getCoordinate(OldTimeLevel).isSet() &&
+        vertex2->getCoordinate(OldTimeLevel).isSet()) {
+        calcArcCap(vertex1->getCoordinate(OldTimeLevel).getCAR(),
+                   vertex2->getCoordinate(OldTimeLevel).getCAR(), tmp);
+        mergeCap(cap, tmp);
+        calcPathCap(vertex1, tmp);
+        mergeCap(cap, tmp);
+        calcPathCap(vertex2, tmp);
+        mergeCap(cap, tmp);
+    }
+    // Note: The test point may be off the arcs (it is what CurvatureGuard
+    //       checks), and ApproachDetector looks for it in the tree too.
+    const Coordinate &x3 = edge->getTestPoint()->getCoordinate(NewTimeLevel);
+    if (x3.isSet()) {
+        calcArcCap(x3.getCAR(), x3.getCAR(), tmp);
+        mergeCap(cap, tmp);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// bounding volume hierarchy
+
+struct Node
+{
+    Cap cap;
+    int child[2]; // -1 for leaf node
+    int first, last;
+};
+
+static std::vector<Edge *> leafEdges;
+static std::vector<Cap> leafCaps;
+static std::vector<Node> nodes;
+static std::vector<Edge *> lateEdges;
+static std::vector<int> nodeStack;
+static bool built = false;
+
+struct CenterLess
+{
+    CenterLess(int axis) : axis(axis) {}
+    bool operator()(int i, int j) const {
+        return leafCaps[i].center(axis) < leafCaps[j].center(axis);
+    }
+    int axis;
+};
+
+static int buildNode(std::vector<int> &order, int first, int last)
+{
+    int n = static_cast<int>(nodes.size());
+    nodes.push_back(Node());
+    Cap cap = leafCaps[order[first]];
+    Vector minCenter = cap.center, maxCenter = cap.center;
+    for (int i = first+1; i < last; ++i) {
+        const Cap &leafCap = leafCaps[order[i]];
+        mergeCap(cap, leafCap);
+        for (int m = 0; m < 3; ++m) {
+            minCenter(m) = fmin(minCenter(m), leafCap.center(m));
+            maxCenter(m) = fmax(maxCenter(m), leafCap.center(m));
+        }
+    }
+    nodes[n].cap = cap;
+    nodes[n].first = first;
+    nodes[n].last = last;
+    if (last-first <= maxLeafSize) {
+        nodes[n].child[0] = -1;
+        nodes[n].child[1] = -1;
+        return n;
+    }
+    // split at the median of the centers along the longest extent
+    int axis = 0;
+    for (int m = 1; m < 3; ++m)
+        if (maxCenter(m)-minCenter(m) > maxCenter(axis)-minCenter(axis))
+            axis = m;
+    int middle = (first+last)/2;
+    std::nth_element(order.begin()+first, order.begin()+middle,
+                     order.begin()+last, CenterLess(axis));
+    int child0 = buildNode(order, first, middle);
+    int child1 = buildNode(order, middle, last);
+    nodes[n].child[0] = child0;
+    nodes[n].child[1] = child1;
+    return n;
+}
+
+inline bool isLeafValid(int i)
+{
+    Edge *edge = leafEdges[i];
+    return edge->sweptStamp == i && edge->endTag != ListElement<Edge>::Null &&
+        edge->getEndPoint(FirstPoint) != NULL &&
+        edge->getEndPoint(SecondPoint) != NULL;
+}
+
+inline bool isLateValid(int i)
+{
+    Edge *edge = lateEdges[i];
+    return edge->sweptStamp == static_cast<int>(leafEdges.size())+i &&
+        edge->endTag != ListElement<Edge>::Null &&
+        edge->getEndPoint(FirstPoint) != NULL &&
+        edge->getEndPoint(SecondPoint) != NULL;
+}
+
+// Build the tree over the given edges, and stamp the edges with their leaves.
+static void buildTree(const std::vector<Edge *> &edges)
+{
+    int numEdge = static_cast<int>(edges.size());
+    leafCaps.resize(numEdge);
+    for (int i = 0; i < numEdge; ++i)
+        calcSweptCap(edges[i], leafCaps[i]);
+    std::vector<int> order(numEdge);
+    for (int i = 0; i < numEdge; ++i)
+        order[i] = i;
+    nodes.reserve(2*numEdge/maxLeafSize+1);
+    if (numEdge > 0)
+        buildNode(order, 0, numEdge);
+    // put the leaves in the tree order
+    std::vector<Cap> caps(numEdge);
+    leafEdges.resize(numEdge);
+    for (int i = 0; i < numEdge; ++i) {
+        leafEdges[i] = edges[order[i]];
+        caps[i] = leafCaps[order[i]];
+        leafEdges[i]->sweptStamp = i;
+    }
+    leafCaps.swap(caps);
+}
+
+// Collect the edges whose caps overlap with the given cap.
+static void collectEdges(const Cap &cap, double margin,
+                         std::vector<Edge *> &edges)
+{
+    if (!nodes.empty()) {
+        nodeStack.clear();
+        nodeStack.push_back(0);
+        while (!nodeStack.empty()) {
+            const Node &node = nodes[nodeStack.back()];
+            nodeStack.pop_back();
+            if (!isOverlap(node.cap, cap, margin))
+                continue;
+            if (node.child[0] != -1) {
+                nodeStack.push_back(node.child[1]);
+                nodeStack.push_back(node.child[0]);
+                continue;
+            }
+            for (int i = node.first; i < node.last; ++i)
+                if (isLeafValid(i) && isOverlap(leafCaps[i], cap, margin))
+                    edges.push_back(leafEdges[i]);
+        }
+    }
+    Cap lateCap;
+    for (int i = 0; i < static_cast<int>(lateEdges.size()); ++i) {
+        if (!isLateValid(i))
+            continue;
+        calcSweptCap(lateEdges[i], lateCap);
+        if (isOverlap(lateCap, cap, margin))
+            edges.push_back(lateEdges[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SweptEdgeDetector::build(PolygonManager &polygonManager)
+{
+    clear();
+    std::vector<Edge *> edges(polygonManager.edges.size());
+    Edge *edge = polygonManager.edges.front();
+    for (int i = 0; i < polygonManager.edges.size(); ++i) {
+        edges[i] = edge;
+        edge = edge->next;
+    }
+    buildTree(edges);
+    built = true;
+}
+
+void SweptEdgeDetector::clear()
+{
+    leafEdges.clear();
+    leafCaps.clear();
+    nodes.clear();
+    lateEdges.clear();
+    built = false;
+}
+
+bool SweptEdgeDetector::isBuilt()
+{
+    return built;
+}
+
+void SweptEdgeDetector::recordEdge(Edge *edge)
+{
+    if (!built)
+        return;
+    int i = edge->sweptStamp-static_cast<int>(leafEdges.size());
+    if (i >= 0 && i < static_cast<int>(lateEdges.size()) &&
+        lateEdges[i] == edge)
+        return;
+    edge->sweptStamp = static_cast<int>(leafEdges.size()+lateEdges.size());
+    lateEdges.push_back(edge);
+    // Note: Rebuild the tree when too many edges are outside of it.
+    if (lateEdges.size() > leafEdges.size()/4+64) {
+        std::vector<Edge *> edges;
+        edges.reserve(leafEdges.size()+lateEdges.size());
+        for (int i = 0; i < static_cast<int>(leafEdges.size()); ++i)
+            if (isLeafValid(i))
+                edges.push_back(leafEdges[i]);
+        for (int i = 0; i < static_cast<int>(lateEdges.size()); ++i)
+            if (isLateValid(i))
+                edges.push_back(lateEdges[i]);
+        clear();
+        buildTree(edges);
+        built = true;
+    }
+}
+
+void SweptEdgeDetector::queryEdges(const Coordinate &x1, const Coordinate &x2,
+                                   std::vector<Edge *> &edges, double distance)
+{
+    Cap cap;
+    calcArcCap(x1.getCAR(), x2.getCAR(), cap);
+    edges.clear();
+    collectEdges(cap, distance/Sphere::radius, edges);
+}
+
+bool SweptEdgeDetector::mayApproach(Vertex *point, Edge *edge, double distance)
+{
+    // Note: The distance of a projection is not shorter than the distance from
+    //       the point to the great circle of the edge, so this check never
+    //       rejects a pair that would pass ApproachDetector::isNeedCheck.
+    const Vector &x1 = edge->getEndPoint(FirstPoint)->getCoordinate().getCAR();
+    const Vector &x2 = edge->getEndPoint(SecondPoint)->getCoordinate().getCAR();
+    Vector n = cross(x1, x2);
+    double length = norm(n);
+    if (length < capEps)
+        return true;
+    double d = fabs(dot(point->getCoordinate().getCAR(), n))/length;
+    return asin(fmin(1.0, d))*Sphere::radius < distance;
+}
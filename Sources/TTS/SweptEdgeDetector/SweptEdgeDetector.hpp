@@ -0,0 +1,44 @@
+#ifndef SweptEdgeDetector_h
+#define SweptEdgeDetector_h
+
+class Vertex;
+class Edge;
+class PolygonManager;
+#include "Coordinate.hpp"
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// SweptEdgeDetector is the broad phase of the vertex-edge interactions during
+// one time step. Each edge is bounded by a spherical cap which covers the arcs
+// between its end points at the old and new time levels and the paths of the
+// end points, together with the new test point (the swept edge cap). The caps
+// are organized into a bounding volume hierarchy, so the edges that may meet a
+// vertex or a new arc can be found in O(log n) instead of walking the
+// neighbourhoods. The tree is queried by PotentialCrossDetector, and by
+// ApproachDetector for the candidate edges of the large polygons, while
+// mayApproach skips the projections of the vertices that are surely far from
+// the edges.
+//
+// Note: The edges that are created or changed after building (e.g. by
+//       splitEdge, mergeEdge and splitPolygon) are recorded by
+//       Edge::linkEndPoint, and they are checked with their current arcs.
+// Note: All the distances are in the same unit as Projection (i.e. with
+//       Sphere::radius).
+
+namespace SweptEdgeDetector
+{
+    void build(PolygonManager &polygonManager);
+
+    void clear();
+
+    bool isBuilt();
+
+    void recordEdge(Edge *edge);
+
+    void queryEdges(const Coordinate &x1, const Coordinate &x2,
+                    std::vector<Edge *> &edges, double distance = 0.0);
+
+    bool mayApproach(Vertex *point, Edge *edge, double distance);
+}
+
+#endif
@@ -5,6 +5,10 @@
 #include "Constants.hpp"
 #include "Sphere.hpp"
 #include "CurvatureGuard.hpp"
+#include "MeshValidator.hpp"
+#include "ConservationMonitor.hpp"
+#include "MetricsWriter.hpp"
+#include "ConfigTools.hpp"
 #ifdef TTS_REZONE
 #include "PolygonRezoner.hpp"
 #endif
@@ -26,6 +30,24 @@ void TTS::init()
 {
     CurvatureGuard::init();
     ApproachDetector::init();
+    MeshValidator::init();
+    MetricsWriter::init();
+    ConservationMonitor::init();
+#ifdef TTS_REMAP
+    // Note: The tracers are remapped onto the mesh when the densities are
+    //       needed (output and rezoning), and the alarm forces the remapping
+    //       on the other steps.
+    if (ConfigTools::hasKey("remap_frequency")) {
+        int frequency;
+        ConfigTools::read("remap_frequency", frequency);
+        TimeManager::setAlarm("tracer remapping", frequency);
+    }
+#ifdef DEBUG
+    // check the mass conservation of remapping on every step
+    else
+        TimeManager::setAlarm("tracer remapping", 1);
+#endif
+#endif
 #ifdef TTS_REZONE
     PolygonRezoner::init();
 #endif
@@ -93,23 +115,27 @@ void TTS::advect(MeshManager &meshManager,
     cout << "Total polygon number: " << setw(10);
     cout << polygonManager.polygons.size() << endl;
     tracerManager.update();
+    MeshValidator::check(polygonManager);
 #ifdef CHECK_AREA_BIAS
     DebugTools::assert_polygon_area_constant(polygonManager);
 #endif
 #ifdef TTS_REMAP
     // -------------------------------------------------------------------------
     // adapt the quantities carried by parcels (polygons)
-    // onto the background fixed mesh
-    meshAdaptor.adapt(tracerManager, meshManager);
-    for (int i = 0; i < tracerManager.getTracerNum(); ++i)
-        meshAdaptor.remap(tracerManager.getTracerName(i), tracerManager);
+    // onto the background fixed mesh when they are needed
+    tracerManager.setDensityStale(meshAdaptor, meshManager);
+    if (TimeManager::isAlarmed("tracer remapping"))
+        tracerManager.updateDensity();
 #endif
 #ifdef TTS_REZONE
-    if (TimeManager::isAlarmed("polygon rezoning")) {
+    if (PolygonRezoner::isTriggered(meshManager, tracerManager)) {
         PolygonRezoner::rezone(meshManager, meshAdaptor,
                                flowManager, tracerManager);
     }
+    PolygonRezoner::handover(meshManager, meshAdaptor,
+                             flowManager, tracerManager);
 #endif
+    ConservationMonitor::check(tracerManager);
     end = clock();
     cout << "[Timing]: TTS::advect: ";
     cout << setprecision(5) << (double)(end-start)/CLOCKS_PER_SEC << " seconds." << endl;
@@ -233,18 +233,20 @@ void Deformation::calcInitCond(MeshManager &meshManager,
     // -------------------------------------------------------------------------
     meshAdaptor.adapt(tracerManager, meshManager);
     // -------------------------------------------------------------------------
-    // remap the air density onto the polygons
-    meshAdaptor.remap("air density", qa, tracerManager);
-    // -------------------------------------------------------------------------
-    // remap the initial condition onto the polygons
-    for (int i = 0; i < numTracer; ++i)
-        meshAdaptor.remap(tracerNames[i], qt[i], tracerManager);
+    // remap the air density and the initial condition onto the polygons
+    vector<string> remapNames(1, "air density");
+    vector<const Field *> remapFields(1, &qa);
+    for (int i = 0; i < numTracer; ++i) {
+        remapNames.push_back(tracerNames[i]);
+        remapFields.push_back(&qt[i]);
+    }
+    meshAdaptor.remap(remapNames, remapFields, tracerManager);
     // -------------------------------------------------------------------------
 #ifdef DEBUG
     double totalPolygonMass = 0.0;
     Polygon *polygon = tracerManager.polygonManager.polygons.front();
     for (int i = 0; i < tracerManager.polygonManager.polygons.size(); ++i) {
-        totalPolygonMass += polygon->tracers[1].getMass();
+        totalPolygonMass += polygon->getTracerMass(1);
         polygon = polygon->next;
     }
     cout << "Total cell mass is    " << setprecision(20) << totalCellMass << endl;
@@ -252,11 +254,8 @@ void Deformation::calcInitCond(MeshManager &meshManager,
     cout << "Mass error is " << totalCellMass-totalPolygonMass << endl;
 #endif
     // -------------------------------------------------------------------------
-    // remap the air density onto the mesh that is used to analyze results
-    meshAdaptor.remap("air density", tracerManager);
-    // -------------------------------------------------------------------------
-    // remap the initial condition onto the mesh that is used to analyze results
-    for (int i = 0; i < numTracer; ++i)
-        meshAdaptor.remap(tracerNames[i], tracerManager);
+    // remap the air density and the initial condition onto the mesh that is
+    // used to analyze results
+    meshAdaptor.remap(tracerManager);
 }
 #endif
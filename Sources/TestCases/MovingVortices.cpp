@@ -142,7 +142,7 @@ void MovingVortices::calcInitCond(MeshManager &meshManager,
     double totalPolygonMass = 0.0;
     Polygon *polygon = tracerManager.polygonManager.polygons.front();
     for (int i = 0; i < tracerManager.polygonManager.polygons.size(); ++i) {
-        totalPolygonMass += polygon->tracers[0].getMass();
+        totalPolygonMass += polygon->getTracerMass(0);
         polygon = polygon->next;
     }
     cout << "Total cell mass is    " << setprecision(20) << totalCellMass << endl;
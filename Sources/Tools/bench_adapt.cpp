@@ -0,0 +1,100 @@
+#include "MeshManager.hpp"
+#include "TracerManager.hpp"
+#include "MeshAdaptor.hpp"
+#include "ReportMacros.hpp"
+#include "Constants.hpp"
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// bench_adapt measures the strong scaling of MeshAdaptor::adapt with the
+// parcels in a file written by PolygonManager::output, e.g.
+//   bench_adapt tts_df_00100.nc 360 180 8
+// where the mesh is 360x180 and the thread number goes from 1 up to 8.
+
+static double getWallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return static_cast<double>(clock())/CLOCKS_PER_SEC;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4) {
+        cout << "Usage: " << argv[0];
+        cout << " <polygon file> <num lon> <num lat> [max threads] [repeats]";
+        cout << endl;
+        return 1;
+    }
+    int numLon = atoi(argv[2]);
+    int numLat = atoi(argv[3]);
+    int maxNumThread = argc > 4 ? atoi(argv[4]) : 1;
+    int numRepeat = argc > 5 ? atoi(argv[5]) : 3;
+#ifndef _OPENMP
+    if (maxNumThread > 1)
+        REPORT_WARNING("OpenMP is not enabled, so only one thread is used.");
+    maxNumThread = 1;
+#endif
+    // -------------------------------------------------------------------------
+    MeshManager meshManager;
+    MeshAdaptor meshAdaptor;
+    TracerManager tracerManager;
+    double dlon = PI2/numLon;
+    double dlat = PI/(numLat+1);
+    double lon[numLon], lat[numLat];
+    for (int i = 0; i < numLon; ++i)
+        lon[i] = i*dlon;
+    for (int j = 0; j < numLat; ++j)
+        lat[j] = PI05-(j+1)*dlat;
+    meshManager.init(numLon, numLat, lon, lat);
+    meshAdaptor.init(meshManager);
+    PolygonManager &polygonManager = tracerManager.polygonManager;
+    polygonManager.init(argv[1]);
+    Vertex *vertex = polygonManager.vertices.front();
+    for (int i = 0; i < polygonManager.vertices.size(); ++i) {
+        Location loc;
+        meshManager.checkLocation(vertex->getCoordinate(), loc);
+        vertex->setLocation(loc);
+        vertex = vertex->next;
+    }
+    // -------------------------------------------------------------------------
+    double baseTime = 0.0;
+    cout << "Polygon number: " << polygonManager.polygons.size() << endl;
+    cout << setw(10) << "threads" << setw(15) << "seconds";
+    cout << setw(10) << "speedup" << setw(12) << "efficiency" << endl;
+    for (int numThread = 1; numThread <= maxNumThread; numThread *= 2) {
+#ifdef _OPENMP
+        omp_set_num_threads(numThread);
+#endif
+        // warm up the buffers
+        meshAdaptor.adapt(tracerManager, meshManager);
+        double start = getWallTime();
+        for (int k = 0; k < numRepeat; ++k)
+            meshAdaptor.adapt(tracerManager, meshManager);
+        double time = (getWallTime()-start)/numRepeat;
+        if (numThread == 1)
+            baseTime = time;
+        cout << setw(10) << numThread;
+        cout << setw(15) << setprecision(5) << time;
+        cout << setw(10) << setprecision(3) << baseTime/time;
+        cout << setw(12) << setprecision(3) << baseTime/time/numThread << endl;
+    }
+    // -------------------------------------------------------------------------
+    int numPolygon = polygonManager.polygons.size();
+    cout << "Polygons in single cell: " << setprecision(3);
+    cout << meshAdaptor.getNumPolygon(MeshAdaptor::SingleCellPath)*100.0/numPolygon;
+    cout << "%" << endl;
+    cout << "Polygons crossing cells: " << setprecision(3);
+    cout << meshAdaptor.getNumPolygon(MeshAdaptor::BoundaryPath)*100.0/numPolygon;
+    cout << "%" << endl;
+    cout << "Polygons covering cells: " << setprecision(3);
+    cout << meshAdaptor.getNumPolygon(MeshAdaptor::CoverPath)*100.0/numPolygon;
+    cout << "%" << endl;
+    return 0;
+}
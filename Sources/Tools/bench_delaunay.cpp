@@ -0,0 +1,114 @@
+#include "DelaunayDriver.hpp"
+#include "PointManager.hpp"
+#include "RandomNumber.hpp"
+#include "Sphere.hpp"
+#include "ReportMacros.hpp"
+#include "Constants.hpp"
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// bench_delaunay compares the incremental repair of Delaunay triangulation
+// (DelaunayDriver::moveVertices) with the full rebuild on random generators
+// that are moved like the Lloyd iterations of SCVT, e.g.
+//   bench_delaunay 1000000 0.1 5
+// where the generators are moved by 0.1 of the mean spacing in 5 iterations.
+// The triangulations are built in BRIO mode when the fourth argument is
+// "brio".
+
+static double getWallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return static_cast<double>(clock())/CLOCKS_PER_SEC;
+#endif
+}
+
+static void getRandomPoint(double &lon, double &lat)
+{
+    double x, y, z, r;
+    do {
+        x = RandomNumber::getRandomNumber(-1.0, 1.0);
+        y = RandomNumber::getRandomNumber(-1.0, 1.0);
+        z = RandomNumber::getRandomNumber(-1.0, 1.0);
+        r = x*x+y*y+z*z;
+    } while (r > 1.0 || r == 0.0);
+    r = sqrt(r);
+    Sphere::convertCAR(x/r, y/r, z/r, lon, lat);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        cout << "Usage: " << argv[0];
+        cout << " <num generator> [move ratio] [iterations] [brio]" << endl;
+        return 1;
+    }
+    int numPoint = atoi(argv[1]);
+    double ratio = argc > 2 ? atof(argv[2]) : 0.1;
+    int numIteration = argc > 3 ? atoi(argv[3]) : 5;
+    // -------------------------------------------------------------------------
+    vector<double> lon(numPoint), lat(numPoint);
+    RandomNumber::setRandomSeed();
+    for (int i = 0; i < numPoint; ++i)
+        getRandomPoint(lon[i], lat[i]);
+    PointManager pointManager;
+    pointManager.init(numPoint, &lon[0], &lat[0]);
+    DelaunayDriver driver;
+    if (argc > 4 && string(argv[4]) == "brio")
+        driver.setInsertMode(DelaunayDriver::BRIOMode);
+    driver.init(pointManager);
+    double start = getWallTime();
+    driver.reinit();
+    driver.run();
+    double buildTime = getWallTime()-start;
+    cout << "Generator number: " << numPoint << endl;
+    cout << "Initial triangulation: " << setprecision(5) << buildTime;
+    cout << " seconds" << endl;
+    // -------------------------------------------------------------------------
+    // Note: The displacement is relative to the mean generator spacing on the
+    //       unit sphere.
+    double displacement = ratio*sqrt(4.0*PI/numPoint);
+    double totalRepairTime = 0.0, totalBuildTime = 0.0;
+    cout << setw(10) << "iteration" << setw(15) << "repair" << setw(15);
+    cout << "rebuild" << setw(10) << "speedup" << setw(12) << "repaired" << endl;
+    for (int k = 0; k < numIteration; ++k) {
+        for (int i = 0; i < numPoint; ++i) {
+            Coordinate x;
+            x.setSPH(lon[i], lat[i]);
+            double dx = RandomNumber::getRandomNumber(-1.0, 1.0)*displacement;
+            double dy = RandomNumber::getRandomNumber(-1.0, 1.0)*displacement;
+            double dz = RandomNumber::getRandomNumber(-1.0, 1.0)*displacement;
+            double r = sqrt(pow(x.getX()+dx, 2.0)+pow(x.getY()+dy, 2.0)+
+                            pow(x.getZ()+dz, 2.0));
+            Sphere::convertCAR((x.getX()+dx)/r, (x.getY()+dy)/r,
+                               (x.getZ()+dz)/r, lon[i], lat[i]);
+        }
+        start = getWallTime();
+        bool isRepaired = driver.moveVertices(&lon[0], &lat[0]);
+        double repairTime = getWallTime()-start;
+        start = getWallTime();
+        driver.reinit();
+        driver.run();
+        buildTime = getWallTime()-start;
+        totalRepairTime += repairTime;
+        totalBuildTime += buildTime;
+        cout << setw(10) << k;
+        cout << setw(15) << setprecision(5) << repairTime;
+        cout << setw(15) << setprecision(5) << buildTime;
+        cout << setw(10) << setprecision(3) << buildTime/repairTime;
+        cout << setw(12) << (isRepaired ? "yes" : "no") << endl;
+    }
+    if (numIteration > 0) {
+        cout << "Average speedup: " << setprecision(3);
+        cout << totalBuildTime/totalRepairTime << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "PolygonManager.hpp"
+#include "MeshValidator.hpp"
+#include "ReportMacros.hpp"
+
+// -----------------------------------------------------------------------------
+// check_mesh validates the parcel meshes in the files written by
+// PolygonManager::output, e.g.
+//   check_mesh tts_df_00100.nc tts_df_00200.nc
+// and exits with 1 if any of them is invalid.
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <polygon file> ..." << endl;
+        return 1;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; ++i) {
+        PolygonManager polygonManager;
+        MeshValidator::Report report;
+        polygonManager.init(argv[i]);
+        cout << "File \"" << argv[i] << "\":" << endl;
+        if (!MeshValidator::validate(polygonManager, report))
+            status = 1;
+        report.dump();
+    }
+    return status;
+}
@@ -0,0 +1,60 @@
+#include "TracerBuffer.hpp"
+
+vector<vector<double> > TracerBuffer::masses;
+vector<vector<double> > TracerBuffer::densities;
+vector<double> TracerBuffer::areas;
+vector<int> TracerBuffer::freeSlots;
+int TracerBuffer::numSlot = 0;
+
+int TracerBuffer::addTracer()
+{
+    masses.push_back(vector<double>(numSlot, 0.0));
+    densities.push_back(vector<double>(numSlot, 0.0));
+    return getNumTracer()-1;
+}
+
+int TracerBuffer::acquireSlot()
+{
+    if (!freeSlots.empty()) {
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    for (int l = 0; l < getNumTracer(); ++l) {
+        masses[l].push_back(0.0);
+        densities[l].push_back(0.0);
+    }
+    areas.push_back(1.0);
+    return numSlot++;
+}
+
+void TracerBuffer::releaseSlot(int slot)
+{
+    clearSlot(slot);
+    freeSlots.push_back(slot);
+}
+
+void TracerBuffer::clearSlot(int slot)
+{
+    for (int l = 0; l < getNumTracer(); ++l) {
+        masses[l][slot] = 0.0;
+        densities[l][slot] = 0.0;
+    }
+    // Note: The area is not zero to avoid 0/0 in updateDensities.
+    areas[slot] = 1.0;
+}
+
+void TracerBuffer::updateDensities()
+{
+    if (numSlot == 0)
+        return;
+    const double *area = &areas[0];
+    for (int l = 0; l < getNumTracer(); ++l) {
+        const double *mass = &masses[l][0];
+        double *density = &densities[l][0];
+        // Note: This loop is contiguous and has no dependency, so it is
+        //       vectorized by the compiler.
+        for (int slot = 0; slot < numSlot; ++slot)
+            density[slot] = mass[slot]/area[slot];
+    }
+}
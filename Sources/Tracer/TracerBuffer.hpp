@@ -0,0 +1,62 @@
+#ifndef TracerBuffer_h
+#define TracerBuffer_h
+
+#include <vector>
+
+using std::vector;
+
+// -----------------------------------------------------------------------------
+// TracerBuffer stores the tracer masses and densities of all the polygons in
+// structure-of-arrays form ([tracer][slot]). Each polygon object takes a slot
+// when it is constructed and gives it back when it is deleted, so the slots
+// follow the object pool of List<Polygon> (the removed polygons keep their
+// slots in the pool and are cleared when they are reused), and the slots stay
+// dense. Registering a tracer only adds one array, and the densities of all
+// the polygons are updated in one contiguous pass per tracer.
+//
+// Note: The buffer is static, since the polygons in the pool are created
+//       before any TracerManager, and it is managed by TracerManager.
+
+class TracerBuffer
+{
+public:
+    static int getNumTracer() { return static_cast<int>(masses.size()); }
+    static int getNumSlot() { return numSlot; }
+
+    // Return the index of the new tracer.
+    static int addTracer();
+
+    static int acquireSlot();
+    static void releaseSlot(int slot);
+    static void clearSlot(int slot);
+
+    static double getMass(int tracerId, int slot) {
+        return masses[tracerId][slot];
+    }
+    static void setMass(int tracerId, int slot, double mass) {
+        masses[tracerId][slot] = mass;
+    }
+    static void addMass(int tracerId, int slot, double mass) {
+        masses[tracerId][slot] += mass;
+    }
+    static double getDensity(int tracerId, int slot) {
+        return densities[tracerId][slot];
+    }
+    static void setDensity(int tracerId, int slot, double density) {
+        densities[tracerId][slot] = density;
+    }
+    static void setArea(int slot, double area) { areas[slot] = area; }
+
+    // density = mass/area for all the tracers and slots, where the areas are
+    // set by setArea
+    static void updateDensities();
+
+private:
+    static vector<vector<double> > masses;
+    static vector<vector<double> > densities;
+    static vector<double> areas;
+    static vector<int> freeSlots;
+    static int numSlot;
+};
+
+#endif
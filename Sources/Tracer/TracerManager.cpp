@@ -1,10 +1,22 @@
 #include <netcdfcpp.h>
 
 #include "TracerManager.hpp"
-#include "Tracer.hpp"
+#include "TracerBuffer.hpp"
+#include "CompensatedSum.hpp"
+#ifdef TTS_ONLINE
+#include "ConservationMonitor.hpp"
+#endif
+#ifdef TTS_REMAP
+#include "MeshAdaptor.hpp"
+#endif
+#include <vector>
+
+using std::vector;
 
 TracerManager::TracerManager()
 {
+    staleAdaptor = NULL;
+    staleMeshManager = NULL;
     REPORT_ONLINE("TracerManager");
 }
 
@@ -56,11 +68,7 @@ void TracerManager::registerTracer(const string &tracerName,
 
     // -------------------------------------------------------------------------
     // set up tracer variables in polygons
-    Polygon *polygon = polygonManager.polygons.front();
-    for (int i = 0; i < polygonManager.polygons.size(); ++i) {
-        polygon->tracers.push_back(Tracer());
-        polygon = polygon->next;
-    }
+    addTracer();
 }
 
 void TracerManager::registerTracer(const string &fileName,
@@ -84,14 +92,10 @@ void TracerManager::registerTracer(const string &fileName,
         REPORT_ERROR(message.str());
     }
     tracerNames.push_back(file.get_att("name")->as_string(0));
-
-    if (file.get_att("name") == NULL) {
-        Message message;
-        message << "There is no \"name\" attribute in tracer file \"";
-        message << fileName << "\"!";
-        REPORT_ERROR(message.str());
-    }
-    tracerNames.push_back(file.get_att("name")->as_string(0));
+    if (file.get_att("units") != NULL)
+        tracerUnits.push_back(file.get_att("units")->as_string(0));
+    else
+        tracerUnits.push_back("");
 
     int numPolygon = static_cast<int>(file.get_dim("num_total_polygon")->size());
     if (numPolygon != polygonManager.polygons.size()) {
@@ -102,14 +106,14 @@ void TracerManager::registerTracer(const string &fileName,
         message << fileName << "\"!";
         REPORT_ERROR(message.str());
     }
-    double mass[numPolygon];
+    vector<double> mass(numPolygon);
     if (file.get_var("mass") == NULL) {
         Message message;
         message << "There is no \"mass\" variable in tracer file \"";
         message << fileName << "\"!";
         REPORT_ERROR(message.str());
     }
-    file.get_var("mass")->get(mass);
+    file.get_var("mass")->get(&mass[0], numPolygon);
     // -------------------------------------------------------------------------
     // initialize tracer density on the mesh
     tracerDensities.push_back(Field());
@@ -122,13 +126,17 @@ void TracerManager::registerTracer(const string &fileName,
                                     meshManager.getMesh(PointCounter::Bound));
     // -------------------------------------------------------------------------
     // set up tracer variables in polygons
-    int tracerId = static_cast<int>(tracerNames.size()-1);
+    int tracerId = addTracer();
+    CompensatedSum totalMass;
     Polygon *polygon = polygonManager.polygons.front();
     for (int i = 0; i < polygonManager.polygons.size(); ++i) {
-        polygon->tracers.push_back(Tracer());
-        polygon->tracers[tracerId].setMass(mass[i]);
+        polygon->setTracerMass(tracerId, mass[i]);
+        totalMass.add(mass[i]);
         polygon = polygon->next;
     }
+#ifdef TTS_ONLINE
+    ConservationMonitor::setMass(tracerId, totalMass.getSum());
+#endif
 }
 
 int TracerManager::getTracerId(const string &tracerName)
@@ -141,13 +149,54 @@ int TracerManager::getTracerId(const string &tracerName)
     REPORT_ERROR(message.str());
 }
 
+Field &TracerManager::getTracerDensityField(int tracerId)
+{
+    if (isDensityStale())
+        updateDensity();
+    return tracerDensities[tracerId];
+}
+
+void TracerManager::setDensityStale(MeshAdaptor &meshAdaptor,
+                                    const MeshManager &meshManager)
+{
+    staleAdaptor = &meshAdaptor;
+    staleMeshManager = &meshManager;
+}
+
+void TracerManager::updateDensity()
+{
+    if (!isDensityStale())
+        return;
+    // Note: The mark is cleared first, since the remapping will access the
+    //       density fields.
+    MeshAdaptor *meshAdaptor = staleAdaptor;
+    staleAdaptor = NULL;
+#ifdef TTS_REMAP
+    meshAdaptor->adapt(*this, *staleMeshManager);
+    meshAdaptor->remap(*this);
+#else
+    REPORT_ERROR("TTS_REMAP is not defined, so tracer densities can not be "
+                 "remapped onto the mesh!");
+#endif
+}
+
 void TracerManager::update()
 {
     Polygon *polygon = polygonManager.polygons.front();
     for (int i = 0; i < polygonManager.polygons.size(); ++i) {
-        polygon->updateTracers();
+        TracerBuffer::setArea(polygon->getTracerSlot(), polygon->getArea());
         polygon = polygon->next;
     }
+    TracerBuffer::updateDensities();
+}
+
+int TracerManager::addTracer()
+{
+    int tracerId = TracerBuffer::addTracer();
+#ifdef DEBUG
+    assert(tracerId == getTracerNum()-1);
+#endif
+    return tracerId;
 }
 
 void TracerManager::output(const string &fileName)
@@ -156,6 +205,7 @@ void TracerManager::output(const string &fileName)
     // output polygon stuffs
     polygonManager.output(fileName);
 #ifdef TTS_REMAP
+    updateDensity();
     // -------------------------------------------------------------------------
     NcFile file(fileName.c_str(), NcFile::Write);
     if (!file.is_valid()) {
@@ -167,24 +217,24 @@ void TracerManager::output(const string &fileName)
     // -------------------------------------------------------------------------
     // output tracer densities on the polygons
     NcDim *numPolygonDim = file.get_dim("num_total_polygon");
-    double q0[polygonManager.polygons.size()];
+    vector<double> q0(polygonManager.polygons.size());
     for (int l = 0; l < tracerNames.size(); ++l) {
         char varName[30];
         sprintf(varName, "q%d", l);
         NcVar *qVar = file.add_var(varName, ncDouble, numPolygonDim);
         Polygon *polygon = polygonManager.polygons.front();
         for (int i = 0; i < polygonManager.polygons.size(); ++i) {
-            q0[i] = polygon->tracers[l].getDensity();
+            q0[i] = polygon->getTracerDensity(l);
             polygon = polygon->next;
         }
-        qVar->put(q0, polygonManager.polygons.size());
+        qVar->put(&q0[0], polygonManager.polygons.size());
     }
     // -------------------------------------------------------------------------
     // output tracer densities on the mesh
     const RLLMesh &mesh = tracerDensities[0].getMesh();
     int numLon = mesh.getNumLon()-2;
     int numLat = mesh.getNumLat();
-    double lon[numLon], lat[numLat];
+    vector<double> lon(numLon), lat(numLat);
     for (int i = 0; i < numLon; ++i)
         lon[i] = mesh.lon(i+1)*Rad2Deg;
     for (int j = 0; j < numLat; ++j)
@@ -194,20 +244,21 @@ void TracerManager::output(const string &fileName)
     NcVar *lonVar = file.add_var("lon", ncDouble, lonDim);
     lonVar->add_att("long_name", "longitude");
     lonVar->add_att("units", "degrees_east");
-    lonVar->put(lon, numLon);
+    lonVar->put(&lon[0], numLon);
     NcVar *latVar = file.add_var("lat", ncDouble, latDim);
     latVar->add_att("long_name", "latitude");
     latVar->add_att("units", "degrees_north");
-    latVar->put(lat, numLat);
+    latVar->put(&lat[0], numLat);
     NcVar *areaVar = file.add_var("area_mesh", ncDouble, latDim, lonDim);
     areaVar->add_att("long_name", "area of fixed mesh cell");
     areaVar->add_att("units", "m2");
-    double area[numLat][numLon];
+    // Note: The mesh fields are stored with latitude first.
+    vector<double> area(numLat*numLon);
     for (int i = 0; i < numLon; ++i)
         for (int j = 0; j < numLat; ++j)
-            area[j][i] = tracerDensities[0].getMesh(Field::Bound).area(i, j);
-    areaVar->put(&area[0][0], numLat, numLon);
-    double q[numLat][numLon];
+            area[j*numLon+i] = tracerDensities[0].getMesh(Field::Bound).area(i, j);
+    areaVar->put(&area[0], numLat, numLon);
+    vector<double> q(numLat*numLon);
     for (int l = 0; l < tracerNames.size(); ++l) {
         char varName[30];
         sprintf(varName, "q%d_mesh", l);
@@ -215,8 +266,8 @@ void TracerManager::output(const string &fileName)
         qVar->add_att("long_name", tracerNames[l].c_str());
         for (int i = 0; i < numLon; ++i)
             for (int j = 0; j < numLat; ++j)
-                q[j][i] = tracerDensities[l].values(i+1, j, 0).getNew();
-        qVar->put(&q[0][0], numLat, numLon);
+                q[j*numLon+i] = tracerDensities[l].values(i+1, j, 0).getNew();
+        qVar->put(&q[0], numLat, numLon);
     }
     // -------------------------------------------------------------------------
     file.close();
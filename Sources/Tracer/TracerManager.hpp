@@ -5,6 +5,8 @@
 #include "PolygonManager.hpp"
 #include "Field.hpp"
 
+class MeshAdaptor;
+
 class TracerManager
 {
 public:
@@ -21,17 +23,32 @@ public:
     int getTracerNum() const { return static_cast<int>(tracerNames.size()); }
     const string &getTracerName(int tracerId) const { return tracerNames[tracerId]; }
     int getTracerId(const string &tracerName);
-    Field &getTracerDensityField(int tracerId) { return tracerDensities[tracerId]; }
+    Field &getTracerDensityField(int tracerId);
 
+    // update the tracer densities of all the polygons in one pass
     void update();
 
+    // Mark the tracer densities on the mesh as stale after the polygons have
+    // been moved, and they will be remapped by the given adaptor when they are
+    // needed (getTracerDensityField, output or updateDensity).
+    void setDensityStale(MeshAdaptor &meshAdaptor,
+                         const MeshManager &meshManager);
+    bool isDensityStale() const { return staleAdaptor != NULL; }
+    void updateDensity();
+
     void output(const string &fileName);
 
     PolygonManager polygonManager;
 
 private:
+    // add the tracer mass and density arrays of the polygons
+    int addTracer();
+
     vector<string> tracerNames, tracerUnits;
     vector<Field> tracerDensities;
+    // set when the tracer densities are stale
+    MeshAdaptor *staleAdaptor;
+    const MeshManager *staleMeshManager;
 };
 
 #endif
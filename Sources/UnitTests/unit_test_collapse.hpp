@@ -0,0 +1,67 @@
+#ifndef unit_test_collapse_h
+#define unit_test_collapse_h
+
+#include "EdgeCollapser.hpp"
+#include "RemapGrid.hpp"
+#include "Sphere.hpp"
+#include <cmath>
+
+// A polygon with 14 edges is surrounded by a ring of quadrilaterals, whose
+// outer vertices are fixed, and its edges should be collapsed until it is
+// under the limit of edge number without inverting any polygon.
+void test_collapseOverLimit()
+{
+    const int n = 14, maxNumEdge = 10;
+    const double r = 1.0/Rad2Deg;
+    vector<Vector> x(2*n);
+    for (int i = 0; i < n; ++i) {
+        double angle = PI2*i/n;
+        // Note: The radii are perturbed, so the edges are not equal.
+        double r0 = r*(1.0+0.05*sin(3.0*angle));
+        Sphere::convertSPH(r0*cos(angle), r0*sin(angle),
+                           x[i](0), x[i](1), x[i](2));
+        Sphere::convertSPH(2.0*r*cos(angle), 2.0*r*sin(angle),
+                           x[n+i](0), x[n+i](1), x[n+i](2));
+    }
+    vector<vector<int> > rings(n+1);
+    for (int i = 0; i < n; ++i) {
+        rings[0].push_back(i);
+        rings[i+1].push_back(i);
+        rings[i+1].push_back(n+i);
+        rings[i+1].push_back(n+(i+1)%n);
+        rings[i+1].push_back((i+1)%n);
+    }
+    vector<EdgeCollapser::Collapse> collapses;
+    int numCollapsed = EdgeCollapser::collapse(x, rings, n, maxNumEdge, 0.2,
+                                               collapses);
+    if (numCollapsed != n-maxNumEdge) {
+        Message message;
+        message << "The number of collapsed edges is " << numCollapsed;
+        message << " instead of " << n-maxNumEdge << "!";
+        REPORT_ERROR(message.str());
+    }
+    for (int k = 0; k < rings.size(); ++k) {
+        if (static_cast<int>(rings[k].size()) > maxNumEdge) {
+            Message message;
+            message << "Polygon " << k << " still has " << rings[k].size();
+            message << " edges!";
+            REPORT_ERROR(message.str());
+        }
+        vector<Vector> z(rings[k].size());
+        for (int i = 0; i < z.size(); ++i)
+            z[i] = x[rings[k][i]];
+        if (z.size() < 3 ||
+            RemapGrid::calcArea(&z[0], static_cast<int>(z.size())) <= 0.0) {
+            Message message;
+            message << "Polygon " << k << " is degenerated or inverted!";
+            REPORT_ERROR(message.str());
+        }
+    }
+    for (int c = 0; c < collapses.size(); ++c)
+        if (collapses[c].removed >= n) {
+            REPORT_ERROR("A fixed vertex is collapsed!");
+        }
+    cout << "test_collapseOverLimit: passed" << endl;
+}
+
+#endif
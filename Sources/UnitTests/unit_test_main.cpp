@@ -5,10 +5,16 @@
 #include "ReportMacros.hpp"
 #include "Constants.hpp"
 #include "unit_test_mesh.hpp"
+#include "unit_test_threshold.hpp"
+#include "unit_test_remap.hpp"
+#include "unit_test_collapse.hpp"
 
 using namespace std;
 
 int main(void)
 {
     test_checkLocation();
+    test_piecewiseCubic();
+    test_concaveRemap();
+    test_collapseOverLimit();
 }
\ No newline at end of file
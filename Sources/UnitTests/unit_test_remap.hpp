@@ -0,0 +1,99 @@
+#ifndef unit_test_remap_h
+#define unit_test_remap_h
+
+#include "RemapGrid.hpp"
+#include "Sphere.hpp"
+#include <cmath>
+
+// the point on the great circle arc from x1 to x2 at the given fraction
+inline Vector interpArc(const Vector &x1, const Vector &x2, double fraction)
+{
+    Vector x;
+    for (int i = 0; i < 3; ++i)
+        x(i) = (1.0-fraction)*x1(i)+fraction*x2(i);
+    return x/norm(x);
+}
+
+inline Vector convertDegree(double lon, double lat)
+{
+    Vector x;
+    Sphere::convertSPH(lon/Rad2Deg, lat/Rad2Deg, x(0), x(1), x(2));
+    return x;
+}
+
+// Remap the uniform density from four quadrilaterals onto an L-shaped (concave)
+// polygon and a quadrilateral that cover the same region, in the same way as
+// SupermeshRemapper (the targets are split into convex pieces, and the masses
+// are distributed by the overlap areas with partition of unity), so the mass
+// of each target should be its area.
+void test_concaveRemap()
+{
+    // the region
+    Vector A = convertDegree(0.0, 0.0), B = convertDegree(2.0, 0.0);
+    Vector C = convertDegree(2.0, 2.0), D = convertDegree(0.0, 2.0);
+    // the sources
+    Vector AB = interpArc(A, B, 0.5), BC = interpArc(B, C, 0.5);
+    Vector CD = interpArc(C, D, 0.5), DA = interpArc(D, A, 0.5);
+    Vector O = interpArc(AB, CD, 0.5);
+    const int numSource = 4;
+    Vector sources[numSource][4] = {
+        {A, AB, O, DA}, {AB, B, BC, O}, {O, BC, C, CD}, {DA, O, CD, D}
+    };
+    // the targets, where the first one is concave at F
+    Vector E = interpArc(B, C, 0.3), G = interpArc(D, C, 0.35);
+    Vector F = convertDegree(0.7, 0.6);
+    const int numTarget = 2;
+    Vector L[6] = {A, B, E, F, G, D};
+    Vector R[4] = {E, C, G, F};
+    const Vector *targets[numTarget] = {L, R};
+    int numTargetCorner[numTarget] = {6, 4};
+    if (RemapGrid::isConvex(L, 6)) {
+        REPORT_ERROR("The L-shaped polygon should be concave!");
+    }
+    // -------------------------------------------------------------------------
+    double overlaps[numSource][numTarget];
+    vector<Vector> pieces, ring1, ring2;
+    vector<int> pieceBegin;
+    for (int t = 0; t < numTarget; ++t) {
+        pieces.clear();
+        pieceBegin.assign(1, 0);
+        RemapGrid::splitConvex(targets[t], numTargetCorner[t],
+                               pieces, pieceBegin);
+        for (int s = 0; s < numSource; ++s) {
+            overlaps[s][t] = 0.0;
+            for (int m = 0; m < static_cast<int>(pieceBegin.size())-1; ++m)
+                overlaps[s][t] += RemapGrid::calcOverlapArea(
+                    sources[s], 4, &pieces[pieceBegin[m]],
+                    pieceBegin[m+1]-pieceBegin[m], ring1, ring2);
+        }
+    }
+    // -------------------------------------------------------------------------
+    double masses[numTarget] = {0.0, 0.0};
+    for (int s = 0; s < numSource; ++s) {
+        double area = RemapGrid::calcArea(sources[s], 4);
+        double totalArea = 0.0;
+        for (int t = 0; t < numTarget; ++t)
+            totalArea += overlaps[s][t];
+        if (fabs(totalArea-area) > 1.0e-10*area) {
+            Message message;
+            message << "The overlap areas of source " << s << " sum to ";
+            message << totalArea << " instead of " << area << "!";
+            REPORT_ERROR(message.str());
+        }
+        // Note: The density is one, so the mass is the area.
+        for (int t = 0; t < numTarget; ++t)
+            masses[t] += area*overlaps[s][t]/totalArea;
+    }
+    for (int t = 0; t < numTarget; ++t) {
+        double area = RemapGrid::calcArea(targets[t], numTargetCorner[t]);
+        if (fabs(masses[t]-area) > 1.0e-10*area) {
+            Message message;
+            message << "The remapped mass of target " << t << " is ";
+            message << masses[t] << " instead of " << area << "!";
+            REPORT_ERROR(message.str());
+        }
+    }
+    cout << "test_concaveRemap: passed" << endl;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef unit_test_threshold_h
+#define unit_test_threshold_h
+
+#include "ThresholdFunction.hpp"
+#include <cmath>
+#include <cfloat>
+
+void test_piecewiseCubic()
+{
+    // the angle thresholds in tts_config
+    const int n = 4;
+    double X[n] = {0.01, 0.5, 1.0, 4.0};
+    double Y[n] = {180.0, 60.0, 30.0, 1.0};
+
+    ThresholdFunction::PiecewiseCubic f;
+    f.init(n, X, Y);
+
+    // sample the whole range, the knots and their neighbours
+    const int numSample = 100000;
+    double x[numSample+4*n], y[numSample+4*n];
+    for (int i = 0; i < numSample; ++i)
+        x[i] = -1.0+6.0*i/(numSample-1);
+    for (int i = 0; i < n; ++i) {
+        x[numSample+4*i] = X[i];
+        x[numSample+4*i+1] = nextafter(X[i], -1.0e10);
+        x[numSample+4*i+2] = nextafter(X[i], 1.0e10);
+        x[numSample+4*i+3] = 0.5*(X[i]+X[i < n-1 ? i+1 : i]);
+    }
+    f.evaluate(numSample+4*n, x, y);
+
+    // Note: The batch and scalar paths compute the cube by multiplications
+    //       while piecewiseCubic uses pow, so they are compared with the
+    //       tolerance of a few ulps of the largest threshold.
+    double maxY = 0.0;
+    for (int i = 0; i < n; ++i)
+        maxY = fmax(maxY, fabs(Y[i]));
+    double tolerance = 8.0*DBL_EPSILON*maxY;
+    for (int i = 0; i < numSample+4*n; ++i) {
+        double y0 = ThresholdFunction::piecewiseCubic(n, X, Y, x[i]);
+        if (fabs(y[i]-y0) > tolerance || fabs(f(x[i])-y0) > tolerance) {
+            Message message;
+            message << "PiecewiseCubic differs from piecewiseCubic at " << x[i];
+            message << " (" << y[i] << ", " << f(x[i]) << " vs " << y0 << ")!";
+            REPORT_ERROR(message.str());
+        }
+    }
+    cout << "test_piecewiseCubic: passed" << endl;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CompensatedSum_h
+#define CompensatedSum_h
+
+#include <cmath>
+
+// -----------------------------------------------------------------------------
+// CompensatedSum accumulates doubles with the Kahan-Babuska (Neumaier)
+// algorithm, so the rounding error does not grow with the number of terms,
+// which is needed when a large total is updated by many small changes (e.g.
+// the total tracer mass during the mass handovers).
+
+class CompensatedSum
+{
+public:
+    CompensatedSum() { reset(); }
+
+    void reset(double value = 0.0) { sum = value; error = 0.0; }
+
+    void add(double value) {
+        double t = sum+value;
+        if (std::fabs(sum) >= std::fabs(value))
+            error += (sum-t)+value;
+        else
+            error += (value-t)+sum;
+        sum = t;
+    }
+
+    double getSum() const { return sum+error; }
+
+private:
+    double sum, error;
+};
+
+#endif
@@ -1,5 +1,9 @@
 #include "DebugTools.hpp"
 #include "Sphere.hpp"
+#ifdef TTS_ONLINE
+#include "ConservationMonitor.hpp"
+#include "CompensatedSum.hpp"
+#endif
 
 Vertex *DebugTools::watchedVertex;
 Edge *DebugTools::watchedEdge;
@@ -104,18 +108,25 @@ void DebugTools::assert_consistent_projection(const Projection *projection)
 
 void DebugTools::assert_polygon_mass_constant(const PolygonManager &polygonManager)
 {
-    double totalMass = 0.0;
+    // compare the total masses with the ones tracked by ConservationMonitor
     Polygon *polygon = polygonManager.polygons.front();
+    vector<CompensatedSum> totalMasses(TracerBuffer::getNumTracer());
     for (int i = 0; i < polygonManager.polygons.size(); ++i) {
-        if (polygon->tracers.size() != 0)
-            totalMass += polygon->tracers[0].getMass();
+        for (int l = 0; l < totalMasses.size(); ++l)
+            totalMasses[l].add(polygon->getTracerMass(l));
         polygon = polygon->next;
     }
-    double errorMass = (totalMass-385289464684828224.0)/totalMass;
-    if (fabs(errorMass) > 1.0e-12) {
-        Message message;
-        message << "Relative mass error (" << errorMass << ") is too large!";
-        REPORT_ERROR(message.str());
+    for (int l = 0; l < totalMasses.size(); ++l) {
+        double trueTotalMass = ConservationMonitor::getMass(l);
+        if (trueTotalMass == 0.0)
+            continue;
+        double errorMass = (totalMasses[l].getSum()-trueTotalMass)/trueTotalMass;
+        if (fabs(errorMass) > 1.0e-12) {
+            Message message;
+            message << "Relative mass error (" << errorMass << ") of tracer ";
+            message << l << " is too large!";
+            REPORT_ERROR(message.str());
+        }
     }
 }
 
@@ -150,7 +161,7 @@ void DebugTools::dump_watched_vertex()
     cout << "Coordinate:" << endl;
     watchedVertex->getCoordinate().dump();
     watchedVertex->dump();
-    std::list<Projection>::const_iterator it;
+    VertexAgent::ProjectionMap::const_iterator it;
     for (it = watchedVertex->detectAgent.getProjections().begin();
          it != watchedVertex->detectAgent.getProjections().end(); ++it) {
         const Projection *p = &(*it);
@@ -0,0 +1,54 @@
+#include "MetricsWriter.hpp"
+#include "TimeManager.hpp"
+#include "ConfigTools.hpp"
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+using std::endl;
+using std::setw;
+
+namespace MetricsWriter
+{
+    static string fileName = "metrics.txt";
+    static std::ofstream metrics;
+    // columns of the kinds, which are erased after being written
+    static std::map<string, string> descriptions;
+}
+
+using namespace MetricsWriter;
+
+void MetricsWriter::init()
+{
+    if (ConfigTools::hasKey("metrics_file"))
+        ConfigTools::read("metrics_file", fileName);
+}
+
+void MetricsWriter::describe(const string &kind, const string &columns)
+{
+    descriptions[kind] = columns;
+}
+
+std::ostream &MetricsWriter::record(const string &kind)
+{
+    if (!metrics.is_open()) {
+        metrics.open(fileName.c_str());
+        metrics << "# step  kind  ..." << endl;
+    }
+    std::map<string, string>::iterator it = descriptions.find(kind);
+    if (it != descriptions.end()) {
+        metrics << "# step  " << kind << "  " << it->second << endl;
+        descriptions.erase(it);
+    }
+    // Note: The format of the last record is not carried over.
+    metrics.unsetf(std::ios::floatfield);
+    metrics.precision(6);
+    metrics << setw(8) << TimeManager::getSteps() << "  " << kind << "  ";
+    return metrics;
+}
+
+void MetricsWriter::flush()
+{
+    if (metrics.is_open())
+        metrics.flush();
+}
@@ -0,0 +1,36 @@
+#ifndef MetricsWriter_h
+#define MetricsWriter_h
+
+#include <ostream>
+#include <string>
+
+using std::string;
+
+// -----------------------------------------------------------------------------
+// MetricsWriter keeps the metrics file that the monitors (ConservationMonitor,
+// QualityMonitor) append their records to, instead of stdout. Each record is
+// one line starting with the step and the kind of it, e.g.
+//       12  mass  ...
+//       12  quality  ...
+// and the columns of each kind are described by a comment line before its
+// first record. The file is opened when the first record is written.
+//
+// Configuration keys:
+//   metrics_file  metrics file name (metrics.txt)
+
+namespace MetricsWriter
+{
+    void init();
+
+    // describe the columns after the step and kind of the records of a kind
+    void describe(const string &kind, const string &columns);
+
+    // start a record of a kind on this step, and return the stream to write
+    // the rest of it (the caller ends the line)
+    std::ostream &record(const string &kind);
+
+    // flush the records of this step
+    void flush();
+}
+
+#endif
@@ -121,4 +121,37 @@ protected:
     T *value[TIMELEVEL];
 };
 
+// -----------------------------------------------------------------------------
+// InlineMultiTimeLevel keeps the time levels inside the object instead of on the
+// heap, so it needs no init and cannot be mirrored. It is used by the small
+// objects that are created and copied very often (e.g. projections).
+template <typename T, int TIMELEVEL>
+class InlineMultiTimeLevel
+{
+public:
+    InlineMultiTimeLevel() {}
+    ~InlineMultiTimeLevel() {}
+
+    void setOld(const T &value) { this->value[1] = value; }
+    const T &getOld() const { return value[1]; }
+
+    void setNew(const T &value) { this->value[0] = value; }
+    const T &getNew() const { return value[0]; }
+
+    void set(TimeLevel time, const T &value) { this->value[time] = value; }
+
+    void save() {
+        for (int i = TIMELEVEL-1; i > 0; --i)
+            value[i] = value[i-1];
+    }
+
+    void reset(const T &value) {
+        for (int i = 0; i < TIMELEVEL; ++i)
+            this->value[i] = value;
+    }
+
+protected:
+    T value[TIMELEVEL];
+};
+
 #endif
@@ -0,0 +1,367 @@
+#ifndef SmallVector_h
+#define SmallVector_h
+
+#include <cstddef>
+
+// -----------------------------------------------------------------------------
+// SmallVector stores the first NUMINLINE elements inside the object, and only
+// allocates from the heap when it grows beyond that. It is meant for the small
+// pointer-like containers that are touched in the inner loops of the approach
+// detector, where std::list costs one allocation per element.
+//
+// Note: The iterators are position based, so after erasing the element at an
+//       iterator, the iterator stands on the next element (just like the
+//       returned iterator of std::list::erase). Erasing elements before an
+//       iterator shifts it, so callers should not keep iterators across
+//       unrelated removals.
+template <class T, int NUMINLINE>
+class SmallVector
+{
+public:
+    class iterator;
+    class const_iterator;
+
+    SmallVector() {
+        elems = inlineElems;
+        numElem = 0;
+        capacity = NUMINLINE;
+    }
+    SmallVector(const SmallVector<T, NUMINLINE> &that) {
+        elems = inlineElems;
+        numElem = 0;
+        capacity = NUMINLINE;
+        *this = that;
+    }
+    ~SmallVector() {
+        if (elems != inlineElems)
+            delete [] elems;
+    }
+
+    int size() const { return numElem; }
+    bool empty() const { return numElem == 0; }
+
+    T &operator[](int i) { return elems[i]; }
+    const T &operator[](int i) const { return elems[i]; }
+
+    T &front() { return elems[0]; }
+    const T &front() const { return elems[0]; }
+    T &back() { return elems[numElem-1]; }
+    const T &back() const { return elems[numElem-1]; }
+
+    void reserve(int n) {
+        if (n <= capacity)
+            return;
+        int newCapacity = capacity;
+        while (newCapacity < n)
+            newCapacity *= 2;
+        T *newElems = new T[newCapacity];
+        for (int i = 0; i < numElem; ++i)
+            newElems[i] = elems[i];
+        if (elems != inlineElems)
+            delete [] elems;
+        elems = newElems;
+        capacity = newCapacity;
+    }
+
+    void push_back(const T &elem) {
+        if (numElem == capacity)
+            reserve(capacity*2);
+        elems[numElem++] = elem;
+    }
+
+    void insert(int i, const T &elem) {
+        if (numElem == capacity)
+            reserve(capacity*2);
+        for (int j = numElem; j > i; --j)
+            elems[j] = elems[j-1];
+        elems[i] = elem;
+        numElem++;
+    }
+
+    void erase(int i) {
+        for (int j = i; j < numElem-1; ++j)
+            elems[j] = elems[j+1];
+        numElem--;
+    }
+
+    iterator erase(iterator it) {
+        erase(it.pos);
+        return it;
+    }
+
+    // Remove all the elements that are equal to the given one.
+    void remove(const T &elem) {
+        int j = 0;
+        for (int i = 0; i < numElem; ++i)
+            if (!(elems[i] == elem))
+                elems[j++] = elems[i];
+        numElem = j;
+    }
+
+    // Return the position of the given element or -1 if it is not found.
+    int find(const T &elem) const {
+        for (int i = 0; i < numElem; ++i)
+            if (elems[i] == elem)
+                return i;
+        return -1;
+    }
+
+    // Note: The heap buffer (if any) is kept for reuse.
+    void clear() { numElem = 0; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, numElem); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, numElem); }
+
+    SmallVector<T, NUMINLINE> &operator=(const SmallVector<T, NUMINLINE> &that) {
+        if (this != &that) {
+            reserve(that.numElem);
+            for (int i = 0; i < that.numElem; ++i)
+                elems[i] = that.elems[i];
+            numElem = that.numElem;
+        }
+        return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    class iterator
+    {
+    public:
+        iterator() : owner(NULL), pos(0) {}
+        iterator(SmallVector<T, NUMINLINE> *owner, int pos)
+        : owner(owner), pos(pos) {}
+
+        T &operator*() const { return owner->elems[pos]; }
+        T *operator->() const { return &owner->elems[pos]; }
+
+        iterator &operator++() { ++pos; return *this; }
+        iterator operator++(int) { iterator res = *this; ++pos; return res; }
+
+        bool operator==(const iterator &that) const {
+            return owner == that.owner && pos == that.pos;
+        }
+        bool operator!=(const iterator &that) const {
+            return !(*this == that);
+        }
+
+        int getPosition() const { return pos; }
+
+    private:
+        friend class SmallVector<T, NUMINLINE>;
+        friend class const_iterator;
+
+        SmallVector<T, NUMINLINE> *owner;
+        int pos;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator() : owner(NULL), pos(0) {}
+        const_iterator(const SmallVector<T, NUMINLINE> *owner, int pos)
+        : owner(owner), pos(pos) {}
+        const_iterator(const iterator &it) : owner(it.owner), pos(it.pos) {}
+
+        const T &operator*() const { return owner->elems[pos]; }
+        const T *operator->() const { return &owner->elems[pos]; }
+
+        const_iterator &operator++() { ++pos; return *this; }
+        const_iterator operator++(int) {
+            const_iterator res = *this; ++pos; return res;
+        }
+
+        bool operator==(const const_iterator &that) const {
+            return owner == that.owner && pos == that.pos;
+        }
+        bool operator!=(const const_iterator &that) const {
+            return !(*this == that);
+        }
+
+        int getPosition() const { return pos; }
+
+    private:
+        const SmallVector<T, NUMINLINE> *owner;
+        int pos;
+    };
+
+private:
+    friend class iterator;
+    friend class const_iterator;
+
+    T inlineElems[NUMINLINE];
+    T *elems;
+    int numElem;
+    int capacity;
+};
+
+// -----------------------------------------------------------------------------
+// FlatMap keeps its keys contiguously in a SmallVector in insertion order, so
+// a lookup is a short linear scan without any pointer chasing. The values live
+// in slots that never move (inline ones first, then heap ones), so the pointer
+// returned by find or insert stays valid until that entry is erased, which
+// is what the holders of Projection pointers rely on.
+template <class KEY, class T, int NUMINLINE>
+class FlatMap
+{
+public:
+    class iterator;
+    class const_iterator;
+
+    FlatMap() {
+        for (int i = 0; i < NUMINLINE; ++i)
+            isSlotUsed[i] = false;
+    }
+    FlatMap(const FlatMap<KEY, T, NUMINLINE> &that) {
+        for (int i = 0; i < NUMINLINE; ++i)
+            isSlotUsed[i] = false;
+        *this = that;
+    }
+    ~FlatMap() { clear(); }
+
+    int size() const { return keys.size(); }
+    bool empty() const { return keys.empty(); }
+
+    T *find(const KEY &key) const {
+        int i = keys.find(key);
+        return i == -1 ? NULL : values[i];
+    }
+
+    // Note: The caller should make sure that the key is not in the map.
+    T *insert(const KEY &key, const T &value) {
+        T *slot = getFreeSlot();
+        *slot = value;
+        keys.push_back(key);
+        values.push_back(slot);
+        return slot;
+    }
+
+    iterator erase(iterator it) {
+        erase(it.pos);
+        return it;
+    }
+
+    void erase(const T *value) {
+        for (int i = 0; i < values.size(); ++i)
+            if (values[i] == value) {
+                erase(i);
+                return;
+            }
+    }
+
+    void clear() {
+        for (int i = 0; i < values.size(); ++i)
+            releaseSlot(values[i]);
+        keys.clear();
+        values.clear();
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, keys.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, keys.size()); }
+
+    FlatMap<KEY, T, NUMINLINE> &operator=(const FlatMap<KEY, T, NUMINLINE> &that) {
+        if (this != &that) {
+            clear();
+            for (int i = 0; i < that.keys.size(); ++i)
+                insert(that.keys[i], *that.values[i]);
+        }
+        return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    class iterator
+    {
+    public:
+        iterator() : owner(NULL), pos(0) {}
+        iterator(FlatMap<KEY, T, NUMINLINE> *owner, int pos)
+        : owner(owner), pos(pos) {}
+
+        T &operator*() const { return *owner->values[pos]; }
+        T *operator->() const { return owner->values[pos]; }
+
+        const KEY &getKey() const { return owner->keys[pos]; }
+
+        iterator &operator++() { ++pos; return *this; }
+        iterator operator++(int) { iterator res = *this; ++pos; return res; }
+
+        bool operator==(const iterator &that) const {
+            return owner == that.owner && pos == that.pos;
+        }
+        bool operator!=(const iterator &that) const {
+            return !(*this == that);
+        }
+
+    private:
+        friend class FlatMap<KEY, T, NUMINLINE>;
+        friend class const_iterator;
+
+        FlatMap<KEY, T, NUMINLINE> *owner;
+        int pos;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator() : owner(NULL), pos(0) {}
+        const_iterator(const FlatMap<KEY, T, NUMINLINE> *owner, int pos)
+        : owner(owner), pos(pos) {}
+        const_iterator(const iterator &it) : owner(it.owner), pos(it.pos) {}
+
+        const T &operator*() const { return *owner->values[pos]; }
+        const T *operator->() const { return owner->values[pos]; }
+
+        const KEY &getKey() const { return owner->keys[pos]; }
+
+        const_iterator &operator++() { ++pos; return *this; }
+        const_iterator operator++(int) {
+            const_iterator res = *this; ++pos; return res;
+        }
+
+        bool operator==(const const_iterator &that) const {
+            return owner == that.owner && pos == that.pos;
+        }
+        bool operator!=(const const_iterator &that) const {
+            return !(*this == that);
+        }
+
+    private:
+        const FlatMap<KEY, T, NUMINLINE> *owner;
+        int pos;
+    };
+
+private:
+    friend class iterator;
+    friend class const_iterator;
+
+    void erase(int i) {
+        releaseSlot(values[i]);
+        keys.erase(i);
+        values.erase(i);
+    }
+
+    T *getFreeSlot() {
+        for (int i = 0; i < NUMINLINE; ++i)
+            if (!isSlotUsed[i]) {
+                isSlotUsed[i] = true;
+                return &inlineSlots[i];
+            }
+        return new T;
+    }
+
+    void releaseSlot(T *slot) {
+        if (slot >= inlineSlots && slot < inlineSlots+NUMINLINE) {
+            isSlotUsed[slot-inlineSlots] = false;
+        } else {
+            delete slot;
+        }
+    }
+
+    SmallVector<KEY, NUMINLINE> keys;
+    SmallVector<T *, NUMINLINE> values;
+    T inlineSlots[NUMINLINE];
+    bool isSlotUsed[NUMINLINE];
+};
+
+#endif
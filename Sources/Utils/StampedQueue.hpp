@@ -0,0 +1,107 @@
+#ifndef StampedQueue_h
+#define StampedQueue_h
+
+#include <vector>
+#include <cstddef>
+
+// -----------------------------------------------------------------------------
+// StampedQueue is a work queue of object pointers kept in the order they are
+// pushed. Each object carries an integer stamp (the member given by STAMP)
+// which records the slot it takes in the queue, so that membership tests,
+// pushes and removals are O(1) without any searching or node allocation, and
+// the processing order does not depend on the object addresses.
+//
+// Note: A stamp is only trusted when the slot it names still holds the object,
+//       so clearing the queue starts a new epoch without touching the objects,
+//       and stale stamps from former epochs are harmless.
+// Note: Removed objects leave empty slots (NULL) behind, which are skipped by
+//       the callers and dropped when the queue gets empty.
+template <class T, int T::*STAMP>
+class StampedQueue
+{
+public:
+    StampedQueue() : head(0), numElem(0) {}
+
+    int size() const { return numElem; }
+    bool empty() const { return numElem == 0; }
+
+    bool contains(const T *elem) const {
+        int slot = elem->*STAMP;
+        return slot >= head && slot < static_cast<int>(slots.size()) &&
+               slots[slot] == elem;
+    }
+
+    // Return false if the object is already in the queue.
+    bool push(T *elem) {
+        if (contains(elem))
+            return false;
+        elem->*STAMP = static_cast<int>(slots.size());
+        slots.push_back(elem);
+        numElem++;
+        return true;
+    }
+
+    // Return false if the object is not in the queue.
+    bool remove(T *elem) {
+        if (!contains(elem))
+            return false;
+        slots[elem->*STAMP] = NULL;
+        elem->*STAMP = -1;
+        if (--numElem == 0)
+            clear();
+        return true;
+    }
+
+    // Move (or put) elem2 just in front of elem1. If elem1 is not in the queue,
+    // elem2 is moved to the end.
+    void moveBefore(T *elem1, T *elem2) {
+        if (elem1 == elem2)
+            return;
+        if (contains(elem2)) {
+            slots[elem2->*STAMP] = NULL;
+            numElem--;
+        }
+        if (!contains(elem1)) {
+            elem2->*STAMP = static_cast<int>(slots.size());
+            slots.push_back(elem2);
+            numElem++;
+            return;
+        }
+        numElem++;
+        int slot1 = elem1->*STAMP;
+        if (slot1 > head && slots[slot1-1] == NULL) {
+            slots[slot1-1] = elem2;
+            elem2->*STAMP = slot1-1;
+            return;
+        }
+        slots.insert(slots.begin()+slot1, elem2);
+        for (int i = slot1; i < static_cast<int>(slots.size()); ++i)
+            if (slots[i] != NULL)
+                slots[i]->*STAMP = i;
+    }
+
+    // Note: The queue should not be empty.
+    T *front() {
+        while (slots[head] == NULL)
+            head++;
+        return slots[head];
+    }
+
+    void clear() {
+        slots.clear();
+        head = 0;
+        numElem = 0;
+    }
+
+    // The slots are used for traversing the queue in order, and the empty
+    // ones should be skipped.
+    int getNumSlot() const { return static_cast<int>(slots.size()); }
+    T *getSlot(int i) const { return slots[i]; }
+
+private:
+    std::vector<T *> slots;
+    int head;
+    int numElem;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "SystemCalls.hpp"
 #include "ReportMacros.hpp"
 #include <cstdlib>
+#include <sys/resource.h>
 
 int SystemCalls::getNumFile(const std::string &dir)
 {
@@ -92,3 +93,16 @@ void SystemCalls::getFiles(const std::string &dir,
         fileNames.push_back(result.substr(prev_pos, pos-1-prev_pos));
     }
 }
+
+double SystemCalls::getPeakMemory()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+#ifdef __APPLE__
+    // Note: Darwin reports ru_maxrss in bytes and Linux in kilobytes.
+    return usage.ru_maxrss/1048576.0;
+#else
+    return usage.ru_maxrss/1024.0;
+#endif
+}
@@ -16,6 +16,9 @@ public:
     static void getFiles(const std::string &dir,
                          const std::string &filePattern,
                          std::vector<std::string> &fileNames);
+
+    // Return the high-water mark of the resident memory of the process in MB.
+    static double getPeakMemory();
 };
 
 #endif
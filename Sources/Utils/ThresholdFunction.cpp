@@ -29,4 +29,77 @@ double ThresholdFunction::piecewiseCubic(int n, const double *X,
                 double t = (x-X[i])/dX;
                 return dY*(4.0-3.0*t)*pow(t, 3.0)+Y[i];
             }
-}
\ No newline at end of file
+}
+
+// -----------------------------------------------------------------------------
+
+void ThresholdFunction::PiecewiseCubic::init(int n, const double *X,
+                                             const double *Y)
+{
+    // Note: The number of buckets is a few times of the sections, so that
+    //       the refinement in findSection takes one step for most cases.
+    static const int numBucketPerSection = 16;
+    this->X.assign(X, X+n);
+    this->Y.assign(Y, Y+n);
+    dX.resize(n);
+    dY.resize(n);
+    for (int i = 0; i < n-1; ++i) {
+        dX[i] = X[i+1]-X[i];
+        dY[i] = Y[i+1]-Y[i];
+    }
+    dX[n-1] = 1.0;
+    dY[n-1] = 0.0;
+    double width = X[n-1]-X[0];
+    if (n < 2 || width <= 0.0) {
+        // all the abscissae are outside of the sections
+        sections.assign(1, 0);
+        bucketScale = 0.0;
+        return;
+    }
+    int numBucket = numBucketPerSection*(n-1);
+    bucketScale = numBucket/width;
+    sections.resize(numBucket);
+    int i = 0;
+    for (int k = 0; k < numBucket; ++k) {
+        double x = X[0]+k*width/numBucket;
+        while (i < n-2 && x >= X[i+1]) ++i;
+        sections[k] = i;
+    }
+}
+
+void ThresholdFunction::PiecewiseCubic::evaluate(int n, const double *x,
+                                                 double *y) const
+{
+    static const int blockSize = 256;
+    // the coefficients of the sections of a block of abscissae
+    double X0[blockSize], Y0[blockSize], dX0[blockSize], dY0[blockSize];
+    int numKnot = static_cast<int>(X.size());
+    for (int j0 = 0; j0 < n; j0 += blockSize) {
+        int m = n-j0 < blockSize ? n-j0 : blockSize;
+        const double *xb = x+j0;
+        double *yb = y+j0;
+        // Note: The abscissae before X[0] are in the first section, and the
+        //       ones after X[n-1] are in the sentinel section. The sections
+        //       are selected by blending instead of indexing the knots, so
+        //       that the loops are vectorized without gathering.
+        for (int j = 0; j < m; ++j) {
+            X0[j] = X[0]; Y0[j] = Y[0]; dX0[j] = dX[0]; dY0[j] = dY[0];
+        }
+        for (int k = 1; k < numKnot; ++k) {
+            double Xk = X[k], Yk = Y[k], dXk = dX[k], dYk = dY[k];
+            for (int j = 0; j < m; ++j) {
+                bool isAfter = xb[j] >= Xk;
+                X0[j] = isAfter ? Xk : X0[j];
+                Y0[j] = isAfter ? Yk : Y0[j];
+                dX0[j] = isAfter ? dXk : dX0[j];
+                dY0[j] = isAfter ? dYk : dY0[j];
+            }
+        }
+        for (int j = 0; j < m; ++j) {
+            double t = (xb[j]-X0[j])/dX0[j];
+            t = t < 0.0 ? 0.0 : t;
+            t = t > 1.0 ? 1.0 : t;
+            yb[j] = dY0[j]*(4.0-3.0*t)*(t*t*t)+Y0[j];
+        }
+    }
+}
@@ -1,10 +1,69 @@
 #ifndef ThresholdFunction_h
 #define ThresholdFunction_h
 
+#include <vector>
+
 namespace ThresholdFunction {
     double piecewiseLinear(int n, const double *X, const double *Y, double x);
 
     double piecewiseCubic(int n, const double *X, const double *Y, double x);
+
+    // -------------------------------------------------------------------------
+    // PiecewiseCubic is the compiled form of piecewiseCubic. The section of x
+    // is found from a dense table over the uniform buckets of [X[0],X[n-1]]
+    // with at most a few steps of refinement. The batch evaluation is
+    // branch-free instead: the sections of a block of abscissae are selected
+    // by comparing with each knot (there are only a few), and then the cubic
+    // is evaluated with t clamped into [0,1], where the last knot is a
+    // sentinel section with zero increment. Both paths compute the cube by
+    // multiplications instead of pow in piecewiseCubic, so they are not
+    // bit-identical to it, but differ within a few ulps of the thresholds.
+    class PiecewiseCubic
+    {
+    public:
+        PiecewiseCubic() {}
+        ~PiecewiseCubic() {}
+
+        void init(int n, const double *X, const double *Y);
+
+        inline double operator()(double x) const;
+
+        // evaluate the thresholds for n abscissae in one pass
+        void evaluate(int n, const double *x, double *y) const;
+
+    private:
+        inline int findSection(double x) const;
+
+        // dX and dY are the increments of the sections (the last ones are
+        // the sentinel)
+        std::vector<double> X, Y, dX, dY;
+        std::vector<int> sections;
+        double bucketScale;
+    };
+
+    // -------------------------------------------------------------------------
+
+    inline int PiecewiseCubic::findSection(double x) const
+    {
+        int k = static_cast<int>((x-X[0])*bucketScale);
+        if (k >= static_cast<int>(sections.size()))
+            k = static_cast<int>(sections.size())-1;
+        int i = sections[k];
+        while (x >= X[i+1]) ++i;
+        while (x < X[i]) --i;
+        return i;
+    }
+
+    inline double PiecewiseCubic::operator()(double x) const
+    {
+        if (x < X[0])
+            return Y[0];
+        else if (x >= X.back())
+            return Y.back();
+        int i = findSection(x);
+        double t = (x-X[i])/dX[i];
+        return dY[i]*(4.0-3.0*t)*(t*t*t)+Y[i];
+    }
 }
 
 #endif